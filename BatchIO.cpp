@@ -0,0 +1,101 @@
+#include "BatchIO.hpp"
+#include <cstring>
+
+BatchIO::BatchIO(int batchSize, size_t rxBufferSize, size_t payloadSize)
+    : capacity(batchSize > 0 ? batchSize : 1), bufferSize(rxBufferSize),
+      txPackets(capacity, ICMPPacket(payloadSize)), txAddrs(capacity), txIov(capacity), txMsgs(capacity),
+      rxBuffers(capacity * rxBufferSize), rxControl(capacity * TIMESTAMP_CONTROL_SIZE),
+      rxAddrs(capacity), rxIov(capacity), rxMsgs(capacity), rxStamps(capacity) {
+    for (int i = 0; i < capacity; i++) {
+        memset(&txAddrs[i], 0, sizeof(txAddrs[i]));
+        memset(&txMsgs[i], 0, sizeof(txMsgs[i]));
+        txIov[i].iov_base = const_cast<void*>(txPackets[i].getData());
+        txIov[i].iov_len = txPackets[i].getSize();
+        txMsgs[i].msg_hdr.msg_name = &txAddrs[i];
+        txMsgs[i].msg_hdr.msg_namelen = sizeof(txAddrs[i]);
+        txMsgs[i].msg_hdr.msg_iov = &txIov[i];
+        txMsgs[i].msg_hdr.msg_iovlen = 1;
+
+        memset(&rxMsgs[i], 0, sizeof(rxMsgs[i]));
+        rxIov[i].iov_base = &rxBuffers[i * bufferSize];
+        rxIov[i].iov_len = bufferSize;
+        rxMsgs[i].msg_hdr.msg_iov = &rxIov[i];
+        rxMsgs[i].msg_hdr.msg_iovlen = 1;
+    }
+}
+
+int BatchIO::getCapacity() const {
+    return capacity;
+}
+
+ICMPPacket& BatchIO::packet(int index) {
+    return txPackets[index];
+}
+
+void BatchIO::setDestination(int index, const struct sockaddr_in& addr) {
+    txAddrs[index] = addr;
+}
+
+const struct sockaddr_in& BatchIO::destination(int index) const {
+    return txAddrs[index];
+}
+
+int BatchIO::sendBatch(int sockfd, int count) {
+    if (count > capacity) count = capacity;
+    return sendmmsg(sockfd, &txMsgs[0], count, 0);
+}
+
+int BatchIO::receiveBatch(int sockfd, int flags) {
+    for (int i = 0; i < capacity; i++) {
+        // recvmmsg() rewrites the name and control lengths, so reset them each time
+        struct msghdr& hdr = rxMsgs[i].msg_hdr;
+        hdr.msg_name = &rxAddrs[i];
+        hdr.msg_namelen = sizeof(rxAddrs[i]);
+        hdr.msg_control = &rxControl[i * TIMESTAMP_CONTROL_SIZE];
+        hdr.msg_controllen = TIMESTAMP_CONTROL_SIZE;
+        hdr.msg_flags = 0;
+    }
+
+    int received = recvmmsg(sockfd, &rxMsgs[0], capacity, flags, nullptr);
+    if (received <= 0) {
+        return received;
+    }
+
+    struct timespec now = monotonicNow();
+    for (int i = 0; i < received; i++) {
+        rxStamps[i].mono = now;
+        readTimestampControl(&rxMsgs[i].msg_hdr, rxStamps[i]);
+    }
+
+    return received;
+}
+
+const char* BatchIO::data(int index) const {
+    return &rxBuffers[index * bufferSize];
+}
+
+int BatchIO::length(int index) const {
+    return (int)rxMsgs[index].msg_len;
+}
+
+const struct sockaddr_in& BatchIO::source(int index) const {
+    return rxAddrs[index];
+}
+
+const RecvStamp& BatchIO::stamp(int index) const {
+    return rxStamps[index];
+}
+
+char* BatchIO::buffer(int index) {
+    return &rxBuffers[index * bufferSize];
+}
+
+size_t BatchIO::getBufferSize() const {
+    return bufferSize;
+}
+
+void BatchIO::setReceived(int index, int length, const struct sockaddr_in& from, const RecvStamp& recvStamp) {
+    rxMsgs[index].msg_len = (unsigned int)length;
+    rxAddrs[index] = from;
+    rxStamps[index] = recvStamp;
+}
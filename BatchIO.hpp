@@ -0,0 +1,53 @@
+#ifndef BATCH_IO_HPP
+#define BATCH_IO_HPP
+
+#include "ICMPPacket.hpp"
+#include "Timestamp.hpp"
+#include <vector>
+#include <sys/socket.h>
+#include <netinet/in.h>
+
+// Reusable sendmmsg()/recvmmsg() arrays for the high-rate paths. Everything
+// is allocated once up front; a batch moves up to getCapacity() packets in
+// one syscall each way.
+class BatchIO {
+private:
+    int capacity;
+    size_t bufferSize;
+
+    std::vector<ICMPPacket> txPackets;
+    std::vector<struct sockaddr_in> txAddrs;
+    std::vector<struct iovec> txIov;
+    std::vector<struct mmsghdr> txMsgs;
+
+    std::vector<char> rxBuffers;
+    std::vector<char> rxControl;
+    std::vector<struct sockaddr_in> rxAddrs;
+    std::vector<struct iovec> rxIov;
+    std::vector<struct mmsghdr> rxMsgs;
+    std::vector<RecvStamp> rxStamps;
+
+public:
+    BatchIO(int batchSize = 64, size_t rxBufferSize = 1024,
+            size_t payloadSize = ICMPPacket::DEFAULT_PAYLOAD_SIZE);
+
+    int getCapacity() const;
+
+    ICMPPacket& packet(int index);
+    void setDestination(int index, const struct sockaddr_in& addr);
+    const struct sockaddr_in& destination(int index) const;
+    int sendBatch(int sockfd, int count);
+
+    int receiveBatch(int sockfd, int flags);
+    const char* data(int index) const;
+    int length(int index) const;
+    const struct sockaddr_in& source(int index) const;
+    const RecvStamp& stamp(int index) const;
+
+    // For transports without a socket: fill receive slot index directly
+    char* buffer(int index);
+    size_t getBufferSize() const;
+    void setReceived(int index, int length, const struct sockaddr_in& from, const RecvStamp& recvStamp);
+};
+
+#endif
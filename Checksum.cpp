@@ -0,0 +1,125 @@
+#include "Checksum.hpp"
+#include <cstring>
+#include <stdint.h>
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <immintrin.h>
+#define CHECKSUM_HAVE_X86 1
+#endif
+
+// Below this the vector setup costs more than it saves
+static const size_t VECTOR_THRESHOLD = 256;
+
+static unsigned short fold(uint64_t sum) {
+    sum = (sum & 0xFFFFFFFFULL) + (sum >> 32);
+    sum = (sum & 0xFFFFFFFFULL) + (sum >> 32);
+    sum = (sum & 0xFFFF) + (sum >> 16);
+    sum = (sum & 0xFFFF) + (sum >> 16);
+    sum = (sum & 0xFFFF) + (sum >> 16);
+    return (unsigned short)sum;
+}
+
+// Summing 32-bit words into a 64-bit accumulator gives the same folded
+// result as summing 16-bit words, with half the additions.
+static uint64_t sumScalar(const unsigned char* data, size_t length) {
+    uint64_t sum = 0;
+
+    while (length >= 4) {
+        uint32_t word;
+        memcpy(&word, data, 4);
+        sum += word;
+        data += 4;
+        length -= 4;
+    }
+    if (length >= 2) {
+        uint16_t half;
+        memcpy(&half, data, 2);
+        sum += half;
+        data += 2;
+        length -= 2;
+    }
+    if (length) {
+        // Odd trailing byte is padded with zero on its right (RFC 1071)
+        uint16_t last = 0;
+        memcpy(&last, data, 1);
+        sum += last;
+    }
+    return sum;
+}
+
+#ifdef CHECKSUM_HAVE_X86
+
+// Each 16-byte block is widened from four 32-bit words to 64-bit lanes, so
+// the accumulators cannot overflow for any IPv4-sized buffer.
+static uint64_t sumSse2(const unsigned char* data, size_t length) {
+    __m128i zero = _mm_setzero_si128();
+    __m128i acc = _mm_setzero_si128();
+
+    size_t blocks = length / 16;
+    for (size_t i = 0; i < blocks; i++) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(data + i * 16));
+        acc = _mm_add_epi64(acc, _mm_unpacklo_epi32(v, zero));
+        acc = _mm_add_epi64(acc, _mm_unpackhi_epi32(v, zero));
+    }
+
+    uint64_t lanes[2];
+    _mm_storeu_si128((__m128i*)lanes, acc);
+    return lanes[0] + lanes[1] + sumScalar(data + blocks * 16, length - blocks * 16);
+}
+
+__attribute__((target("avx2")))
+static uint64_t sumAvx2(const unsigned char* data, size_t length) {
+    __m256i zero = _mm256_setzero_si256();
+    __m256i acc0 = _mm256_setzero_si256();
+    __m256i acc1 = _mm256_setzero_si256();
+
+    size_t blocks = length / 32;
+    for (size_t i = 0; i < blocks; i++) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(data + i * 32));
+        acc0 = _mm256_add_epi64(acc0, _mm256_unpacklo_epi32(v, zero));
+        acc1 = _mm256_add_epi64(acc1, _mm256_unpackhi_epi32(v, zero));
+    }
+
+    uint64_t lanes[4];
+    _mm256_storeu_si256((__m256i*)lanes, _mm256_add_epi64(acc0, acc1));
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3] +
+           sumScalar(data + blocks * 32, length - blocks * 32);
+}
+
+typedef uint64_t (*SumKernel)(const unsigned char*, size_t);
+
+static SumKernel selectKernel() {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") ? sumAvx2 : sumSse2;
+}
+
+#endif
+
+unsigned short internetChecksum(const void* data, size_t length) {
+    const unsigned char* bytes = (const unsigned char*)data;
+    uint64_t sum;
+
+#ifdef CHECKSUM_HAVE_X86
+    if (length >= VECTOR_THRESHOLD) {
+        static const SumKernel kernel = selectKernel();
+        sum = kernel(bytes, length);
+    } else {
+        sum = sumScalar(bytes, length);
+    }
+#else
+    sum = sumScalar(bytes, length);
+#endif
+
+    return (unsigned short)~fold(sum);
+}
+
+unsigned short checksumUpdate(unsigned short checksum, unsigned short oldWord,
+                              unsigned short newWord) {
+    // HC' = ~(~HC + ~m + m'), RFC 1624 eqn. 3
+    uint32_t sum = (uint16_t)~checksum;
+    sum += (uint16_t)~oldWord;
+    sum += newWord;
+    sum = (sum & 0xFFFF) + (sum >> 16);
+    sum = (sum & 0xFFFF) + (sum >> 16);
+    return (unsigned short)~sum;
+}
@@ -0,0 +1,16 @@
+#ifndef CHECKSUM_HPP
+#define CHECKSUM_HPP
+
+#include <cstddef>
+
+// RFC 1071 Internet checksum. Large buffers go through an SSE2 or AVX2
+// kernel (picked once at runtime); small ones use the scalar loop.
+unsigned short internetChecksum(const void* data, size_t length);
+
+// RFC 1624 incremental update: the checksum after one 16-bit word of the
+// covered data changes from oldWord to newWord. Words are in the same
+// (memory) byte order the checksum was computed over.
+unsigned short checksumUpdate(unsigned short checksum, unsigned short oldWord,
+                              unsigned short newWord);
+
+#endif
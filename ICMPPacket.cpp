@@ -1,58 +1,92 @@
 #include "ICMPPacket.hpp"
+#include "Checksum.hpp"
 #include "utils.hpp"
 #include <cstring>
 #include <iostream>
 #include <iomanip>
 
-
-unsigned short ICMPPacket::calculateChecksum(void* buffer, int length) {
-    unsigned short* buf = (unsigned short*)buffer;
-    unsigned int sum = 0;
+template <size_t PayloadSize>
+void ICMPPacket::loadImage() {
+    typedef BasicICMPPacket<PayloadSize> Fixed;
+    const unsigned char* image = Fixed::IMAGE.bytes;
+    unsigned short id = (unsigned short)getpid();
     
-    for (int i = 0; i < length / 2; i++) {
-        sum += buf[i];
+    buffer.assign(image, image + Fixed::SIZE);
+    header()->un.echo.id = id;
+    header()->checksum = Fixed::baseChecksum(id);
+}
+
+ICMPPacket::ICMPPacket(size_t payloadSize) {
+    switch (payloadSize) {
+        case DEFAULT_PAYLOAD_SIZE: loadImage<DEFAULT_PAYLOAD_SIZE>(); return;
+        case ETHERNET_PAYLOAD_SIZE: loadImage<ETHERNET_PAYLOAD_SIZE>(); return;
+        case JUMBO_PAYLOAD_SIZE: loadImage<JUMBO_PAYLOAD_SIZE>(); return;
+        default: break;
     }
     
-    if (length % 2) {
-        sum += *((unsigned char*)buf + length - 1);
+    buffer.resize(sizeof(struct icmphdr) + (payloadSize < MAX_PAYLOAD_SIZE ? payloadSize : MAX_PAYLOAD_SIZE));
+    struct icmphdr* hdr = header();
+    hdr->type = ICMP_ECHO;
+    hdr->code = 0;
+    hdr->un.echo.id = getpid();
+    hdr->un.echo.sequence = 0;
+    
+    for (size_t i = sizeof(struct icmphdr); i < buffer.size(); i++) {
+        buffer[i] = SequentialFill::at(i - sizeof(struct icmphdr));
     }
     
-    sum = (sum >> 16) + (sum & 0xFFFF);
-    sum += (sum >> 16);
+    hdr->checksum = 0;
+    hdr->checksum = internetChecksum(&buffer[0], buffer.size());
+}
+
+struct icmphdr* ICMPPacket::header() {
+    return (struct icmphdr*)&buffer[0];
+}
+
+const struct icmphdr* ICMPPacket::header() const {
+    return (const struct icmphdr*)&buffer[0];
+}
+
+void ICMPPacket::build(int sequenceNumber) {
+    struct icmphdr* hdr = header();
+    unsigned short sequence = (unsigned short)sequenceNumber;
     
-    return (unsigned short)(~sum);
+    hdr->checksum = checksumUpdate(hdr->checksum, hdr->un.echo.sequence, sequence);
+    hdr->un.echo.sequence = sequence;
 }
 
-ICMPPacket::ICMPPacket() {
-    memset(&packet, 0, sizeof(packet));
+void ICMPPacket::setId(unsigned short id) {
+    struct icmphdr* hdr = header();
+    hdr->checksum = checksumUpdate(hdr->checksum, hdr->un.echo.id, id);
+    hdr->un.echo.id = id;
 }
 
 void ICMPPacket::prepare(int sequenceNumber) {
-    packet.header.type = ICMP_ECHO;
-    packet.header.code = 0;
-    packet.header.un.echo.id = getpid();
-    packet.header.un.echo.sequence = sequenceNumber;
-    
-    for (int i = 0; i < 56; i++) {
-        packet.data[i] = i + 0x20;
-    }
-    
-    packet.header.checksum = 0;
-    packet.header.checksum = calculateChecksum(&packet, sizeof(packet));
+    build(sequenceNumber);
     
     printInfo("ICMP Type", "Echo Request (8)");
     printInfo("ICMP Code", 0);
-    printInfo("Process ID", getpid());
+    printInfo("Process ID", getId());
     printInfo("Sequence Number", sequenceNumber);
     
     std::cout << "  Checksum                 : 0x" << std::hex << std::setw(4) 
-              << std::setfill('0') << packet.header.checksum << std::dec 
+              << std::setfill('0') << header()->checksum << std::dec 
               << std::setfill(' ') << std::endl; // <-- Reset fill char
     
-    printInfo("Payload Size", 56);
-    printInfo("Total Packet Size", (int)sizeof(packet));
+    printInfo("Payload Size", (int)getPayloadSize());
+    printInfo("Total Packet Size", (int)getSize());
 }
 
-const void* ICMPPacket::getData() const { return &packet; }
-size_t ICMPPacket::getSize() const { return sizeof(packet); }
-int ICMPPacket::getId() const { return packet.header.un.echo.id; }
+const void* ICMPPacket::getData() const { return &buffer[0]; }
+size_t ICMPPacket::getSize() const { return buffer.size(); }
+size_t ICMPPacket::getPayloadSize() const { return buffer.size() - sizeof(struct icmphdr); }
+int ICMPPacket::getId() const { return header()->un.echo.id; }
+
+bool ICMPPacket::isPrecompiled(size_t payloadSize) {
+    return payloadSize == DEFAULT_PAYLOAD_SIZE || payloadSize == ETHERNET_PAYLOAD_SIZE ||
+           payloadSize == JUMBO_PAYLOAD_SIZE;
+}
+
+size_t ICMPPacket::getReplyBufferSize(size_t payloadSize) {
+    return 60 + sizeof(struct icmphdr) + payloadSize;
+}
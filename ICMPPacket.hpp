@@ -4,25 +4,151 @@
 #include <sys/socket.h>
 #include <netinet/ip.h>
 #include <netinet/ip_icmp.h>
+#include <arpa/inet.h>
 #include <unistd.h>
 #include <cstddef> // for size_t
+#include <cstring>
+#include <vector>
 
+// Payload fill patterns; at(i) must be constexpr so whole packets can be
+// laid out by the compiler
+struct SequentialFill {
+    static constexpr unsigned char at(size_t i) { return (unsigned char)(i + 0x20); }
+};
+
+struct ZeroFill {
+    static constexpr unsigned char at(size_t) { return 0; }
+};
+
+// C++11 stand-in for std::index_sequence, generated in log depth so the
+// 8972-byte jumbo payload stays far below the template depth limit
+template <size_t... I> struct IndexSequence {};
+
+template <class A, class B> struct ConcatIndices;
+template <size_t... A, size_t... B>
+struct ConcatIndices<IndexSequence<A...>, IndexSequence<B...> > {
+    typedef IndexSequence<A..., (sizeof...(A) + B)...> type;
+};
+
+template <size_t N> struct MakeIndices
+    : ConcatIndices<typename MakeIndices<N / 2>::type, typename MakeIndices<N - N / 2>::type> {};
+template <> struct MakeIndices<0> { typedef IndexSequence<> type; };
+template <> struct MakeIndices<1> { typedef IndexSequence<0> type; };
+
+// Folds a ones'-complement accumulator to 16 bits (not inverted)
+inline constexpr unsigned short foldChecksum(unsigned long long sum) {
+    return sum >> 16 ? foldChecksum((sum & 0xFFFF) + (sum >> 16)) : (unsigned short)sum;
+}
+
+// Echo Request with the payload size and fill pattern fixed at compile time.
+// The packet bytes and the payload's checksum contribution are constants;
+// only the ICMP id (the pid) is folded in at construction, and build() is a
+// 2-byte sequence store plus an RFC 1624 checksum adjustment.
+template <size_t PayloadSize, class Fill = SequentialFill>
+class BasicICMPPacket {
+public:
+    static const size_t SIZE = sizeof(struct icmphdr) + PayloadSize;
+
+    struct Image {
+        unsigned char bytes[SIZE];
+    };
+
+private:
+    // Checksums are summed as big-endian words here and stored with htons(),
+    // which RFC 1071 guarantees gives the same bytes on any host
+    static constexpr unsigned long long payloadWord(size_t word) {
+        return ((unsigned long long)Fill::at(2 * word) << 8) |
+               (2 * word + 1 < PayloadSize ? Fill::at(2 * word + 1) : 0);
+    }
+
+    static constexpr unsigned long long sumWords(size_t begin, size_t end) {
+        return end - begin == 0 ? 0
+             : end - begin == 1 ? payloadWord(begin)
+             : sumWords(begin, begin + (end - begin) / 2) + sumWords(begin + (end - begin) / 2, end);
+    }
+
+    template <size_t... I>
+    static constexpr Image makeImage(IndexSequence<I...>) {
+        return Image{{ICMP_ECHO, 0, 0, 0, 0, 0, 0, 0, Fill::at(I)...}};
+    }
+
+    Image packet;
+
+    struct icmphdr* header() { return (struct icmphdr*)packet.bytes; }
+    const struct icmphdr* header() const { return (const struct icmphdr*)packet.bytes; }
+
+public:
+    static constexpr unsigned long long PAYLOAD_SUM = sumWords(0, (PayloadSize + 1) / 2);
+    static constexpr Image IMAGE = makeImage(typename MakeIndices<PayloadSize>::type());
+
+    // Checksum field for a packet with this payload, the given id and sequence 0
+    static unsigned short baseChecksum(unsigned short id) {
+        unsigned long long sum = PAYLOAD_SUM + (ICMP_ECHO << 8) + ntohs(id);
+        return htons((unsigned short)~foldChecksum(sum));
+    }
+
+    BasicICMPPacket() : packet(IMAGE) {
+        unsigned short id = (unsigned short)getpid();
+        header()->un.echo.id = id;
+        header()->checksum = baseChecksum(id);
+    }
+
+    void build(int sequenceNumber) {
+        unsigned short sequence = (unsigned short)sequenceNumber;
+        unsigned long long sum = (unsigned short)~header()->checksum;
+        sum += (unsigned short)~header()->un.echo.sequence;
+        sum += sequence;
+        header()->checksum = (unsigned short)~foldChecksum(sum);
+        header()->un.echo.sequence = sequence;
+    }
+
+    const void* getData() const { return packet.bytes; }
+    size_t getSize() const { return SIZE; }
+    int getId() const { return header()->un.echo.id; }
+};
+
+template <size_t PayloadSize, class Fill>
+constexpr unsigned long long BasicICMPPacket<PayloadSize, Fill>::PAYLOAD_SUM;
+
+template <size_t PayloadSize, class Fill>
+constexpr typename BasicICMPPacket<PayloadSize, Fill>::Image BasicICMPPacket<PayloadSize, Fill>::IMAGE;
+
+// Runtime-sized Echo Request used by the send paths. Sizes with a
+// precompiled BasicICMPPacket (56, 1472, 8972) are copied from its image;
+// any other size is filled and checksummed once at construction. build()
+// then only patches the sequence number and adjusts the checksum
+// incrementally (RFC 1624), whatever the payload size.
 class ICMPPacket {
 private:
-    struct Packet {
-        struct icmphdr header;
-        char data[56];
-    } packet;
+    std::vector<unsigned char> buffer;  // ICMP header followed by the payload
 
-    static unsigned short calculateChecksum(void* buffer, int length);
+    struct icmphdr* header();
+    const struct icmphdr* header() const;
+
+    template <size_t PayloadSize>
+    void loadImage();
 
 public:
-    ICMPPacket();
+    static const size_t DEFAULT_PAYLOAD_SIZE = 56;
+    static const size_t ETHERNET_PAYLOAD_SIZE = 1472;  // Fills a 1500-byte MTU
+    static const size_t JUMBO_PAYLOAD_SIZE = 8972;     // Fills a 9000-byte MTU
+    static const size_t MAX_PAYLOAD_SIZE = 65507;      // 65535 - IP header - ICMP header
+
+    explicit ICMPPacket(size_t payloadSize = DEFAULT_PAYLOAD_SIZE);
 
+    void build(int sequenceNumber);
     void prepare(int sequenceNumber);
+    // Replaces the pid-derived identifier (e.g. one id per worker thread)
+    void setId(unsigned short id);
     const void* getData() const;
     size_t getSize() const;
+    size_t getPayloadSize() const;
     int getId() const;
+
+    // Whether this size was served from a compile-time image
+    static bool isPrecompiled(size_t payloadSize);
+    // Largest reply (IP header with options + ICMP) for a given payload
+    static size_t getReplyBufferSize(size_t payloadSize);
 };
 
 #endif
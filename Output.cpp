@@ -0,0 +1,391 @@
+#include "Output.hpp"
+#include "PingStatistics.hpp"
+#include "WindowStats.hpp"
+#include <iostream>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <time.h>
+#include <unistd.h>
+
+OutputLevel Output::level = OUTPUT_VERBOSE;
+RecordEmitter Output::records;
+AsyncWriter* Output::humanWriter = nullptr;
+AsyncWriter* Output::recordWriter = nullptr;
+AsyncStreamBuf* Output::humanBuf = nullptr;
+std::streambuf* Output::originalBuf = nullptr;
+std::thread::id Output::mainThread;
+
+AsyncWriter::AsyncWriter(int outputFd)
+    : fd(outputFd), stopping(false), busy(false), worker(&AsyncWriter::run, this) {}
+
+AsyncWriter::~AsyncWriter() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    dataReady.notify_one();
+    worker.join();
+}
+
+void AsyncWriter::run() {
+    std::unique_lock<std::mutex> lock(mutex);
+
+    for (;;) {
+        while (pending.empty() && !stopping) {
+            dataReady.wait(lock);
+        }
+        if (pending.empty()) {
+            break; // Stopping and fully drained
+        }
+
+        writing.swap(pending);
+        busy = true;
+        spaceReady.notify_all();
+        lock.unlock();
+
+        size_t offset = 0;
+        while (offset < writing.size()) {
+            ssize_t written = ::write(fd, writing.data() + offset, writing.size() - offset);
+            if (written < 0) {
+                if (errno == EINTR) continue;
+                break; // Nowhere left to report it; drop the chunk
+            }
+            offset += written;
+        }
+        writing.clear();
+
+        lock.lock();
+        busy = false;
+        spaceReady.notify_all();
+    }
+}
+
+void AsyncWriter::write(const char* data, size_t length) {
+    std::unique_lock<std::mutex> lock(mutex);
+
+    // Only a writer that has fallen megabytes behind applies backpressure
+    while (pending.size() + length > MAX_PENDING && !pending.empty()) {
+        spaceReady.wait(lock);
+    }
+
+    bool wasEmpty = pending.empty();
+    pending.append(data, length);
+    lock.unlock();
+
+    if (wasEmpty) {
+        dataReady.notify_one();
+    }
+}
+
+void AsyncWriter::flush() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!pending.empty() || busy) {
+        spaceReady.wait(lock);
+    }
+}
+
+AsyncStreamBuf::AsyncStreamBuf(AsyncWriter& target) : writer(target) {
+    setp(buffer, buffer + sizeof(buffer));
+}
+
+AsyncStreamBuf::~AsyncStreamBuf() {
+    sync();
+}
+
+int AsyncStreamBuf::overflow(int c) {
+    sync();
+    if (c != traits_type::eof()) {
+        *pptr() = (char)c;
+        pbump(1);
+    }
+    return traits_type::not_eof(c);
+}
+
+std::streamsize AsyncStreamBuf::xsputn(const char* data, std::streamsize length) {
+    if (length > epptr() - pptr()) {
+        sync();
+        if (length >= (std::streamsize)sizeof(buffer)) {
+            writer.write(data, (size_t)length);
+            return length;
+        }
+    }
+    memcpy(pptr(), data, (size_t)length);
+    pbump((int)length);
+    return length;
+}
+
+int AsyncStreamBuf::sync() {
+    std::ptrdiff_t length = pptr() - pbase();
+    if (length > 0) {
+        writer.write(pbase(), (size_t)length);
+        setp(buffer, buffer + sizeof(buffer));
+    }
+    return 0;
+}
+
+// Each thread batches its records here. The final flush at exit runs from
+// an atexit handler, after the main thread's thread-locals are destroyed, so
+// the buffer hands itself over on destruction and is never touched after.
+struct ThreadRecordBuffer {
+    std::string text;
+    ~ThreadRecordBuffer();
+};
+
+static thread_local bool recordBufferGone = false;
+static thread_local ThreadRecordBuffer recordBuffer;
+
+ThreadRecordBuffer::~ThreadRecordBuffer() {
+    Output::records.flush();
+    recordBufferGone = true;
+}
+
+RecordEmitter::RecordEmitter() : format(FORMAT_NONE), writer(nullptr) {}
+
+void RecordEmitter::open(RecordFormat recordFormat, AsyncWriter* target) {
+    format = recordFormat;
+    writer = target;
+
+    if (format == FORMAT_CSV) {
+        const char header[] = "type,target,addr,seq,bytes,ttl,rtt_ms,timestamp,from,reason\n";
+        emit(header, sizeof(header) - 1);
+    }
+}
+
+bool RecordEmitter::isEnabled() const {
+    return format != FORMAT_NONE && writer != nullptr;
+}
+
+void RecordEmitter::emit(const char* line, int length) {
+    if (length <= 0) return;
+    if (recordBufferGone) {
+        if (writer != nullptr) writer->write(line, (size_t)length);
+        return;
+    }
+    recordBuffer.text.append(line, (size_t)length);
+    if (recordBuffer.text.size() >= FLUSH_THRESHOLD) {
+        flush();
+    }
+}
+
+void RecordEmitter::flush() {
+    if (recordBufferGone || recordBuffer.text.empty()) return;
+    if (writer != nullptr) {
+        writer->write(recordBuffer.text.data(), recordBuffer.text.size());
+    }
+    recordBuffer.text.clear();
+}
+
+// Host names are plain DNS labels or addresses, but escape anyway so a
+// hostile target file cannot break the JSON framing. Writes into a caller
+// buffer so records never allocate.
+static const char* jsonEscape(const std::string& text, char* escaped, size_t size) {
+    size_t out = 0;
+    for (size_t i = 0; i < text.size() && out + 7 < size; i++) {
+        char c = text[i];
+        if (c == '"' || c == '\\') {
+            escaped[out++] = '\\';
+            escaped[out++] = c;
+        } else if ((unsigned char)c < 0x20) {
+            out += snprintf(escaped + out, size - out, "\\u%04x", (unsigned char)c);
+        } else {
+            escaped[out++] = c;
+        }
+    }
+    escaped[out] = '\0';
+    return escaped;
+}
+
+// RFC 4180: a field holding a comma, quote or line break is quoted, with
+// its quotes doubled; anything else is written as is. Same caller-buffer
+// contract as jsonEscape().
+static const char* csvField(const std::string& text, char* quoted, size_t size) {
+    if (text.find_first_of(",\"\r\n") == std::string::npos) {
+        snprintf(quoted, size, "%s", text.c_str());
+        return quoted;
+    }
+    size_t out = 0;
+    quoted[out++] = '"';
+    for (size_t i = 0; i < text.size() && out + 3 < size; i++) {
+        if (text[i] == '"') {
+            quoted[out++] = '"';
+        }
+        quoted[out++] = text[i];
+    }
+    quoted[out++] = '"';
+    quoted[out] = '\0';
+    return quoted;
+}
+
+static double wallClockSeconds() {
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+void RecordEmitter::reply(const std::string& host, const std::string& addr, int seq,
+                          int bytes, int ttl, double rttMs) {
+    if (!isEnabled()) return;
+
+    char line[640];
+    char escaped[384];
+    int length;
+    if (format == FORMAT_NDJSON) {
+        length = snprintf(line, sizeof(line),
+                          "{\"type\":\"reply\",\"target\":\"%s\",\"addr\":\"%s\",\"seq\":%d,"
+                          "\"bytes\":%d,\"ttl\":%d,\"rtt_ms\":%.6f,\"ts\":%.6f}\n",
+                          jsonEscape(host, escaped, sizeof(escaped)), addr.c_str(), seq, bytes, ttl, rttMs,
+                          wallClockSeconds());
+    } else {
+        length = snprintf(line, sizeof(line), "reply,%s,%s,%d,%d,%d,%.6f,%.6f,,\n",
+                          csvField(host, escaped, sizeof(escaped)), addr.c_str(), seq, bytes, ttl, rttMs, wallClockSeconds());
+    }
+    emit(line, length < (int)sizeof(line) ? length : (int)sizeof(line) - 1);
+}
+
+void RecordEmitter::timeout(const std::string& host, const std::string& addr, int seq) {
+    if (!isEnabled()) return;
+
+    char line[640];
+    char escaped[384];
+    int length;
+    if (format == FORMAT_NDJSON) {
+        length = snprintf(line, sizeof(line),
+                          "{\"type\":\"timeout\",\"target\":\"%s\",\"addr\":\"%s\",\"seq\":%d,\"ts\":%.6f}\n",
+                          jsonEscape(host, escaped, sizeof(escaped)), addr.c_str(), seq, wallClockSeconds());
+    } else {
+        length = snprintf(line, sizeof(line), "timeout,%s,%s,%d,,,,%.6f,,\n",
+                          csvField(host, escaped, sizeof(escaped)), addr.c_str(), seq, wallClockSeconds());
+    }
+    emit(line, length < (int)sizeof(line) ? length : (int)sizeof(line) - 1);
+}
+
+void RecordEmitter::hop(const std::string& host, const std::string& addr, int seq, int ttl,
+                        const char* from, double rttMs) {
+    if (!isEnabled()) return;
+
+    char line[640];
+    char escaped[384];
+    int length;
+    if (format == FORMAT_NDJSON) {
+        length = snprintf(line, sizeof(line),
+                          "{\"type\":\"hop\",\"target\":\"%s\",\"addr\":\"%s\",\"seq\":%d,"
+                          "\"ttl\":%d,\"from\":\"%s\",\"rtt_ms\":%.6f,\"ts\":%.6f}\n",
+                          jsonEscape(host, escaped, sizeof(escaped)), addr.c_str(), seq, ttl, from,
+                          rttMs, wallClockSeconds());
+    } else {
+        length = snprintf(line, sizeof(line), "hop,%s,%s,%d,,%d,%.6f,%.6f,%s,\n",
+                          csvField(host, escaped, sizeof(escaped)), addr.c_str(), seq, ttl, rttMs, wallClockSeconds(), from);
+    }
+    emit(line, length < (int)sizeof(line) ? length : (int)sizeof(line) - 1);
+}
+
+void RecordEmitter::failure(const std::string& host, const std::string& addr, int seq,
+                            const char* from, const char* reason) {
+    if (!isEnabled()) return;
+
+    char line[640];
+    char escaped[384];
+    int length;
+    if (format == FORMAT_NDJSON) {
+        length = snprintf(line, sizeof(line),
+                          "{\"type\":\"error\",\"target\":\"%s\",\"addr\":\"%s\",\"seq\":%d,"
+                          "\"from\":\"%s\",\"reason\":\"%s\",\"ts\":%.6f}\n",
+                          jsonEscape(host, escaped, sizeof(escaped)), addr.c_str(), seq, from, reason,
+                          wallClockSeconds());
+    } else {
+        length = snprintf(line, sizeof(line), "error,%s,%s,%d,,,,%.6f,%s,%s\n",
+                          csvField(host, escaped, sizeof(escaped)), addr.c_str(), seq, wallClockSeconds(), from, reason);
+    }
+    emit(line, length < (int)sizeof(line) ? length : (int)sizeof(line) - 1);
+}
+
+void RecordEmitter::summary(const std::string& host, const std::string& addr,
+                            const PingStatistics& stats) {
+    // CSV stays one row per probe; only NDJSON carries the summary record
+    if (!isEnabled() || format != FORMAT_NDJSON) return;
+
+    char line[1024];
+    char escaped[384];
+    int length = snprintf(line, sizeof(line),
+                          "{\"type\":\"summary\",\"target\":\"%s\",\"addr\":\"%s\","
+                          "\"transmitted\":%d,\"received\":%d,\"loss_pct\":%d,\"errors\":%d,"
+                          "\"min_ms\":%.6f,\"avg_ms\":%.6f,\"max_ms\":%.6f,\"stddev_ms\":%.6f,"
+                          "\"p50_ms\":%.6f,\"p90_ms\":%.6f,\"p99_ms\":%.6f,\"p999_ms\":%.6f}\n",
+                          jsonEscape(host, escaped, sizeof(escaped)), addr.c_str(),
+                          stats.getTransmitted(), stats.getReceived(), stats.getPacketLoss(),
+                          stats.getErrors(),
+                          stats.getReceived() > 0 ? stats.getMinTime() : 0.0,
+                          stats.getAverageTime(), stats.getMaxTime(), stats.calculateStdDev(),
+                          stats.getPercentile(50.0), stats.getPercentile(90.0),
+                          stats.getPercentile(99.0), stats.getPercentile(99.9));
+    emit(line, length < (int)sizeof(line) ? length : (int)sizeof(line) - 1);
+}
+
+void RecordEmitter::window(const std::string& host, const std::string& addr,
+                           const WindowSummary& window) {
+    if (!isEnabled() || format != FORMAT_NDJSON) return;
+
+    char line[512];
+    char escaped[384];
+    int length = snprintf(line, sizeof(line),
+                          "{\"type\":\"window\",\"target\":\"%s\",\"addr\":\"%s\",\"window_s\":%d,"
+                          "\"answered\":%llu,\"lost\":%llu,\"loss_pct\":%.3f,"
+                          "\"min_ms\":%.6f,\"avg_ms\":%.6f,\"max_ms\":%.6f,\"p99_ms\":%.6f}\n",
+                          jsonEscape(host, escaped, sizeof(escaped)), addr.c_str(), window.seconds,
+                          window.answered, window.lost, window.lossPercent,
+                          window.minTime, window.avgTime, window.maxTime, window.p99Time);
+    emit(line, length < (int)sizeof(line) ? length : (int)sizeof(line) - 1);
+}
+
+void Output::setup(OutputLevel outputLevel, RecordFormat format) {
+    level = outputLevel;
+
+    int humanFd = STDOUT_FILENO;
+    if (format != FORMAT_NONE) {
+        recordWriter = new AsyncWriter(STDOUT_FILENO);
+        records.open(format, recordWriter);
+        humanFd = STDERR_FILENO;
+    }
+
+    mainThread = std::this_thread::get_id();
+    humanWriter = new AsyncWriter(humanFd);
+    humanBuf = new AsyncStreamBuf(*humanWriter);
+    originalBuf = std::cout.rdbuf(humanBuf);
+
+    // Runs after main()'s locals are destroyed, so their output is kept too
+    atexit(Output::shutdown);
+}
+
+void Output::writeHuman(const std::string& text) {
+    if (text.empty()) return;
+    if (humanWriter == nullptr) {
+        std::cout << text;
+        return;
+    }
+    // Anything the main thread buffered through std::cout goes first. The
+    // stream buffer is not thread-safe, so other threads leave it alone and
+    // go to the writer, which locks.
+    if (std::this_thread::get_id() == mainThread) {
+        std::cout.flush();
+    }
+    humanWriter->write(text.data(), text.size());
+}
+
+void Output::shutdown() {
+    if (humanBuf == nullptr) {
+        return;
+    }
+
+    records.flush();
+    std::cout.flush();
+    std::cout.rdbuf(originalBuf);
+    delete humanBuf;
+    delete humanWriter;
+    delete recordWriter;
+    humanBuf = nullptr;
+    humanWriter = nullptr;
+    recordWriter = nullptr;
+    records.open(FORMAT_NONE, nullptr);
+}
@@ -0,0 +1,135 @@
+#ifndef OUTPUT_HPP
+#define OUTPUT_HPP
+
+#include <string>
+#include <streambuf>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+// Verbose tracing can be compiled out entirely with -DPING_ENABLE_TRACE=0;
+// traceEnabled() then folds to false and every trace block is dead code.
+#ifndef PING_ENABLE_TRACE
+#define PING_ENABLE_TRACE 1
+#endif
+
+class PingStatistics;
+struct WindowSummary;
+
+enum OutputLevel {
+    OUTPUT_QUIET,     // Final summary only
+    OUTPUT_CLASSIC,   // One line per reply, like the system ping
+    OUTPUT_VERBOSE    // Full packet-by-packet tracing
+};
+
+enum RecordFormat {
+    FORMAT_NONE,
+    FORMAT_NDJSON,
+    FORMAT_CSV
+};
+
+// Hands text to a background thread that owns the write() calls, so the
+// probe loop only ever pays for a memcpy into the pending buffer.
+class AsyncWriter {
+private:
+    static const size_t MAX_PENDING = 16 * 1024 * 1024;
+
+    int fd;
+    std::string pending;
+    std::string writing;
+    std::mutex mutex;
+    std::condition_variable dataReady;
+    std::condition_variable spaceReady;
+    bool stopping;
+    bool busy;
+    std::thread worker;
+
+    void run();
+
+public:
+    explicit AsyncWriter(int outputFd);
+    ~AsyncWriter();
+
+    void write(const char* data, size_t length);
+    void flush();
+};
+
+// std::streambuf over an AsyncWriter; installed under std::cout so the
+// existing "<< std::endl" call sites stop blocking on terminal I/O.
+class AsyncStreamBuf : public std::streambuf {
+private:
+    AsyncWriter& writer;
+    char buffer[4096];
+
+protected:
+    int overflow(int c);
+    std::streamsize xsputn(const char* data, std::streamsize length);
+    int sync();
+
+public:
+    explicit AsyncStreamBuf(AsyncWriter& target);
+    ~AsyncStreamBuf();
+};
+
+// Machine-readable per-probe records (NDJSON or CSV) for pipelines. Records
+// collect in a per-thread buffer, so worker threads never contend on the
+// writer per probe; the probe loops call flush() before they block.
+class RecordEmitter {
+private:
+    static const size_t FLUSH_THRESHOLD = 64 * 1024;
+
+    RecordFormat format;
+    AsyncWriter* writer;
+
+    void emit(const char* line, int length);
+
+public:
+    RecordEmitter();
+
+    void open(RecordFormat recordFormat, AsyncWriter* target);
+    bool isEnabled() const;
+    void flush();
+
+    void reply(const std::string& host, const std::string& addr, int seq,
+               int bytes, int ttl, double rttMs);
+    void timeout(const std::string& host, const std::string& addr, int seq);
+    // Traceroute mode: the probe sent with this TTL was answered by from
+    void hop(const std::string& host, const std::string& addr, int seq, int ttl,
+             const char* from, double rttMs);
+    // Probe answered by an ICMP error; from is the reporting router or host
+    void failure(const std::string& host, const std::string& addr, int seq,
+                 const char* from, const char* reason);
+    void summary(const std::string& host, const std::string& addr, const PingStatistics& stats);
+    // Daemon mode: one sliding window's loss and RTT at a summary tick
+    void window(const std::string& host, const std::string& addr, const WindowSummary& window);
+};
+
+class Output {
+private:
+    static AsyncWriter* humanWriter;
+    static AsyncWriter* recordWriter;
+    static AsyncStreamBuf* humanBuf;
+    static std::streambuf* originalBuf;
+    static std::thread::id mainThread;  // Owner of std::cout, set by setup()
+
+public:
+    static OutputLevel level;
+    static RecordEmitter records;
+
+    // Human output goes to stdout, or to stderr when records own stdout
+    static void setup(OutputLevel outputLevel, RecordFormat format);
+    static void shutdown();
+    // Thread-safe: hands a block of complete lines to the human writer
+    // whole. Only the thread that called setup() may also use std::cout.
+    static void writeHuman(const std::string& text);
+};
+
+inline bool traceEnabled() {
+    return PING_ENABLE_TRACE && Output::level >= OUTPUT_VERBOSE;
+}
+
+inline bool classicEnabled() {
+    return Output::level == OUTPUT_CLASSIC || (!PING_ENABLE_TRACE && Output::level == OUTPUT_VERBOSE);
+}
+
+#endif
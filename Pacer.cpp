@@ -0,0 +1,141 @@
+#include "Pacer.hpp"
+#include "Timestamp.hpp"
+#include <cerrno>
+#include <unistd.h>
+#include <sys/prctl.h>
+
+Pacer::Pacer(double intervalMs, double jitterFraction)
+    : intervalNs(intervalMs > 0.0 ? (long long)(intervalMs * 1000000.0 + 0.5) : 0),
+      jitter(jitterFraction > 0.0 ? jitterFraction : 0.0), ratePerSec(0.0), burst(1.0),
+      tokens(1.0), slot(0) {
+    anchor = monotonicNow();
+    next = anchor;
+    lastRefill = anchor;
+    rngState = ((unsigned long long)anchor.tv_nsec << 20) ^ (unsigned long long)getpid() ^
+               0x9E3779B97F4A7C15ULL;
+}
+
+void Pacer::setRateLimit(double perSecond, double burstSize) {
+    ratePerSec = perSecond > 0.0 ? perSecond : 0.0;
+    if (burstSize >= 1.0) {
+        burst = burstSize;
+    } else {
+        // Default: a millisecond of tokens, so wakeup latency on short waits
+        // is banked rather than lost at high rates
+        burst = ratePerSec / 1000.0 > 1.0 ? ratePerSec / 1000.0 : 1.0;
+    }
+    tokens = burst;
+}
+
+void Pacer::start(const struct timespec& now) {
+    // The default 50 us timer slack would swallow sub-millisecond gaps
+    if ((intervalNs > 0 && intervalNs < 1000000) || ratePerSec > 1000.0) {
+        prctl(PR_SET_TIMERSLACK, 1UL, 0UL, 0UL, 0UL);
+    }
+
+    anchor = now;
+    slot = 0;
+    lastRefill = now;
+    tokens = burst;
+    schedule();
+}
+
+// xorshift64*; jitter only has to decorrelate probes, not be unpredictable
+double Pacer::randomUnit() {
+    rngState ^= rngState >> 12;
+    rngState ^= rngState << 25;
+    rngState ^= rngState >> 27;
+    return ((rngState * 0x2545F4914F6CDD1DULL) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+void Pacer::schedule() {
+    // Integer nanoseconds from the anchor: slot 1000 at 10 ms is exactly 10 s
+    long long offsetNs = slot * intervalNs;
+    if (jitter > 0.0 && intervalNs > 0) {
+        offsetNs += (long long)(randomUnit() * jitter * intervalNs);
+    }
+    next = addMs(anchor, offsetNs / 1000000.0);
+}
+
+void Pacer::refill(const struct timespec& now) {
+    if (ratePerSec <= 0.0) return;
+    double elapsed = elapsedMs(lastRefill, now);
+    if (elapsed <= 0.0) return;
+    tokens += elapsed * ratePerSec / 1000.0;
+    if (tokens > burst) tokens = burst;
+    lastRefill = now;
+}
+
+double Pacer::msUntilDue(const struct timespec& now) {
+    double wait = intervalNs > 0 ? elapsedMs(now, next) : 0.0;
+
+    if (ratePerSec > 0.0) {
+        refill(now);
+        if (tokens < 1.0) {
+            double tokenWait = (1.0 - tokens) * 1000.0 / ratePerSec;
+            if (tokenWait > wait) wait = tokenWait;
+        }
+    }
+
+    return wait > 0.0 ? wait : 0.0;
+}
+
+bool Pacer::isDue(const struct timespec& now) {
+    return msUntilDue(now) <= 0.0;
+}
+
+void Pacer::consume(const struct timespec& now) {
+    if (ratePerSec > 0.0) {
+        tokens -= 1.0;
+    }
+    if (intervalNs == 0) return;
+
+    slot++;
+    schedule();
+
+    // More than a whole interval behind (a long reply wait, a stopped
+    // process): re-anchor instead of firing a catch-up burst
+    if (elapsedMs(next, now) * 1000000.0 > intervalNs) {
+        anchor = now;
+        slot = 1;
+        schedule();
+    }
+}
+
+void Pacer::cancel(int count) {
+    if (count <= 0) return;
+    if (ratePerSec > 0.0) {
+        tokens += count;
+        if (tokens > burst) tokens = burst;
+    }
+    if (intervalNs > 0) {
+        slot -= count;
+        if (slot < 0) slot = 0;
+        schedule();
+    }
+}
+
+void Pacer::sleepUntilDue() {
+    for (;;) {
+        struct timespec now = monotonicNow();
+        double wait = msUntilDue(now);
+        if (wait <= 0.0) return;
+
+        // Sleep to the grid instant itself when it is what we wait for, so the
+        // float round trip cannot shift the deadline
+        struct timespec deadline = addMs(now, wait);
+        if (intervalNs > 0 && elapsedMs(now, next) >= wait) {
+            deadline = next;
+        }
+        int rc = clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, nullptr);
+        if (rc != 0 && rc != EINTR) return;
+    }
+}
+
+double Pacer::getIntervalMs() const {
+    return intervalNs / 1000000.0;
+}
+
+double Pacer::getRateLimit() const {
+    return ratePerSec;
+}
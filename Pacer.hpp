@@ -0,0 +1,48 @@
+#ifndef PACER_HPP
+#define PACER_HPP
+
+#include <time.h>
+
+// Probe scheduler on absolute CLOCK_MONOTONIC deadlines. Probe k is due at
+// start + k * interval (plus optional jitter), so send, receive and print
+// time never accumulate into drift. An optional token bucket caps the
+// long-run rate while still allowing short bursts.
+class Pacer {
+private:
+    long long intervalNs;
+    double jitter;            // Fraction of the interval added at random, 0 = none
+    double ratePerSec;        // Token refill rate, 0 = unlimited
+    double burst;             // Bucket capacity
+    double tokens;
+    struct timespec anchor;   // Grid origin
+    long long slot;           // Grid index of the next probe
+    struct timespec next;     // Deadline of the next probe
+    struct timespec lastRefill;
+    unsigned long long rngState;
+
+    void schedule();
+    void refill(const struct timespec& now);
+    double randomUnit();
+
+public:
+    Pacer(double intervalMs = 0.0, double jitterFraction = 0.0);
+
+    // A burst below 1 picks the default: one millisecond's worth of tokens
+    void setRateLimit(double perSecond, double burstSize = 0.0);
+    void start(const struct timespec& now);
+
+    // Time until the next probe may go out (0 when it is due now)
+    double msUntilDue(const struct timespec& now);
+    bool isDue(const struct timespec& now);
+    // Records that a probe was sent and moves to the next deadline
+    void consume(const struct timespec& now);
+    // Gives back probes that were scheduled but never left (e.g. ENOBUFS)
+    void cancel(int count);
+    // clock_nanosleep(TIMER_ABSTIME) until the next probe is due
+    void sleepUntilDue();
+
+    double getIntervalMs() const;
+    double getRateLimit() const;
+};
+
+#endif
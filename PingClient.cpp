@@ -1,98 +1,110 @@
 #include "PingClient.hpp"
 #include "utils.hpp"
+#include "Output.hpp"
+#include "ReplyView.hpp"
+#include "Resolver.hpp"
 #include <unistd.h>
-#include <sys/time.h>
-#include <netdb.h>
 #include <cerrno>
 #include <iomanip>
 #include <sstream>
 #include <iostream>
 #include <cstring> 
+#include <cstdio>
+#include <algorithm>
 
-PingClient::PingClient(const std::string& host, int timeoutSec) 
-    : sockfd(-1), hostname(host), timeout(timeoutSec) {
+volatile sig_atomic_t PingClient::stopRequested = 0;
+// Defined here too: std::min() binds it by reference, which -O0 builds link against
+const int PingClient::MAX_TTL;
+
+PingClient::PingClient(const std::string& host, const PingOptions& options) 
+    : transport(options.backend == BACKEND_SIMULATED
+                    ? (Transport*)new SimulatedTransport(options.simulation)
+                    : (Transport*)new RawSocketTransport()),
+      hostname(host), timeoutMs(options.timeoutMs > 0.0 ? options.timeoutMs : 2000.0),
+      window(options.window > 0 ? options.window : 1), interval(options.intervalMs),
+      flood(options.flood), batchSize(options.batchSize > 0 ? options.batchSize : 1),
+      backend(options.backend),
+      icmpId((unsigned short)getpid()), timestampMode(TIMESTAMP_NONE), stats(!options.flood),
+      probe(options.payloadSize > 0 ? options.payloadSize : 0),
+      rxBuffer(ICMPPacket::getReplyBufferSize(probe.getPayloadSize())), probeLogPath(options.probeLogPath),
+      summaryIntervalMs(options.summaryIntervalMs > 0.0 ? options.summaryIntervalMs : 0.0),
+      statsSegmentName(options.statsSegmentName), publishedEvents(0),
+      maxHops(options.maxHops > 0 ? std::min(options.maxHops, MAX_TTL) : 0), pathEnd(0),
+      reached(false), hopStats(maxHops, PingStatistics(false)), hopAddress(maxHops, 0),
+      mtuLimit(options.mtuLimit), mtuPassed(0), mtuBound(0), reportedMtu(0), mtuReporter(0),
+      mtuUnreachable(false), mtuFailure(FAILURE_UNREACHABLE_OTHER), roundBase(1), mtuSearching(false) {
     memset(&destAddr, 0, sizeof(destAddr));
+    memset(&nextSummary, 0, sizeof(nextSummary));
+    memset(&nextPublish, 0, sizeof(nextPublish));
+    
+    if (flood && window <= 1) {
+        window = FLOOD_DEFAULT_WINDOW;
+    }
+    if (window >= ProbeTable::SEQ_SPACE) {
+        window = ProbeTable::SEQ_SPACE - 1;
+    }
+    if (interval < 0.0) {
+        // Stop-and-wait keeps the classic 1 second gap; the other modes are window-limited
+        interval = (window > 1 || flood) ? 0.0 : 1000.0;
+    }
+    pacer = Pacer(interval, options.jitter);
+    pacer.setRateLimit(options.rateLimit, options.burst);
+    if (options.profileStages) {
+        profile.enable();
+    }
 }
 
 PingClient::~PingClient() {
-    if (sockfd >= 0) {
-        std::cout << std::endl << "  Closing socket (fd: " << sockfd << ")..." << std::endl;
-        close(sockfd);
-        std::cout << "  [SUCCESS] Socket closed" << std::endl;
-    }
+    transport->close();
 }
 
 bool PingClient::createSocket() {
-    printSection("SOCKET CREATION");
-    
-    std::cout << "  Creating raw socket..." << std::endl;
-    sockfd = socket(AF_INET, SOCK_RAW, IPPROTO_ICMP);
-    
-    if (sockfd < 0) {
-        std::cout << "  [FAILED] Cannot create socket" << std::endl;
-        std::cout << "  Error Code: " << errno << std::endl;
-        std::cout << "  Error Message: " << strerror(errno) << std::endl;
-        std::cout << "  Note: Root privileges required for raw sockets" << std::endl;
+    // Flood keeps a whole window of replies queued between reads
+    size_t queueBytes = flood ? (size_t)window * (probe.getSize() + sizeof(struct iphdr)) : 0;
+    if (!transport->open(icmpId, rxBuffer.size(), queueBytes)) {
         return false;
     }
-    
-    std::cout << "  [SUCCESS] Socket created" << std::endl;
-    printInfo("Socket File Descriptor", sockfd);
-    printInfo("Socket Type", "SOCK_RAW");
-    printInfo("Protocol", "IPPROTO_ICMP");
-    
-    std::cout << std::endl << "  Configuring socket options..." << std::endl;
-    struct timeval tv;
-    tv.tv_sec = timeout;
-    tv.tv_usec = 0;
-    
-    if (setsockopt(sockfd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv)) < 0) {
-        std::cout << "  [WARNING] Cannot set socket timeout: " << strerror(errno) << std::endl;
-    } else {
-        std::cout << "  [SUCCESS] Socket timeout configured" << std::endl;
-        printInfo("Receive Timeout", std::to_string(timeout) + " seconds");
-    }
-    
+    timestampMode = transport->getTimestampMode();
     return true;
 }
 
 bool PingClient::resolveHost(const std::string& host) {
-    printSection("HOSTNAME RESOLUTION");
-    
-    printInfo("Target Hostname", host);
-    std::cout << "  Querying DNS..." << std::endl;
-    
-    struct hostent* hostInfo = gethostbyname(host.c_str());
+    if (traceEnabled()) {
+        printSection("HOSTNAME RESOLUTION");
+        printInfo("Target Hostname", host);
+        std::cout << "  Querying DNS..." << std::endl;
+    }
     
-    if (hostInfo == nullptr) {
-        std::cout << "  [FAILED] Cannot resolve hostname" << std::endl;
-        std::cout << "  h_errno: " << h_errno << " (" << hstrerror(h_errno) << ")" << std::endl;
+    int error = 0;
+    if (!Resolver::lookup(host, destAddr.sin_addr, error)) {
+        std::cout << "  [FAILED] Cannot resolve hostname: " << host << std::endl;
+        std::cout << "  getaddrinfo: " << error << " (" << Resolver::describeError(error) << ")" << std::endl;
         return false;
     }
     
     destAddr.sin_family = AF_INET;
-    destAddr.sin_addr = *((struct in_addr*)hostInfo->h_addr);
     ipAddress = inet_ntoa(destAddr.sin_addr);
     
-    std::cout << "  [SUCCESS] Hostname resolved" << std::endl;
-    printInfo("IP Address", ipAddress);
-    printInfo("Address Family", "AF_INET (IPv4)");
+    if (traceEnabled()) {
+        std::cout << "  [SUCCESS] Hostname resolved" << std::endl;
+        printInfo("IP Address", ipAddress);
+        printInfo("Address Family", "AF_INET (IPv4)");
+    }
     
     return true;
 }
 
-double PingClient::calculateRTT(const struct timeval& start, const struct timeval& end) {
-    return (end.tv_sec - start.tv_sec) * 1000.0 +
-           (end.tv_usec - start.tv_usec) / 1000.0;
-}
-
-bool PingClient::sendPacket(const ICMPPacket& packet) {
-    std::cout << "  Sending ICMP packet..." << std::endl;
-    printInfo("Destination IP", ipAddress);
-    printInfo("Packet Size", (int)packet.getSize());
+bool PingClient::sendPacket(const ICMPPacket& packet, SendStamp& sendTime) {
+    if (traceEnabled()) {
+        std::cout << "  Sending ICMP packet..." << std::endl;
+        printInfo("Destination IP", ipAddress);
+        printInfo("Packet Size", (int)packet.getSize());
+    }
     
-    int sent = sendto(sockfd, packet.getData(), packet.getSize(), 0,
-                      (struct sockaddr*)&destAddr, sizeof(destAddr));
+    // Stamp as late as possible so the RTT excludes building and printing
+    stampSend(sendTime);
+    int sent = transport->send((const char*)packet.getData(), packet.getSize(), destAddr);
+    profile.record(STAGE_SEND, profile.mark() - StageProfile::toNs(sendTime.mono));
     
     if (sent < 0) {
         std::cout << "  [FAILED] Send operation failed" << std::endl;
@@ -100,192 +112,1374 @@ bool PingClient::sendPacket(const ICMPPacket& packet) {
         return false;
     }
     
-    std::cout << "  [SUCCESS] Packet sent" << std::endl;
-    printInfo("Bytes Sent", sent);
-    printInfo("Send Timestamp", getTimestamp());
+    if (traceEnabled()) {
+        std::cout << "  [SUCCESS] Packet sent" << std::endl;
+        printInfo("Bytes Sent", sent);
+        printInfo("Send Timestamp", getTimestamp());
+    }
     stats.addTransmitted();
     return true;
 }
 
-bool PingClient::receiveReply(int expectedSeq, struct timeval sendTime, double& rtt) {
-    const int MAX_RETRIES = 10;
-    char buffer[1024];
+// Non-blocking: returns the first queued Echo Reply that matches an
+// outstanding probe, or false once the socket has nothing more queued.
+// Waiting is left to the callers, which wait on per-probe deadlines.
+bool PingClient::receiveReply(int& seq, double& rtt) {
+    char* buffer = &rxBuffer[0];
     struct sockaddr_in fromAddr;
-    socklen_t fromLen = sizeof(fromAddr);
-    
-    std::cout << std::endl << "  Waiting for reply..." << std::endl;
-    printInfo("Expected Sequence", expectedSeq);
-    printInfo("Max Receive Attempts", MAX_RETRIES);
+    RecvStamp recvTime;
+    bool trace = traceEnabled();
     
-    for (int retry = 0; retry < MAX_RETRIES; retry++) {
-        std::cout << std::endl << "  [Attempt " << (retry + 1) << "/" << MAX_RETRIES << "]" << std::endl;
-        
-        int receivedBytes = recvfrom(sockfd, buffer, sizeof(buffer), 0,
-                                     (struct sockaddr*)&fromAddr, &fromLen);
+    for (;;) {
+        long long callStart = profile.mark();
+        int receivedBytes = transport->receive(buffer, rxBuffer.size(), &fromAddr, recvTime);
+        long long received = profile.mark();
+        long long receivedWall = profile.isEnabled() && timestampMode != TIMESTAMP_NONE
+                                     ? StageProfile::wallNow() : 0;
         
         if (receivedBytes < 0) {
-            if (errno == EAGAIN || errno == EWOULDBLOCK) {
-                std::cout << "  [TIMEOUT] No packet received within timeout period" << std::endl;
-                printInfo("Timeout Duration", std::to_string(timeout) + " seconds");
-            } else {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
                 std::cout << "  [ERROR] Receive error: " << strerror(errno) << std::endl;
             }
             return false;
         }
         
-        struct timeval recvTime;
-        gettimeofday(&recvTime, nullptr);
-        
-        std::cout << "  [RECEIVED] Packet received" << std::endl;
-        printInfo("Bytes Received", receivedBytes);
-        printInfo("Source Address", inet_ntoa(fromAddr.sin_addr));
-        printInfo("Receive Timestamp", getTimestamp());
-        
-        struct iphdr* ipHeader = (struct iphdr*)buffer;
-        int ipHeaderLen = ipHeader->ihl * 4;
-        struct icmphdr* icmpReply = (struct icmphdr*)(buffer + ipHeaderLen);
-        
-        std::cout << std::endl << "  IP HEADER ANALYSIS:" << std::endl;
-        printInfo("IP Version", (int)ipHeader->version);
-        printInfo("Header Length", std::to_string(ipHeaderLen) + " bytes");
-        printInfo("Time To Live (TTL)", (int)ipHeader->ttl);
-        printInfo("Protocol", (int)ipHeader->protocol);
-        printInfo("Total Length", ntohs(ipHeader->tot_len));
-        
-        std::cout << std::endl << "  ICMP HEADER ANALYSIS:" << std::endl;
-        printInfo("ICMP Type", std::to_string((int)icmpReply->type) + " (" + getIcmpTypeName(icmpReply->type) + ")");
-        printInfo("ICMP Code", (int)icmpReply->code);
-        printInfo("ICMP ID", icmpReply->un.echo.id);
-        printInfo("ICMP Sequence", icmpReply->un.echo.sequence);
+        ReplyView reply;
+        if (!parseReply(buffer, receivedBytes, reply)) {
+            continue; // Truncated; nothing to match against
+        }
+        const struct iphdr* ipHeader = reply.ip;
+        const struct icmphdr* icmpReply = reply.icmp;
+        int ipHeaderLen = reply.ipHeaderLength;
         
-        std::cout << "  Checksum                 : 0x" << std::hex << std::setw(4) 
-                  << std::setfill('0') << icmpReply->checksum << std::dec 
-                  << std::setfill(' ') << std::endl; // <-- Reset fill char
+        if (trace) {
+            std::cout << std::endl << "  [RECEIVED] Packet received" << std::endl;
+            printInfo("Bytes Received", receivedBytes);
+            printInfo("Source Address", inet_ntoa(fromAddr.sin_addr));
+            printInfo("Receive Timestamp", getTimestamp());
+            if (recvTime.hasKernel) {
+                printInfo("Kernel RX Timestamp", formatTimespec(recvTime.kernel));
+            }
+            if (recvTime.hasHardware) {
+                printInfo("Hardware RX Timestamp", formatTimespec(recvTime.hardware));
+            }
+            
+            std::cout << std::endl << "  IP HEADER ANALYSIS:" << std::endl;
+            printInfo("IP Version", (int)ipHeader->version);
+            printInfo("Header Length", std::to_string(ipHeaderLen) + " bytes");
+            printInfo("Time To Live (TTL)", (int)ipHeader->ttl);
+            printInfo("Protocol", (int)ipHeader->protocol);
+            printInfo("Total Length", ntohs(ipHeader->tot_len));
+            
+            std::cout << std::endl << "  ICMP HEADER ANALYSIS:" << std::endl;
+            printInfo("ICMP Type", std::to_string((int)icmpReply->type) + " (" + getIcmpTypeName(icmpReply->type) + ")");
+            printInfo("ICMP Code", (int)icmpReply->code);
+            printInfo("ICMP ID", icmpReply->un.echo.id);
+            printInfo("ICMP Sequence", icmpReply->un.echo.sequence);
+            
+            std::cout << "  Checksum                 : 0x" << std::hex << std::setw(4) 
+                      << std::setfill('0') << icmpReply->checksum << std::dec 
+                      << std::setfill(' ') << (reply.checksumValid ? " (valid)" : " (INVALID)")
+                      << std::endl; // <-- Reset fill char
+        }
         
         if (icmpReply->type == ICMP_ECHO) {
-            std::cout << "  [SKIP] Echo Request detected (our own packet on loopback)" << std::endl;
-            std::cout << "  Continuing to next packet..." << std::endl;
+            if (trace) {
+                std::cout << "  [SKIP] Echo Request detected (our own packet on loopback)" << std::endl;
+                std::cout << "  Continuing to next packet..." << std::endl;
+            }
+            continue;
+        }
+        
+        if (reply.isError) {
+            if (trace) {
+                std::cout << std::endl << "  QUOTED PROBE (ICMP ERROR):" << std::endl;
+                printInfo("Quoted ICMP ID", reply.quotedId);
+                printInfo("Quoted Sequence", reply.quotedSequence);
+                printInfo("Quoted Destination", inet_ntoa(*(struct in_addr*)&reply.quotedDestination));
+            }
+            if (acceptFailure(reply)) {
+                continue; // The probe is settled; keep draining
+            }
+            if (trace) {
+                std::cout << "  [MISMATCH] ICMP error does not quote an outstanding probe" << std::endl;
+                std::cout << "  Continuing to next packet..." << std::endl;
+            }
             continue;
         }
         
-        std::cout << std::endl << "  PACKET VERIFICATION:" << std::endl;
-        bool typeMatch = (icmpReply->type == ICMP_ECHOREPLY);
-        bool idMatch = (icmpReply->un.echo.id == getpid());
-        bool seqMatch = (icmpReply->un.echo.sequence == expectedSeq);
+        bool typeMatch = (reply.type == ICMP_ECHOREPLY);
+        bool idMatch = (reply.id == icmpId);
+        bool seqMatch = !sendTimes.isFree(reply.sequence);
         
-        printInfo("Type Match", typeMatch ? "YES (0 - Echo Reply)" : "NO");
-        printInfo("ID Match", idMatch ? "YES" : "NO");
-        printInfo("Sequence Match", seqMatch ? "YES" : "NO");
+        if (trace) {
+            std::cout << std::endl << "  PACKET VERIFICATION:" << std::endl;
+            printInfo("Type Match", typeMatch ? "YES (0 - Echo Reply)" : "NO");
+            printInfo("ID Match", idMatch ? "YES" : "NO");
+            printInfo("Sequence Match", seqMatch ? "YES (outstanding probe)" : "NO");
+            printInfo("Checksum Valid", reply.checksumValid ? "YES" : "NO (corrupted in transit)");
+        }
         
-        if (typeMatch && idMatch && seqMatch) {
-            rtt = calculateRTT(sendTime, recvTime);
-            
-            std::cout << std::endl << "  [SUCCESS] Valid Echo Reply received" << std::endl;
-            printSeparator('-', 80);
-            
+        if (typeMatch && idMatch && seqMatch && reply.checksumValid) {
+            bool fromKernel = false;
+            SendStamp sendTime;
+            seq = icmpReply->un.echo.sequence;
+            sendTimes.take(icmpReply->un.echo.sequence, sendTime);
+            rtt = stampRttMs(sendTime, recvTime, &fromKernel);
             int dataSize = receivedBytes - ipHeaderLen;
-            std::cout << "  REPLY SUMMARY: " << dataSize << " bytes from " 
-                      << inet_ntoa(fromAddr.sin_addr)
-                      << ": icmp_seq=" << expectedSeq
-                      << " ttl=" << (int)ipHeader->ttl
-                      << " time=" << std::fixed << std::setprecision(3) << rtt << " ms" << std::endl;
             
-            printSeparator('-', 80);
+            if (trace) {
+                std::cout << std::endl << "  [SUCCESS] Valid Echo Reply received" << std::endl;
+                printInfo("RTT Measured By", fromKernel ? "kernel RX timestamp" : "monotonic clock");
+                printSeparator('-', 80);
+                
+                std::cout << "  REPLY SUMMARY: " << dataSize << " bytes from " 
+                          << inet_ntoa(fromAddr.sin_addr)
+                          << ": icmp_seq=" << seq
+                          << " ttl=" << (int)ipHeader->ttl
+                          << " time=" << std::fixed << std::setprecision(3) << rtt << " ms" << std::endl;
+                
+                printSeparator('-', 80);
+            }
+            
+            // Only matched replies are profiled, so every stage counts probes
+            if (profile.isEnabled()) {
+                long long matched = StageProfile::now();
+                profile.record(STAGE_RECEIVE, received - callStart);
+                profileWakeup(recvTime, received, receivedWall);
+                profile.record(STAGE_PARSE, matched - received);
+            }
+            long long reportStart = profile.mark();
+            stats.addReceived(rtt);
+            reportReply(seq, sendTime, dataSize, ipHeader->ttl, rtt);
+            profile.record(STAGE_REPORT, profile.mark() - reportStart);
             return true;
-        } else {
+        } else if (trace) {
             std::cout << "  [MISMATCH] Packet verification failed" << std::endl;
             if (!typeMatch) std::cout << "    - Wrong ICMP type" << std::endl;
             if (!idMatch) std::cout << "    - Wrong process ID" << std::endl;
-            if (!seqMatch) std::cout << "    - Wrong sequence number" << std::endl;
+            if (!seqMatch) std::cout << "    - Sequence number not outstanding (expired or duplicate)" << std::endl;
+            if (!reply.checksumValid) std::cout << "    - Bad ICMP checksum" << std::endl;
             std::cout << "  Continuing to next packet..." << std::endl;
         }
     }
+}
+
+void PingClient::drainReplies() {
+    int replySeq;
+    double rtt;
+    while (receiveReply(replySeq, rtt)) {
+    }
+}
+
+bool PingClient::sendProbe(long long seq, int count) {
+    long long start = profile.mark();
+    long long built;
+    if (traceEnabled()) {
+        std::cout << std::endl;
+        printSeparator('=', 80);
+        std::cout << "  PACKET " << seq;
+        if (count > 0) {
+            std::cout << " OF " << count;
+        }
+        std::cout << std::endl;
+        printSeparator('=', 80);
+        
+        std::cout << std::endl;
+        printSection("PACKET PREPARATION");
+        probe.prepare((unsigned short)seq);
+        built = profile.mark();
+        
+        std::cout << std::endl;
+        printSection("PACKET TRANSMISSION");
+    } else {
+        probe.build((unsigned short)seq);
+        built = profile.mark();
+    }
     
-    std::cout << std::endl << "  [FAILED] No matching reply received after " 
-              << MAX_RETRIES << " attempts" << std::endl;
-    return false;
+    SendStamp sendTime;
+    if (!sendPacket(probe, sendTime)) {
+        stats.addError();
+        return false;
+    }
+    profile.record(STAGE_BUILD, built - start);
+    profile.record(STAGE_PRE_SEND, StageProfile::toNs(sendTime.mono) - built);
+    
+    sendTimes.insert((unsigned short)seq, sendTime);
+    return true;
 }
 
+int PingClient::expireProbes() {
+    struct timespec now = monotonicNow();
+    int expired = 0;
+    unsigned short seq;
+    SendStamp sendTime;
+    
+    // Probes leave in sequence order, so only the oldest ones can be overdue
+    while (sendTimes.oldest(seq, sendTime) &&
+           elapsedMs(sendTime.mono, now) >= timeoutMs) {
+        if (!flood && traceEnabled()) {
+            std::cout << std::endl << "  [TIMEOUT] No reply for icmp_seq=" << seq
+                      << " within " << formatDouble(timeoutMs) << " ms" << std::endl;
+        }
+        reportTimeout(seq, sendTime);
+        stats.addError();
+        sendTimes.erase(seq);
+        expired++;
+    }
+    
+    return expired;
+}
 
-bool PingClient::initialize() {
-    printHeader("ICMP PING - VERBOSE MODE");
+double PingClient::nextEventMs(long long nextSeq, int count, const struct timespec& now) {
+    double waitMs = -1.0;
     
-    std::cout << std::endl;
-    printInfo("Program Version", "1.0");
-    printInfo("Target Host", hostname);
-    printInfo("Process ID", getpid());
-    printInfo("Timeout", std::to_string(timeout) + " seconds");
+    if (!sendingDone(nextSeq, count) && sendTimes.size() < window &&
+        sendTimes.isFree((unsigned short)nextSeq)) {
+        waitMs = pacer.msUntilDue(now);
+    }
     
-    std::cout << std::endl;
+    unsigned short seq;
+    SendStamp oldest;
+    if (sendTimes.oldest(seq, oldest)) {
+        double deadline = timeoutMs - elapsedMs(oldest.mono, now);
+        if (waitMs < 0.0 || deadline < waitMs) {
+            waitMs = deadline;
+        }
+    }
     
-    if (!createSocket()) {
+    if (waitMs < 0.0) {
+        return 0.0;
+    }
+    return capToPeriodic(waitMs, now);
+}
+
+// count 0 runs until requestStop(); a stop also ends a counted run early,
+// after the probes in flight are answered or expire
+bool PingClient::sendingDone(long long nextSeq, int count) const {
+    return stopRequested || (count > 0 && nextSeq > count);
+}
+
+// Shortens a wait so the next summary line, and a publish of counters
+// that moved, are not held up by a long interval or reply deadline
+double PingClient::capToPeriodic(double waitMs, const struct timespec& now) const {
+    if (summaryIntervalMs > 0.0) {
+        double untilSummary = elapsedMs(now, nextSummary);
+        if (untilSummary < waitMs) {
+            waitMs = untilSummary > 0.0 ? untilSummary : 0.0;
+        }
+    }
+    if (publishPending()) {
+        double untilPublish = elapsedMs(now, nextPublish);
+        if (untilPublish < waitMs) {
+            waitMs = untilPublish > 0.0 ? untilPublish : 0.0;
+        }
+    }
+    return waitMs;
+}
+
+// Every probe outcome moves one of the three counters
+bool PingClient::publishPending() const {
+    return statsSegment.isOpen() &&
+           (long long)stats.getTransmitted() + stats.getReceived() + stats.getErrors() != publishedEvents;
+}
+
+void PingClient::publishStats(const struct timespec& now, bool force) {
+    if (!force && (!publishPending() || elapsedMs(nextPublish, now) < 0.0)) {
+        return;
+    }
+    statsSegment.publish(0, stats, destAddr.sin_addr.s_addr);
+    publishedEvents = (long long)stats.getTransmitted() + stats.getReceived() + stats.getErrors();
+    nextPublish = addMs(now, StatsSegment::PUBLISH_INTERVAL_MS);
+}
+
+// Called on every loop turn: publishes the live statistics when due and,
+// in daemon mode, slides the windows and prints the summary line when due
+void PingClient::tickPeriodic() {
+    if (summaryIntervalMs <= 0.0 && !statsSegment.isOpen()) {
+        return;
+    }
+    struct timespec now = monotonicNow();
+    if (statsSegment.isOpen()) {
+        publishStats(now, false);
+    }
+    if (summaryIntervalMs <= 0.0) {
+        return;
+    }
+    windows.advance(now);
+    if (elapsedMs(nextSummary, now) >= 0.0) {
+        printWindows();
+        nextSummary = addMs(nextSummary, summaryIntervalMs);
+        // After a stall, resume the period instead of printing a burst of lines
+        if (elapsedMs(nextSummary, now) >= 0.0) {
+            nextSummary = addMs(now, summaryIntervalMs);
+        }
+    }
+}
+
+// One line per period: loss and rtt min/avg/max/p99 for each window.
+// Formatted on the stack, so the line costs the same at any uptime.
+void PingClient::printWindows() {
+    char line[512];
+    int length = 0;
+    time_t wallTime = time(nullptr);
+    struct tm local;
+    if (localtime_r(&wallTime, &local) != nullptr) {
+        length = (int)strftime(line, sizeof(line), "%Y-%m-%d %H:%M:%S ", &local);
+    }
+    length += snprintf(line + length, sizeof(line) - length, "%s", hostname.c_str());
+    
+    for (int w = 0; w < windows.getWindowCount() && length < (int)sizeof(line); w++) {
+        WindowSummary summary = windows.summarize(w);
+        Output::records.window(hostname, ipAddress, summary);
+        
+        char label[16];
+        if (summary.seconds % 60 == 0) {
+            snprintf(label, sizeof(label), "%dm", summary.seconds / 60);
+        } else {
+            snprintf(label, sizeof(label), "%ds", summary.seconds);
+        }
+        unsigned long long probes = summary.answered + summary.lost;
+        if (summary.answered > 0) {
+            length += snprintf(line + length, sizeof(line) - length,
+                               " | %s %llu/%llu %.1f%% loss rtt %.3f/%.3f/%.3f/%.3f ms", label,
+                               summary.answered, probes, summary.lossPercent, summary.minTime,
+                               summary.avgTime, summary.maxTime, summary.p99Time);
+        } else {
+            length += snprintf(line + length, sizeof(line) - length, " | %s %llu/%llu %s", label,
+                               summary.answered, probes, probes > 0 ? "100.0% loss" : "no probes");
+        }
+    }
+    
+    if (length > (int)sizeof(line) - 2) {
+        length = (int)sizeof(line) - 2;
+    }
+    line[length++] = '\n';
+    std::cout.write(line, length);
+}
+
+int PingClient::waitReadable(double waitMs) {
+    std::cout.flush();
+    Output::records.flush();
+    
+    int ready = transport->wait(waitMs);
+    if (ready < 0 && errno != EINTR) {
+        std::cout << "  [ERROR] Waiting for replies failed: " << strerror(errno) << std::endl;
+    }
+    return ready;
+}
+
+void PingClient::reportReply(int seq, const SendStamp& sent, int bytes, int ttl, double rtt) {
+    if (flood) {
+        if (Output::level >= OUTPUT_CLASSIC) {
+            std::cout << '\b';
+        }
+    } else if (classicEnabled()) {
+        // Formatted on the stack and flushed before the next wait, so a reply costs no allocation
+        char line[160];
+        int length = snprintf(line, sizeof(line), "%d bytes from %s: icmp_seq=%d ttl=%d time=%.3f ms\n",
+                              bytes, ipAddress.c_str(), seq, ttl, rtt);
+        std::cout.write(line, length < (int)sizeof(line) ? length : (int)sizeof(line) - 1);
+    }
+    Output::records.reply(hostname, ipAddress, seq, bytes, ttl, rtt);
+    probeLog.reply(0, seq, sent, rtt, ttl);
+    if (summaryIntervalMs > 0.0) {
+        windows.addReply(rtt);
+    }
+}
+
+void PingClient::reportTimeout(int seq, const SendStamp& sent) {
+    if (!flood && classicEnabled()) {
+        std::cout << "Request timeout for icmp_seq " << seq << std::endl;
+    }
+    Output::records.timeout(hostname, ipAddress, seq);
+    probeLog.timeout(0, seq, sent);
+    if (summaryIntervalMs > 0.0) {
+        windows.addLoss();
+    }
+}
+
+void PingClient::reportFailure(int seq, const SendStamp& sent, unsigned int from, FailureKind kind) {
+    char fromText[INET_ADDRSTRLEN];
+    inet_ntop(AF_INET, &from, fromText, sizeof(fromText));
+    
+    if (flood) {
+        if (Output::level >= OUTPUT_CLASSIC) {
+            std::cout << "\bE";
+        }
+    } else if (classicEnabled()) {
+        char line[160];
+        int length = snprintf(line, sizeof(line), "From %s icmp_seq=%d %s\n",
+                              fromText, seq, getFailureDescription(kind));
+        std::cout.write(line, length < (int)sizeof(line) ? length : (int)sizeof(line) - 1);
+    }
+    Output::records.failure(hostname, ipAddress, seq, fromText, getFailureName(kind));
+    probeLog.failure(0, seq, sent, kind);
+    if (summaryIntervalMs > 0.0) {
+        windows.addLoss();
+    }
+}
+
+// An ICMP error quoting an outstanding probe to our destination ends that
+// probe at once instead of leaving it to run out its deadline
+bool PingClient::acceptFailure(const ReplyView& reply) {
+    if (!isErrorFor(reply, icmpId) || reply.quotedDestination != destAddr.sin_addr.s_addr) {
         return false;
     }
     
-    std::cout << std::endl;
+    SendStamp sendTime;
+    if (!sendTimes.take(reply.quotedSequence, sendTime)) {
+        return false; // Already answered or expired
+    }
     
-    if (!resolveHost(hostname)) {
-        close(sockfd);
-        sockfd = -1;
+    FailureKind kind = classifyIcmpError(reply.type, reply.code);
+    if (traceEnabled()) {
+        std::cout << std::endl;
+    }
+    stats.addFailure(kind);
+    reportFailure(reply.quotedSequence, sendTime, reply.source, kind);
+    return true;
+}
+
+// Quiet-path match for the batched backends: no tracing, just the checks
+bool PingClient::acceptReply(const char* buffer, int length, const RecvStamp& recvTime) {
+    long long start = profile.mark();
+    ReplyView reply;
+    if (!parseReply(buffer, length, reply)) {
+        return false;
+    }
+    if (!isEchoReplyFor(reply, icmpId)) {
+        acceptFailure(reply);
         return false;
     }
     
+    SendStamp sendTime;
+    if (!sendTimes.take(reply.sequence, sendTime)) {
+        return false; // Duplicate or already expired
+    }
+    
+    double rtt = stampRttMs(sendTime, recvTime);
+    long long reportStart = profile.mark();
+    profile.record(STAGE_PARSE, reportStart - start);
+    stats.addReceived(rtt);
+    reportReply(reply.sequence, sendTime, reply.icmpLength, reply.ttl, rtt);
+    profile.record(STAGE_REPORT, profile.mark() - reportStart);
     return true;
 }
 
-void PingClient::run(int count) {
-    std::cout << std::endl;
-    printHeader("STARTING PING SEQUENCE");
+// Arrival to wakeup, from the time the receive call returned: kernel
+// stamps are CLOCK_REALTIME, the simulated network stamps the arrival in
+// CLOCK_MONOTONIC, and the user-space fallback stamp has nothing to add
+void PingClient::profileWakeup(const RecvStamp& recvTime, long long monoNs, long long wallNs) {
+    if (recvTime.hasKernel) {
+        profile.record(STAGE_WAKEUP, wallNs - StageProfile::toNs(recvTime.kernel));
+    } else if (backend == BACKEND_SIMULATED) {
+        profile.record(STAGE_WAKEUP, monoNs - StageProfile::toNs(recvTime.mono));
+    }
+}
+
+int PingClient::drainBatch(BatchIO& batch) {
+    int matched = 0;
     
-    std::cout << std::endl << "PING " << hostname << " (" << ipAddress 
-              << ") 56 bytes of data" << std::endl;
-    printInfo("Total Packets to Send", count);
-    printInfo("Interval Between Packets", "1 second");
+    for (;;) {
+        long long callStart = profile.mark();
+        int received = transport->receiveBatch(batch);
+        if (received <= 0) {
+            break;
+        }
+        
+        // One receive sample per call; wakeup per packet against one clock read
+        if (profile.isEnabled()) {
+            long long returned = StageProfile::now();
+            long long wall = timestampMode != TIMESTAMP_NONE ? StageProfile::wallNow() : 0;
+            profile.record(STAGE_RECEIVE, returned - callStart);
+            for (int i = 0; i < received; i++) {
+                profileWakeup(batch.stamp(i), returned, wall);
+            }
+        }
+        
+        for (int i = 0; i < received; i++) {
+            if (acceptReply(batch.data(i), batch.length(i), batch.stamp(i))) {
+                matched++;
+            }
+        }
+        
+        if (received < batch.getCapacity()) {
+            break;
+        }
+    }
     
-    for (int seq = 1; seq <= count; seq++) {
+    return matched;
+}
+
+bool PingClient::initialize() {
+    if (traceEnabled()) {
+        printHeader("ICMP PING - VERBOSE MODE");
+        
         std::cout << std::endl;
-        printSeparator('=', 80);
-        std::cout << "  PACKET " << seq << " OF " << count << std::endl;
-        printSeparator('=', 80);
+        printInfo("Program Version", "1.0");
+        printInfo("Target Host", hostname);
+        printInfo("Process ID", getpid());
+        printInfo("Reply Deadline", formatDouble(timeoutMs) + " ms per probe");
         
         std::cout << std::endl;
-        printSection("PACKET PREPARATION");
+    }
+    
+    if (!createSocket()) {
+        return false;
+    }
+    
+    if (traceEnabled()) {
+        std::cout << std::endl;
+    }
+    
+    if (!resolveHost(hostname)) {
+        transport->close();
+        return false;
+    }
+    
+    if (!probeLogPath.empty()) {
+        if (!probeLog.open(probeLogPath, std::vector<std::string>(1, hostname))) {
+            return false;
+        }
+        if (traceEnabled()) {
+            printInfo("Binary Probe Log", probeLogPath);
+        }
+    }
+    
+    if (!statsSegmentName.empty()) {
+        if (!statsSegment.open(statsSegmentName, std::vector<std::string>(1, hostname))) {
+            return false;
+        }
+        statsSegment.publish(0, stats, destAddr.sin_addr.s_addr);
+        if (traceEnabled()) {
+            printInfo("Statistics Segment", statsSegment.getName() + " (read with pingstat)");
+        }
+    }
+    
+    return true;
+}
+
+void PingClient::runStopAndWait(int count) {
+    pacer.start(monotonicNow());
+    
+    for (long long seq = 1; !sendingDone(seq, count); seq++) {
+        if (seq > 1 && traceEnabled()) {
+            std::cout << std::endl << "  Waiting " << formatDouble(pacer.msUntilDue(monotonicNow()))
+                      << " ms before next packet..." << std::endl;
+        }
+        std::cout.flush();
+        Output::records.flush();
+        if (summaryIntervalMs > 0.0 || statsSegment.isOpen()) {
+            // Sleep in steps, so summaries and publishes stay on time however long the interval
+            double due;
+            while (!stopRequested && (due = pacer.msUntilDue(monotonicNow())) > 0.0) {
+                sleepMs(capToPeriodic(due, monotonicNow()));
+                tickPeriodic();
+            }
+            if (stopRequested) {
+                break;
+            }
+        } else {
+            pacer.sleepUntilDue();
+        }
+        pacer.consume(monotonicNow());
+        
+        if (!sendProbe(seq, count)) {
+            continue;
+        }
+        
+        if (traceEnabled()) {
+            std::cout << std::endl;
+            printSection("PACKET RECEPTION");
+            std::cout << std::endl << "  Waiting for reply..." << std::endl;
+            printInfo("Reply Deadline", formatDouble(timeoutMs) + " ms after send");
+        }
+        
+        // Wait against the probe's own deadline; unrelated packets waking us
+        // early only shorten the next wait, they never extend it
+        unsigned short oldestSeq;
+        SendStamp sendTime;
+        while (sendTimes.oldest(oldestSeq, sendTime)) {
+            struct timespec now = monotonicNow();
+            double remaining = timeoutMs - elapsedMs(sendTime.mono, now);
+            if (remaining <= 0.0) {
+                break;
+            }
+            int ready = waitReadable(capToPeriodic(remaining, now));
+            tickPeriodic();
+            if (ready > 0) {
+                drainReplies();
+            }
+        }
+        expireProbes();
+        tickPeriodic();
+    }
+}
+
+void PingClient::runPipelined(int count) {
+    long long nextSeq = 1;
+    pacer.start(monotonicNow());
+    
+    while (!sendingDone(nextSeq, count) || !sendTimes.empty()) {
+        // Top the window up before waiting, so a slow reply never blocks later probes
+        struct timespec now = monotonicNow();
+        while (!sendingDone(nextSeq, count) && sendTimes.size() < window &&
+               sendTimes.isFree((unsigned short)nextSeq) && pacer.isDue(now)) {
+            pacer.consume(now);
+            sendProbe(nextSeq, count);
+            nextSeq++;
+        }
         
-        ICMPPacket packet;
-        packet.prepare(seq);
+        int ready = waitReadable(nextEventMs(nextSeq, count, monotonicNow()));
+        tickPeriodic();
+        if (ready > 0) {
+            drainReplies();
+        }
         
+        expireProbes();
+    }
+}
+
+void PingClient::runFlood(int count) {
+    BatchIO batch(batchSize, rxBuffer.size(), probe.getPayloadSize());
+    long long nextSeq = 1;
+    pacer.start(monotonicNow());
+    
+    for (int i = 0; i < batch.getCapacity(); i++) {
+        batch.setDestination(i, destAddr);
+    }
+    
+    while (!sendingDone(nextSeq, count) || !sendTimes.empty()) {
+        struct timespec now = monotonicNow();
+        int ready = 0;
+        long long start = profile.mark();
+        
+        while (ready < batch.getCapacity() && !sendingDone(nextSeq + ready, count) &&
+               sendTimes.size() + ready < window &&
+               sendTimes.isFree((unsigned short)(nextSeq + ready)) &&
+               pacer.isDue(now)) {
+            pacer.consume(now);
+            batch.packet(ready).build((unsigned short)(nextSeq + ready));
+            ready++;
+        }
+        
+        if (ready > 0) {
+            long long built = profile.mark();
+            SendStamp sendTime;
+            stampSend(sendTime);
+            int sent = transport->sendBatch(batch, ready);
+            long long stamped = StageProfile::toNs(sendTime.mono);
+            profile.record(STAGE_SEND, profile.mark() - stamped);
+            profile.record(STAGE_BUILD, (built - start) / ready);
+            profile.record(STAGE_PRE_SEND, stamped - built);
+            
+            if (sent < 0) {
+                if (errno != ENOBUFS && errno != EAGAIN && errno != EWOULDBLOCK) {
+                    std::cout << std::endl << "  [ERROR] sendmmsg() failed: " << strerror(errno) << std::endl;
+                    stats.addError();
+                    nextSeq++; // Give up on this probe rather than spin on a hard error
+                    pacer.cancel(ready - 1);
+                } else {
+                    pacer.cancel(ready);
+                }
+                sent = 0;
+            } else if (sent < ready) {
+                pacer.cancel(ready - sent);
+            }
+            
+            bool dots = Output::level >= OUTPUT_CLASSIC;
+            for (int i = 0; i < sent; i++) {
+                sendTimes.insert((unsigned short)(nextSeq + i), sendTime);
+                stats.addTransmitted();
+                if (dots) std::cout << '.';
+            }
+            nextSeq += sent;
+        }
+        
+        int readable = waitReadable(nextEventMs(nextSeq, count, monotonicNow()));
+        tickPeriodic();
+        if (readable > 0) {
+            drainBatch(batch);
+        }
+        
+        expireProbes();
+    }
+    
+    if (Output::level >= OUTPUT_CLASSIC) {
         std::cout << std::endl;
-        printSection("PACKET TRANSMISSION");
+    }
+}
+
+// Pipelined and flood modes over io_uring: every loop turn is one
+// io_uring_enter() that submits the queued sends and waits for the next
+// completion or deadline. Returns false, before sending anything, when the
+// kernel cannot provide the ring, so the caller can fall back to poll.
+bool PingClient::runUring(int count) {
+    UringIO ring(batchSize, rxBuffer.size(), probe.getPayloadSize());
+    if (!ring.setup(transport->getFd())) {
+        if (Output::level >= OUTPUT_CLASSIC) {
+            std::cout << "  [WARNING] io_uring unavailable (" << ring.getFailure()
+                      << "), using the poll backend" << std::endl;
+        }
+        return false;
+    }
+    
+    bool dots = flood && Output::level >= OUTPUT_CLASSIC;
+    long long nextSeq = 1;
+    pacer.start(monotonicNow());
+    
+    while (!sendingDone(nextSeq, count) || !sendTimes.empty()) {
+        struct timespec now = monotonicNow();
+        long long firstSeq = nextSeq;
+        long long start = profile.mark();
         
-        struct timeval sendTime;
-        gettimeofday(&sendTime, nullptr);
+        while (!sendingDone(nextSeq, count) && sendTimes.size() + (nextSeq - firstSeq) < window &&
+               sendTimes.isFree((unsigned short)nextSeq) && pacer.isDue(now) &&
+               ring.queueSend((unsigned short)nextSeq, destAddr)) {
+            pacer.consume(now);
+            nextSeq++;
+        }
         
-        if (!sendPacket(packet)) {
-            stats.addError();
-            sleep(1);
-            continue;
+        // The submit happens inside the wait below, right after this stamp
+        if (nextSeq > firstSeq) {
+            profile.record(STAGE_BUILD, (profile.mark() - start) / (nextSeq - firstSeq));
+            SendStamp sendTime;
+            stampSend(sendTime);
+            for (long long seq = firstSeq; seq < nextSeq; seq++) {
+                sendTimes.insert((unsigned short)seq, sendTime);
+            }
         }
         
+        // A full send ring frees up as soon as its completions are reaped
+        double waitMs = ring.canSend() ? nextEventMs(nextSeq, count, monotonicNow()) : 0.0;
+        std::cout.flush();
+        Output::records.flush();
+        if (ring.submitAndWait(waitMs) < 0) {
+            std::cout << std::endl << "  [ERROR] " << ring.getFailure() << std::endl;
+            break;
+        }
+        tickPeriodic();
+        
+        long long returned = profile.mark();
+        long long wall = profile.isEnabled() && timestampMode != TIMESTAMP_NONE ? StageProfile::wallNow() : 0;
+        UringCompletion completion;
+        while (ring.nextCompletion(completion)) {
+            if (completion.kind == UringCompletion::RECV) {
+                profileWakeup(completion.stamp, returned, wall);
+                acceptReply(completion.data, completion.length, completion.stamp);
+            } else if (completion.result >= 0) {
+                stats.addTransmitted();
+                if (dots) std::cout << '.';
+            } else {
+                // The probe never left; it must not be counted as lost
+                SendStamp unused;
+                sendTimes.take(completion.seq, unused);
+                stats.addError();
+                if (completion.result != -ENOBUFS && completion.result != -EAGAIN) {
+                    std::cout << std::endl << "  [ERROR] Send failed: "
+                              << strerror(-completion.result) << std::endl;
+                }
+            }
+        }
+        
+        expireProbes();
+    }
+    
+    if (dots) {
+        std::cout << std::endl;
+    }
+    return true;
+}
+
+int PingClient::hopOfSequence(unsigned short seq) const {
+    return (seq - 1) % maxHops + 1;
+}
+
+bool PingClient::sendHopProbe(unsigned short seq, int ttl) {
+    if (setsockopt(transport->getFd(), IPPROTO_IP, IP_TTL, &ttl, sizeof(ttl)) < 0) {
+        std::cout << "  [ERROR] Cannot set IP_TTL " << ttl << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+    
+    if (traceEnabled()) {
         std::cout << std::endl;
-        printSection("PACKET RECEPTION");
+        printSection("HOP " + std::to_string(ttl) + " PROBE");
+        printInfo("IP Time To Live", ttl);
+        printInfo("Sequence Number", seq);
+    }
+    probe.build(seq);
+    
+    SendStamp sendTime;
+    if (!sendPacket(probe, sendTime)) {
+        return false;
+    }
+    sendTimes.insert(seq, sendTime);
+    hopStats[ttl - 1].addTransmitted();
+    return true;
+}
+
+// Routers short of the target answer with Time Exceeded quoting the probe;
+// the target itself answers with an Echo Reply or, at the end of a broken
+// path, an unreachable error. Any of them settles the probe's hop.
+bool PingClient::acceptHopReply(const ReplyView& reply, const RecvStamp& recvTime) {
+    unsigned short seq;
+    if (isEchoReplyFor(reply, icmpId) && reply.source == destAddr.sin_addr.s_addr) {
+        seq = reply.sequence;
+    } else if (isErrorFor(reply, icmpId) && reply.quotedDestination == destAddr.sin_addr.s_addr) {
+        seq = reply.quotedSequence;
+    } else {
+        return false;
+    }
+    
+    SendStamp sendTime;
+    if (!sendTimes.take(seq, sendTime)) {
+        return false; // Duplicate or already expired
+    }
+    
+    int hop = hopOfSequence(seq);
+    PingStatistics& hopStat = hopStats[hop - 1];
+    if (hopAddress[hop - 1] == 0) {
+        hopAddress[hop - 1] = reply.source;
+    }
+    
+    char fromText[INET_ADDRSTRLEN];
+    inet_ntop(AF_INET, &reply.source, fromText, sizeof(fromText));
+    double rtt = stampRttMs(sendTime, recvTime);
+    
+    if (reply.type == ICMP_ECHOREPLY || reply.type == ICMP_TIME_EXCEEDED) {
+        hopStat.addReceived(rtt);
+        if (reply.type == ICMP_ECHOREPLY) {
+            reached = true;
+            if (pathEnd == 0 || hop < pathEnd) {
+                pathEnd = hop;
+            }
+        }
+        if (traceEnabled()) {
+            std::cout << "  [HOP] ttl=" << hop << " from " << fromText << " ("
+                      << getIcmpTypeName(reply.type) << ") time=" << formatDouble(rtt) << " ms" << std::endl;
+        }
+        Output::records.hop(hostname, ipAddress, seq, hop, fromText, rtt);
+    } else {
+        FailureKind kind = classifyIcmpError(reply.type, reply.code);
+        hopStat.addFailure(kind);
+        if (!reached && (pathEnd == 0 || hop < pathEnd)) {
+            pathEnd = hop; // Nothing past an unreachable error will answer
+        }
+        if (traceEnabled()) {
+            std::cout << "  [HOP] ttl=" << hop << " from " << fromText << " ("
+                      << getFailureDescription(kind) << ")" << std::endl;
+        }
+        Output::records.failure(hostname, ipAddress, seq, fromText, getFailureName(kind));
+    }
+    return true;
+}
+
+void PingClient::drainPathReplies() {
+    char* buffer = &rxBuffer[0];
+    struct sockaddr_in fromAddr;
+    RecvStamp recvTime;
+    
+    for (;;) {
+        int receivedBytes = transport->receive(buffer, rxBuffer.size(), &fromAddr, recvTime);
+        if (receivedBytes < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                std::cout << "  [ERROR] Receive error: " << strerror(errno) << std::endl;
+            }
+            return;
+        }
         
-        double rtt;
-        if (receiveReply(seq, sendTime, rtt)) {
-            stats.addReceived(rtt);
+        ReplyView reply;
+        if (!parseReply(buffer, receivedBytes, reply)) {
+            continue;
+        }
+        if (maxHops > 0) {
+            acceptHopReply(reply, recvTime);
         } else {
-            stats.addError();
+            acceptSizedReply(reply, recvTime);
+        }
+    }
+}
+
+// Waits until every probe of the round is settled or the oldest has run
+// out its deadline; the round's probes all left together
+void PingClient::awaitRound() {
+    unsigned short oldestSeq;
+    SendStamp sendTime;
+    while (sendTimes.oldest(oldestSeq, sendTime)) {
+        double remaining = timeoutMs - elapsedMs(sendTime.mono, monotonicNow());
+        if (remaining <= 0.0) {
+            break;
+        }
+        if (waitReadable(remaining) > 0) {
+            drainPathReplies();
         }
+    }
+}
+
+// Each round sends TTL 1..maxHops back to back, so the whole path answers
+// within one round trip to its farthest responder instead of one timeout
+// per silent hop. Once the end of the path is known, later rounds stop there.
+void PingClient::runTraceroute(int count) {
+    // Sequence numbers advance by whole rounds so seq % maxHops keeps the TTL
+    int roundsInSpace = (ProbeTable::SEQ_SPACE - 1) / maxHops;
+    pacer.start(monotonicNow());
+    
+    for (int round = 0; round < count; round++) {
+        std::cout.flush();
+        Output::records.flush();
+        pacer.sleepUntilDue();
+        pacer.consume(monotonicNow());
+        
+        int lastHop = pathEnd > 0 ? pathEnd : maxHops;
+        int base = (round % roundsInSpace) * maxHops;
+        for (int ttl = 1; ttl <= lastHop; ttl++) {
+            sendHopProbe((unsigned short)(base + ttl), ttl);
+        }
+        
+        awaitRound();
         
-        if (seq < count) {
-            std::cout << std::endl << "  Waiting 1 second before next packet..." << std::endl;
-            sleep(1);
+        // Whatever is still outstanding is lost
+        unsigned short oldestSeq;
+        SendStamp sendTime;
+        while (sendTimes.oldest(oldestSeq, sendTime)) {
+            sendTimes.erase(oldestSeq);
+            if (traceEnabled()) {
+                std::cout << "  [TIMEOUT] ttl=" << hopOfSequence(oldestSeq) << " no answer within "
+                          << formatDouble(timeoutMs) << " ms" << std::endl;
+            }
+            Output::records.timeout(hostname, ipAddress, oldestSeq);
+        }
+    }
+}
+
+void PingClient::printHopTable() const {
+    int lastHop = pathEnd > 0 ? pathEnd : maxHops;
+    
+    // Trailing hops that never answered add nothing once the target was missed
+    while (pathEnd == 0 && lastHop > 1 && hopAddress[lastHop - 1] == 0) {
+        lastHop--;
+    }
+    
+    std::cout << std::endl << "--- " << hostname << " path statistics ---" << std::endl;
+    for (int hop = 1; hop <= lastHop; hop++) {
+        char label[48];
+        char address[INET_ADDRSTRLEN] = "*";
+        if (hopAddress[hop - 1] != 0) {
+            inet_ntop(AF_INET, &hopAddress[hop - 1], address, sizeof(address));
+        }
+        snprintf(label, sizeof(label), "%2d  %s", hop, address);
+        hopStats[hop - 1].printSummaryLine(label);
+    }
+    
+    if (reached) {
+        std::cout << "  " << ipAddress << " reached in " << pathEnd << " hops" << std::endl;
+    } else if (pathEnd > 0) {
+        std::cout << "  " << ipAddress << " unreachable beyond hop " << pathEnd << std::endl;
+    } else {
+        std::cout << "  " << ipAddress << " not reached within " << maxHops << " hops" << std::endl;
+    }
+}
+
+bool PingClient::sendSizedProbe(unsigned short seq, int size) {
+    ICMPPacket packet(size - MIN_PROBE_SIZE);
+    packet.build(seq);
+    
+    SendStamp sendTime;
+    stampSend(sendTime);
+    int sent = transport->send((const char*)packet.getData(), packet.getSize(), destAddr);
+    if (sent < 0) {
+        if (errno == EMSGSIZE) {
+            // Larger than our own interface's MTU: too big without leaving the host
+            if (mtuSearching) {
+                mtuBound = std::min(mtuBound, size - 1);
+            }
+            if (traceEnabled()) {
+                std::cout << "  [MTU] " << size << " bytes exceeds the local interface MTU" << std::endl;
+            }
+        } else {
+            std::cout << "  [ERROR] Send of " << size << " bytes failed: " << strerror(errno) << std::endl;
         }
+        return false;
     }
     
+    sendTimes.insert(seq, sendTime);
+    if (!mtuSearching) {
+        sizeStats[size].addTransmitted();
+    }
+    return true;
+}
+
+bool PingClient::acceptSizedReply(const ReplyView& reply, const RecvStamp& recvTime) {
+    unsigned short seq;
+    if (isEchoReplyFor(reply, icmpId) && reply.source == destAddr.sin_addr.s_addr) {
+        seq = reply.sequence;
+    } else if (isErrorFor(reply, icmpId) && reply.quotedDestination == destAddr.sin_addr.s_addr) {
+        seq = reply.quotedSequence;
+    } else {
+        return false;
+    }
+    
+    size_t index = (unsigned short)(seq - roundBase);
+    SendStamp sendTime;
+    if (index >= roundSizes.size() || !sendTimes.take(seq, sendTime)) {
+        return false; // Not from this round, duplicate or already expired
+    }
+    int size = roundSizes[index];
+    
+    if (reply.type == ICMP_ECHOREPLY) {
+        double rtt = stampRttMs(sendTime, recvTime);
+        mtuPassed = std::max(mtuPassed, size);
+        if (!mtuSearching) {
+            sizeStats[size].addReceived(rtt);
+        }
+        if (traceEnabled()) {
+            std::cout << "  [MTU] " << size << " bytes answered, time=" << formatDouble(rtt) << " ms" << std::endl;
+        }
+        Output::records.reply(hostname, ipAddress, seq, reply.icmpLength, reply.ttl, rtt);
+        return true;
+    }
+    
+    char fromText[INET_ADDRSTRLEN];
+    inet_ntop(AF_INET, &reply.source, fromText, sizeof(fromText));
+    FailureKind kind = classifyIcmpError(reply.type, reply.code);
+    if (kind == FAILURE_FRAGMENTATION_NEEDED) {
+        // RFC 1191 routers also name the MTU of the link that refused it
+        int nextHopMtu = ntohs(reply.icmp->un.frag.mtu);
+        mtuBound = std::min(mtuBound, size - 1);
+        if (nextHopMtu >= MIN_PROBE_SIZE && nextHopMtu < size) {
+            mtuBound = std::min(mtuBound, nextHopMtu);
+            reportedMtu = nextHopMtu;
+            mtuReporter = reply.source;
+        }
+        if (traceEnabled()) {
+            std::cout << "  [MTU] " << size << " bytes refused by " << fromText
+                      << ", next-hop MTU " << nextHopMtu << std::endl;
+        }
+    } else {
+        mtuUnreachable = true; // Unreachable at any size; searching further is pointless
+        mtuFailure = kind;
+        mtuReporter = reply.source;
+        if (traceEnabled()) {
+            std::cout << "  [MTU] " << size << " bytes: " << getFailureDescription(kind)
+                      << " from " << fromText << std::endl;
+        }
+    }
+    if (!mtuSearching) {
+        sizeStats[size].addFailure(kind);
+    }
+    Output::records.failure(hostname, ipAddress, seq, fromText, getFailureName(kind));
+    return true;
+}
+
+void PingClient::runSizeRound(const std::vector<int>& sizes) {
+    roundBase = (unsigned short)(roundBase + roundSizes.size());
+    roundSizes = sizes;
+    
+    for (size_t i = 0; i < sizes.size(); i++) {
+        sendSizedProbe((unsigned short)(roundBase + i), sizes[i]);
+    }
+    awaitRound();
+    
+    unsigned short oldestSeq;
+    SendStamp sendTime;
+    while (sendTimes.oldest(oldestSeq, sendTime)) {
+        int size = roundSizes[(unsigned short)(oldestSeq - roundBase)];
+        sendTimes.erase(oldestSeq);
+        // Silence above the largest answered size is how a PMTU black hole looks
+        if (mtuSearching && size > mtuPassed) {
+            mtuBound = std::min(mtuBound, size - 1);
+        }
+        if (traceEnabled()) {
+            std::cout << "  [TIMEOUT] " << size << " bytes, no answer within "
+                      << formatDouble(timeoutMs) << " ms" << std::endl;
+        }
+        Output::records.timeout(hostname, ipAddress, oldestSeq);
+    }
+    
+    // Multipath can answer a size another path refused; the answer wins
+    if (mtuBound < mtuPassed) {
+        mtuBound = mtuPassed;
+    }
+}
+
+// Search rounds send SIZES_PER_ROUND sizes spread over the still-open
+// interval at once, with DF set, so each round trip narrows it about
+// ninefold; a next-hop MTU reported by a router is tried directly. Once it
+// converges, count sweep rounds measure RTT against packet size.
+void PingClient::runPathMtu(int count) {
+    int discover = IP_PMTUDISC_PROBE; // Sets DF but ignores the kernel's cached PMTU
+    if (setsockopt(transport->getFd(), IPPROTO_IP, IP_MTU_DISCOVER, &discover, sizeof(discover)) < 0) {
+        std::cout << "  [ERROR] Cannot set IP_MTU_DISCOVER: " << strerror(errno) << std::endl;
+        return;
+    }
+    rxBuffer.resize(std::max(rxBuffer.size(), ICMPPacket::getReplyBufferSize(mtuLimit)));
+    
+    // A round of near-MTU replies arrives back to back; a drop would read as a black hole
+    int bufSize = SIZES_PER_ROUND * 4 * (mtuLimit + 512);
+    if (setsockopt(transport->getFd(), SOL_SOCKET, SO_RCVBUFFORCE, &bufSize, sizeof(bufSize)) < 0) {
+        setsockopt(transport->getFd(), SOL_SOCKET, SO_RCVBUF, &bufSize, sizeof(bufSize));
+    }
+    
+    mtuSearching = true;
+    mtuPassed = 0;
+    mtuBound = mtuLimit;
+    
+    for (int round = 1; round <= MAX_MTU_ROUNDS; round++) {
+        int low = std::max(mtuPassed, MIN_PROBE_SIZE - 1);
+        if (low >= mtuBound) {
+            break;
+        }
+        
+        std::vector<int> sizes;
+        if (mtuBound - low <= SIZES_PER_ROUND) {
+            for (int size = low + 1; size <= mtuBound; size++) {
+                sizes.push_back(size);
+            }
+        } else {
+            for (int i = 1; i <= SIZES_PER_ROUND; i++) {
+                sizes.push_back(low + (int)((long)(mtuBound - low) * i / SIZES_PER_ROUND));
+            }
+            // The first round also tries the minimum MTU, so a silent target is told apart
+            // from a tiny PMTU
+            if (round == 1) {
+                sizes.push_back((int)MIN_IPV4_MTU);
+            }
+            if (reportedMtu > low && reportedMtu < mtuBound) {
+                sizes.push_back(reportedMtu);
+            }
+            std::sort(sizes.begin(), sizes.end());
+            sizes.erase(std::unique(sizes.begin(), sizes.end()), sizes.end());
+        }
+        
+        runSizeRound(sizes);
+        if (classicEnabled()) {
+            std::cout << "  round " << round << ": " << sizes.size() << " sizes " << sizes.front()
+                      << "-" << sizes.back() << " bytes, largest answered " << mtuPassed
+                      << ", upper bound " << mtuBound << std::endl;
+        }
+        if (mtuPassed == 0 || mtuUnreachable) {
+            break;
+        }
+    }
+    
+    if (mtuPassed == 0 || mtuUnreachable) {
+        return; // Nothing to sweep
+    }
+    
+    mtuSearching = false;
+    std::vector<int> sweep;
+    for (int i = 0; i < SIZES_PER_ROUND; i++) {
+        sweep.push_back(MIN_PROBE_SIZE + (int)((long)(mtuPassed - MIN_PROBE_SIZE) * i / (SIZES_PER_ROUND - 1)));
+    }
+    sweep.erase(std::unique(sweep.begin(), sweep.end()), sweep.end());
+    
+    pacer.start(monotonicNow());
+    for (int round = 0; round < count; round++) {
+        std::cout.flush();
+        Output::records.flush();
+        pacer.sleepUntilDue();
+        pacer.consume(monotonicNow());
+        runSizeRound(sweep);
+    }
+}
+
+void PingClient::printMtuTable() const {
+    std::cout << std::endl << "--- " << hostname << " path MTU ---" << std::endl;
+    char fromText[INET_ADDRSTRLEN];
+    inet_ntop(AF_INET, &mtuReporter, fromText, sizeof(fromText));
+    if (mtuUnreachable) {
+        std::cout << "  " << getFailureDescription(mtuFailure) << " from " << fromText << std::endl;
+        return;
+    }
+    if (mtuPassed == 0) {
+        std::cout << "  no answer, not even at the " << MIN_IPV4_MTU << "-byte minimum MTU" << std::endl;
+        return;
+    }
+    
+    std::cout << "  path MTU " << mtuPassed << " bytes";
+    if (reportedMtu > 0) {
+        std::cout << " (" << fromText << " reported next-hop MTU " << reportedMtu << ")";
+    } else if (mtuPassed == mtuLimit) {
+        std::cout << " (search limit reached)";
+    }
     std::cout << std::endl;
-    stats.printDetailedStatistics(hostname);
+    
+    // Least-squares slope of the minimum RTT over size, the per-byte
+    // serialization cost; the minimum filters out queueing delay
+    double n = 0.0, sumX = 0.0, sumY = 0.0, sumXX = 0.0, sumXY = 0.0;
+    for (std::map<int, PingStatistics>::const_iterator it = sizeStats.begin(); it != sizeStats.end(); ++it) {
+        char label[32];
+        snprintf(label, sizeof(label), "%5d bytes", it->first);
+        it->second.printSummaryLine(label);
+        
+        if (it->second.getReceived() > 0) {
+            double x = it->first;
+            double y = it->second.getMinTime();
+            n += 1.0;
+            sumX += x;
+            sumY += y;
+            sumXX += x * x;
+            sumXY += x * y;
+        }
+    }
+    
+    double denominator = n * sumXX - sumX * sumX;
+    if (n >= 2.0 && denominator > 0.0) {
+        double slopeMs = (n * sumXY - sumX * sumY) / denominator;
+        if (slopeMs * 1000.0 >= 0.00005) {
+            // Each byte crosses the path twice, out in the request and back in the reply
+            std::cout << "  RTT slope " << std::fixed << std::setprecision(4) << slopeMs * 1000.0
+                      << " us/byte (~" << std::setprecision(1) << 16.0 / (slopeMs * 1000.0)
+                      << " Mbit/s bottleneck)" << std::endl;
+        } else {
+            std::cout << "  RTT slope below clock resolution (no measurable per-byte cost)" << std::endl;
+        }
+    }
+}
+
+void PingClient::run(int count) {
+    std::string intervalText = interval > 0.0 ? formatDouble(interval) + " ms"
+                                              : std::string("none (window-limited)");
+    
+    if (maxHops > 0) {
+        if (traceEnabled()) {
+            std::cout << std::endl;
+            printHeader("STARTING PARALLEL TRACEROUTE");
+            printInfo("Maximum Hops", maxHops);
+            printInfo("Rounds", count);
+            printInfo("Interval Between Rounds", intervalText);
+        } else if (Output::level >= OUTPUT_CLASSIC) {
+            std::cout << "traceroute to " << hostname << " (" << ipAddress << "), " << maxHops
+                      << " hops max, " << probe.getSize() + sizeof(struct iphdr) << " byte packets, "
+                      << count << " probes per hop" << std::endl;
+        }
+        runTraceroute(count);
+        printHopTable();
+        return;
+    }
+    
+    if (mtuLimit > 0) {
+        if (traceEnabled()) {
+            std::cout << std::endl;
+            printHeader("STARTING PATH MTU DISCOVERY");
+            printInfo("Largest Size Tried", std::to_string(mtuLimit) + " bytes");
+            printInfo("Sizes Per Round", SIZES_PER_ROUND);
+            printInfo("Sweep Rounds", count);
+        } else if (Output::level >= OUTPUT_CLASSIC) {
+            std::cout << "PMTU discovery to " << hostname << " (" << ipAddress << "), sizes "
+                      << MIN_PROBE_SIZE << "-" << mtuLimit << " bytes, " << SIZES_PER_ROUND
+                      << " per round" << std::endl;
+        }
+        runPathMtu(count);
+        printMtuTable();
+        return;
+    }
+    
+    if (traceEnabled()) {
+        std::cout << std::endl;
+        printHeader("STARTING PING SEQUENCE");
+        
+        std::cout << std::endl << "PING " << hostname << " (" << ipAddress 
+                  << ") " << probe.getPayloadSize() << " bytes of data" << std::endl;
+        if (count > 0) {
+            printInfo("Total Packets to Send", count);
+        } else {
+            printInfo("Total Packets to Send", "unlimited (until stopped)");
+        }
+        
+        if (backend == BACKEND_IO_URING && (flood || window > 1)) {
+            printInfo("I/O Backend", "io_uring (multishot recvmsg, batched sendmsg)");
+        } else {
+            if (backend == BACKEND_SIMULATED) {
+                printInfo("I/O Backend", "simulated (in-process echo responder)");
+            }
+            if (flood) {
+                printInfo("Mode", "flood (batched sendmmsg/recvmmsg)");
+                printInfo("Batch Size", batchSize);
+            }
+        }
+        if (flood || window > 1) {
+            printInfo("Probes In Flight (max)", window);
+        }
+        printInfo("Interval Between Packets", intervalText);
+        if (pacer.getRateLimit() > 0.0) {
+            printInfo("Rate Limit", formatDouble(pacer.getRateLimit(), 1) + " probes/s");
+        }
+        if (flood) {
+            std::cout << std::endl;
+        }
+    } else if (Output::level >= OUTPUT_CLASSIC) {
+        std::cout << "PING " << hostname << " (" << ipAddress << ") " << probe.getPayloadSize()
+                  << "(" << probe.getSize() + sizeof(struct iphdr) << ") bytes of data." << std::endl;
+    }
+    
+    if (summaryIntervalMs > 0.0) {
+        struct timespec now = monotonicNow();
+        windows.advance(now);
+        nextSummary = addMs(now, summaryIntervalMs);
+        std::string period = formatDouble(summaryIntervalMs / 1000.0, 1) + " s";
+        if (traceEnabled()) {
+            printInfo("Window Summaries", "every " + period + ", last 10 s / 1 min / 5 min");
+        } else if (Output::level >= OUTPUT_CLASSIC) {
+            std::cout << "Window summaries every " << period
+                      << ": answered/probes, loss, rtt min/avg/max/p99 over 10s, 1m and 5m" << std::endl;
+        }
+    }
+    
+    // runUring() declines before sending anything when io_uring is unavailable
+    bool ringDone = backend == BACKEND_IO_URING && (flood || window > 1) && runUring(count);
+    
+    if (!ringDone) {
+        if (flood) {
+            runFlood(count);
+        } else if (window > 1) {
+            runPipelined(count);
+        } else {
+            runStopAndWait(count);
+        }
+    }
+    
+    if (summaryIntervalMs > 0.0) {
+        windows.advance(monotonicNow());
+        printWindows();
+    }
+    if (statsSegment.isOpen()) {
+        publishStats(monotonicNow(), true);
+    }
+    
+    if (traceEnabled()) {
+        std::cout << std::endl;
+        stats.printDetailedStatistics(hostname);
+    } else {
+        stats.printClassicSummary(hostname);
+    }
+    transport->printSummary();
+    if (profile.isEnabled()) {
+        // Stages between the send stamp and the receive stamp inflate the RTT
+        bool inRtt[STAGE_COUNT] = {false};
+        inRtt[STAGE_SEND] = true;
+        if (timestampMode == TIMESTAMP_NONE && backend != BACKEND_SIMULATED) {
+            inRtt[STAGE_WAKEUP] = true;
+            inRtt[STAGE_RECEIVE] = true;
+        }
+        profile.printReport(stats, inRtt);
+    }
+    Output::records.summary(hostname, ipAddress, stats);
+}
+
+void PingClient::requestStop() {
+    stopRequested = 1;
 }
 
 const PingStatistics& PingClient::getStatistics() const {
     return stats;
 }
+
+const StageProfile& PingClient::getStageProfile() const {
+    return profile;
+}
+
+const WindowStats& PingClient::getWindowStats() const {
+    return windows;
+}
@@ -3,34 +3,175 @@
 
 #include "PingStatistics.hpp"
 #include "ICMPPacket.hpp"
+#include "Timestamp.hpp"
+#include "ProbeTable.hpp"
+#include "BatchIO.hpp"
+#include "Pacer.hpp"
+#include "UringIO.hpp"
+#include "ReplyView.hpp"
+#include "ProbeLog.hpp"
+#include "SimulatedTransport.hpp"
+#include "StageProfile.hpp"
+#include "WindowStats.hpp"
+#include "StatsSegment.hpp"
+#include <map>
+#include <memory>
 #include <string>
+#include <vector>
 #include <sys/socket.h>
 #include <netinet/ip.h>
 #include <arpa/inet.h>
-#include <sys/time.h>
+#include <signal.h>
+
+enum IoBackend {
+    BACKEND_POLL,       // ppoll() plus sendto()/recvmsg() or the mmsg batch calls
+    BACKEND_IO_URING,   // Multishot receive and batched sends through io_uring
+    BACKEND_SIMULATED   // In-process SimulatedTransport: no socket, no root
+};
+
+struct PingOptions {
+    double timeoutMs;   // Per-probe reply deadline, measured from its send time
+    int window;         // Probes allowed in flight at once
+    double intervalMs;  // Gap between probes; negative selects the mode default
+    bool flood;         // Batched sendmmsg()/recvmmsg() high-rate mode
+    int batchSize;      // Packets per sendmmsg()/recvmmsg() call in flood mode
+    int payloadSize;    // ICMP payload bytes (0 - 65507)
+    double rateLimit;   // Token-bucket cap in probes per second, 0 = none
+    double burst;       // Token-bucket depth in probes, 0 = one millisecond's worth
+    double jitter;      // Random extra delay per probe, as a fraction of the interval
+    IoBackend backend;  // Transport for the pipelined and flood modes
+    int maxHops;        // Traceroute mode when > 0: TTLs 1..maxHops probed at once
+    int mtuLimit;       // Path MTU mode when > 0: largest IP packet size to try
+    std::string probeLogPath;   // Binary per-probe log (-B), empty for none
+    SimulationConfig simulation;    // Network behavior for BACKEND_SIMULATED
+    bool profileStages; // Per-stage self-overhead histograms (-P)
+    double summaryIntervalMs;   // Daemon mode when > 0: sliding-window summary period (-D)
+    std::string statsSegmentName;   // Live statistics shared-memory segment (-E), empty for none
+
+    PingOptions() : timeoutMs(2000.0), window(1), intervalMs(-1.0), flood(false), batchSize(64),
+                    payloadSize((int)ICMPPacket::DEFAULT_PAYLOAD_SIZE), rateLimit(0.0),
+                    burst(0.0), jitter(0.0), backend(BACKEND_POLL), maxHops(0), mtuLimit(0),
+                    profileStages(false), summaryIntervalMs(0.0) {}
+};
 
 class PingClient {
 private:
-    int sockfd;
+    static const int FLOOD_DEFAULT_WINDOW = 4096;
+    static const int MAX_TTL = 255;
+    static const int MIN_PROBE_SIZE = 28;       // IP and ICMP headers, empty payload
+    static const int MIN_IPV4_MTU = 68;         // RFC 791: every path must carry this
+    static const int SIZES_PER_ROUND = 8;
+    static const int MAX_MTU_ROUNDS = 32;
+
+    std::unique_ptr<Transport> transport;
     struct sockaddr_in destAddr;
     std::string hostname;
     std::string ipAddress;
-    int timeout;
+    double timeoutMs;
+    int window;
+    double interval;
+    bool flood;
+    int batchSize;
+    IoBackend backend;
+    unsigned short icmpId;
+    TimestampMode timestampMode;
     PingStatistics stats;
+    ProbeTable sendTimes;
+    Pacer pacer;
+    ICMPPacket probe;
+    std::vector<char> rxBuffer;
+    std::string probeLogPath;
+    ProbeLog probeLog;
+    StageProfile profile;
+
+    // Daemon mode: windows fed by every probe outcome, summarized on a
+    // fixed period; requestStop() ends the run from a signal handler
+    static volatile sig_atomic_t stopRequested;
+    double summaryIntervalMs;
+    struct timespec nextSummary;
+    WindowStats windows;
+
+    // Live statistics for other processes, republished at most every
+    // StatsSegment::PUBLISH_INTERVAL_MS while the counters move
+    std::string statsSegmentName;
+    StatsSegment statsSegment;
+    struct timespec nextPublish;
+    long long publishedEvents;              // Probe outcomes in the last publish
+
+    // Traceroute mode: one round sends every TTL, and the TTL is recovered
+    // from the sequence number the reply or the quoted probe carries
+    int maxHops;
+    int pathEnd;                            // Lowest TTL answered by the target or an
+                                            // unreachable error, 0 until one arrives
+    bool reached;                           // The target itself answered
+    std::vector<PingStatistics> hopStats;
+    std::vector<unsigned int> hopAddress;   // First responder per TTL, network order
+
+    // Path MTU mode: each round sends one probe per size, and the size is
+    // recovered from the sequence's offset within the round
+    int mtuLimit;
+    int mtuPassed;                          // Largest IP packet size answered, 0 if none
+    int mtuBound;                           // Largest size not yet known to be too big
+    int reportedMtu;                        // Next-hop MTU from Fragmentation Needed, 0 if none
+    unsigned int mtuReporter;               // Router that sent it, network order
+    bool mtuUnreachable;                    // A non-MTU ICMP error ended the search
+    FailureKind mtuFailure;                 // Which one; reported by mtuReporter
+    unsigned short roundBase;               // Sequence of the round's first probe
+    std::vector<int> roundSizes;            // IP packet size of each probe in the round
+    bool mtuSearching;                      // Search rounds move the bounds; sweep rounds
+                                            // fill sizeStats
+    std::map<int, PingStatistics> sizeStats;    // RTT as a function of packet size
 
     bool createSocket();
     bool resolveHost(const std::string& host);
-    double calculateRTT(const struct timeval& start, const struct timeval& end);
-    bool sendPacket(const ICMPPacket& packet);
-    bool receiveReply(int expectedSeq, struct timeval sendTime, double& rtt);
+    bool sendPacket(const ICMPPacket& packet, SendStamp& sendTime);
+    bool receiveReply(int& seq, double& rtt);
+    void drainReplies();
+    bool sendProbe(long long seq, int count);
+    bool sendingDone(long long nextSeq, int count) const;
+    int expireProbes();
+    double nextEventMs(long long nextSeq, int count, const struct timespec& now);
+    double capToPeriodic(double waitMs, const struct timespec& now) const;
+    bool publishPending() const;
+    void publishStats(const struct timespec& now, bool force);
+    void tickPeriodic();
+    void printWindows();
+    int waitReadable(double waitMs);
+    bool acceptReply(const char* buffer, int length, const RecvStamp& recvTime);
+    bool acceptFailure(const ReplyView& reply);
+    int drainBatch(BatchIO& batch);
+    void profileWakeup(const RecvStamp& recvTime, long long monoNs, long long wallNs);
+    void reportReply(int seq, const SendStamp& sent, int bytes, int ttl, double rtt);
+    void reportTimeout(int seq, const SendStamp& sent);
+    void reportFailure(int seq, const SendStamp& sent, unsigned int from, FailureKind kind);
+    void runStopAndWait(int count);
+    void runPipelined(int count);
+    void runFlood(int count);
+    bool runUring(int count);
+    int hopOfSequence(unsigned short seq) const;
+    bool sendHopProbe(unsigned short seq, int ttl);
+    bool acceptHopReply(const ReplyView& reply, const RecvStamp& recvTime);
+    void drainPathReplies();
+    void awaitRound();
+    void runTraceroute(int count);
+    void printHopTable() const;
+    bool sendSizedProbe(unsigned short seq, int size);
+    bool acceptSizedReply(const ReplyView& reply, const RecvStamp& recvTime);
+    void runSizeRound(const std::vector<int>& sizes);
+    void runPathMtu(int count);
+    void printMtuTable() const;
 
 public:
-    PingClient(const std::string& host, int timeoutSec = 2);
+    PingClient(const std::string& host, const PingOptions& options = PingOptions());
     ~PingClient();
 
     bool initialize();
+    // count 0 keeps probing until requestStop()
     void run(int count = 4);
+    static void requestStop();
     const PingStatistics& getStatistics() const;
+    const StageProfile& getStageProfile() const;
+    const WindowStats& getWindowStats() const;
 };
 
 #endif
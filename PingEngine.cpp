@@ -0,0 +1,692 @@
+#include "PingEngine.hpp"
+#include "ICMPPacket.hpp"
+#include "utils.hpp"
+#include "SocketFilter.hpp"
+#include "Output.hpp"
+#include "ReplyView.hpp"
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/ip.h>
+#include <netinet/ip_icmp.h>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <cerrno>
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+
+volatile sig_atomic_t PingEngine::stopRequested = 0;
+int PingEngine::stopFd = -1;
+
+PingEngine::PingEngine(double timeout, double intervalMs, size_t payloadSize)
+    : sockfd(-1), epollfd(-1), timerfd(-1), timeoutMs(timeout > 0.0 ? timeout : 2000.0),
+      interval(intervalMs > 0.0 ? intervalMs : 1000.0),
+      timestampMode(TIMESTAMP_NONE),
+      nextSeq(1), id((unsigned short)getpid()), probes(SEQ_SPACE), probe(payloadSize),
+      rxBatch(64, ICMPPacket::getReplyBufferSize(probe.getPayloadSize())), wheel(0.1),
+      dueHead(0), dueCount(0), inFlightCount(0), statsSegment(nullptr), statsFirstSlot(0),
+      statsSlotStride(1), publishedEvents(0), resolverThreads(Resolver::DEFAULT_THREADS),
+      resolver(resolverThreads), aggregator(nullptr), shardIndex(0), announce(true) {
+    memset(&startTime, 0, sizeof(startTime));
+    memset(&nextPublish, 0, sizeof(nextPublish));
+    memset(&endTime, 0, sizeof(endTime));
+    memset(&armedDeadline, 0, sizeof(armedDeadline));
+    for (size_t i = 0; i < probes.size(); i++) {
+        probes[i].active = false;
+    }
+}
+
+PingEngine::~PingEngine() {
+    if (timerfd >= 0) {
+        close(timerfd);
+    }
+    if (epollfd >= 0) {
+        close(epollfd);
+    }
+    if (sockfd >= 0) {
+        close(sockfd);
+    }
+}
+
+void PingEngine::setRateLimit(double perSecond, double burst) {
+    limiter.setRateLimit(perSecond, burst);
+}
+
+void PingEngine::setResolverThreads(int threads) {
+    resolverThreads = threads;
+    resolver.setThreadLimit(threads);
+}
+
+void PingEngine::setProbeLog(const std::string& path) {
+    probeLogPath = path;
+}
+
+void PingEngine::setStatsSegment(const std::string& name) {
+    statsSegmentName = name;
+}
+
+void PingEngine::attachStatsSegment(StatsSegment* segment, size_t firstSlot, size_t slotStride) {
+    statsSegment = segment;
+    statsFirstSlot = firstSlot;
+    statsSlotStride = slotStride;
+}
+
+void PingEngine::addTarget(const std::string& host, double intervalMs, double timeout) {
+    Target target;
+    target.hostname = host;
+    target.intervalMs = intervalMs > 0.0 ? intervalMs : interval;
+    target.timeoutMs = timeout > 0.0 ? timeout : timeoutMs;
+    memset(&target.addr, 0, sizeof(target.addr));
+    targets.push_back(target);
+}
+
+void PingEngine::setShard(StatsAggregator* shardAggregator, int shard, unsigned short icmpId) {
+    aggregator = shardAggregator;
+    shardIndex = shard;
+    id = icmpId;
+    probe.setId(icmpId);
+    announce = false;
+}
+
+size_t PingEngine::getTargetCount() const {
+    return targets.size();
+}
+
+bool PingEngine::createSocket() {
+    if (traceEnabled()) {
+        printSection("SOCKET CREATION");
+    }
+
+    sockfd = socket(AF_INET, SOCK_RAW, IPPROTO_ICMP);
+    if (sockfd < 0) {
+        std::cout << "  [FAILED] Cannot create socket" << std::endl;
+        std::cout << "  Error Message: " << strerror(errno) << std::endl;
+        std::cout << "  Note: Root privileges required for raw sockets" << std::endl;
+        return false;
+    }
+
+    // A sweep answers thousands of probes in a burst; give the kernel room to queue them
+    int bufSize = 32 * 1024 * 1024;
+    if (setsockopt(sockfd, SOL_SOCKET, SO_RCVBUFFORCE, &bufSize, sizeof(bufSize)) < 0) {
+        setsockopt(sockfd, SOL_SOCKET, SO_RCVBUF, &bufSize, sizeof(bufSize));
+    }
+    timestampMode = enableKernelTimestamps(sockfd);
+    bool filtered = attachReplyFilter(sockfd, id);
+    if (filtered) {
+        flushSocket(sockfd);
+    }
+
+    epollfd = epoll_create1(0);
+    if (epollfd < 0) {
+        std::cout << "  [FAILED] Cannot create epoll instance: " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.fd = sockfd;
+    if (epoll_ctl(epollfd, EPOLL_CTL_ADD, sockfd, &ev) < 0) {
+        std::cout << "  [FAILED] Cannot register socket with epoll: " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    timerfd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (timerfd < 0) {
+        std::cout << "  [FAILED] Cannot create timerfd: " << strerror(errno) << std::endl;
+        return false;
+    }
+    ev.data.fd = timerfd;
+    if (epoll_ctl(epollfd, EPOLL_CTL_ADD, timerfd, &ev) < 0) {
+        std::cout << "  [FAILED] Cannot register timerfd with epoll: " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    ev.data.fd = resolver.getEventFd();
+    if (ev.data.fd < 0 || epoll_ctl(epollfd, EPOLL_CTL_ADD, ev.data.fd, &ev) < 0) {
+        std::cout << "  [FAILED] Cannot register resolver eventfd with epoll: " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    // Shards initialize one after another, so creating it here does not race
+    if (stopFd < 0) {
+        stopFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    }
+    ev.data.fd = stopFd;
+    if (stopFd < 0 || epoll_ctl(epollfd, EPOLL_CTL_ADD, stopFd, &ev) < 0) {
+        std::cout << "  [FAILED] Cannot register stop eventfd with epoll: " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    if (traceEnabled()) {
+        std::cout << "  [SUCCESS] Shared raw socket and epoll loop ready" << std::endl;
+        printInfo("Socket File Descriptor", sockfd);
+        printInfo("Epoll File Descriptor", epollfd);
+        printInfo("Timer File Descriptor", timerfd);
+        printInfo("Resolver Event Descriptor", resolver.getEventFd());
+        printInfo("RTT Timestamp Source", getTimestampModeName(timestampMode));
+        printInfo("Kernel BPF Filter", filtered ? "attached (own replies and errors)"
+                                                : "unavailable (userspace filtering)");
+    }
+    return true;
+}
+
+// Starts every target whose lookup has finished: its first probe is due
+// now, so the send grid of each target is anchored at its own resolution
+void PingEngine::collectResolutions(const struct timespec& now) {
+    Resolution result;
+    while (resolver.next(result)) {
+        Target& target = targets[result.tag];
+
+        if (!result.ok) {
+            target.resolveError = result.error;
+            appendLine("  [FAILED] Cannot resolve %s (%s)\n", target.hostname.c_str(),
+                       Resolver::describeError(result.error));
+            continue;
+        }
+
+        char address[INET_ADDRSTRLEN];
+        inet_ntop(AF_INET, &result.addr, address, sizeof(address));
+        target.addr.sin_family = AF_INET;
+        target.addr.sin_addr = result.addr;
+        target.ipAddress = address;
+        target.resolved = true;
+        if (traceEnabled() && result.elapsedMs > 0.0) {
+            appendLine("  [RESOLVED] %s -> %s (%.3f ms)\n", target.hostname.c_str(), address,
+                       result.elapsedMs);
+        }
+
+        target.nextSend = now;
+        pushDue(result.tag);
+    }
+}
+
+bool PingEngine::initialize() {
+    bool trace = traceEnabled();
+
+    if (trace && announce) {
+        printHeader("ICMP PING - MULTI-TARGET MODE");
+
+        std::cout << std::endl;
+        printInfo("Target Count", (int)targets.size());
+        printInfo("Process ID", getpid());
+        printInfo("Reply Deadline", formatDouble(timeoutMs) + " ms per probe");
+        printInfo("Per-Target Interval", formatDouble(interval) + " ms (default)");
+        std::cout << std::endl;
+    }
+
+    if (!createSocket()) {
+        return false;
+    }
+
+    if (!probeLogPath.empty()) {
+        std::vector<std::string> names(targets.size());
+        for (size_t i = 0; i < targets.size(); i++) {
+            names[i] = targets[i].hostname;
+        }
+        if (!probeLog.open(probeLogPath, names)) {
+            return false;
+        }
+        if (trace) {
+            printInfo("Binary Probe Log", probeLogPath);
+        }
+    }
+
+    if (!statsSegmentName.empty()) {
+        std::vector<std::string> names(targets.size());
+        for (size_t i = 0; i < targets.size(); i++) {
+            names[i] = targets[i].hostname;
+        }
+        if (!ownSegment.open(statsSegmentName, names)) {
+            return false;
+        }
+        attachStatsSegment(&ownSegment, 0, 1);
+        if (trace) {
+            printInfo("Statistics Segment", ownSegment.getName() + " (read with pingstat)");
+        }
+    }
+
+    if (trace) {
+        std::cout << std::endl;
+        printSection("HOSTNAME RESOLUTION");
+        printInfo("Mode", "asynchronous (getaddrinfo pool, cached)");
+        printInfo("Resolver Threads", resolverThreads);
+    }
+    return true;
+}
+
+bool PingEngine::sendDue(const struct timespec& now, int count) {
+    while (dueCount > 0) {
+        if (!limiter.isDue(now)) {
+            return true;
+        }
+
+        ProbeSlot& slot = probes[nextSeq];
+        if (slot.active) {
+            // Every sequence number is outstanding; retry once replies or expiries free one
+            return false;
+        }
+
+        size_t index = dueTargets[dueHead];
+        Target& target = targets[index];
+
+        probe.build(nextSeq);
+
+        SendStamp sendTime;
+        stampSend(sendTime);
+        int sent = sendto(sockfd, probe.getData(), probe.getSize(), 0,
+                          (struct sockaddr*)&target.addr, sizeof(target.addr));
+
+        if (sent < 0) {
+            if (errno == ENOBUFS || errno == EAGAIN || errno == EWOULDBLOCK) {
+                return false; // Transmit queue full, retry shortly
+            }
+            limiter.consume(now);
+            appendLine("  [ERROR] %s: send failed: %s\n", target.hostname.c_str(), strerror(errno));
+            target.stats.addError();
+            totals.errors++;
+        } else {
+            limiter.consume(now);
+            target.stats.addTransmitted();
+            totals.transmitted++;
+            slot.active = true;
+            slot.target = index;
+            slot.targetSeq = target.sent + 1;
+            slot.sendTime = sendTime;
+            slot.expiryTimer = wheel.schedule(addMs(sendTime.mono, target.timeoutMs),
+                                              ((unsigned long long)TIMER_EXPIRY << 32) | nextSeq);
+            inFlightCount++;
+            nextSeq++;
+        }
+
+        target.sent++;
+        dueHead = (dueHead + 1) % dueTargets.size();
+        dueCount--;
+
+        if (target.sent < count) {
+            // Next send stays on the target's own grid, however late this one went out
+            target.nextSend = addMs(target.nextSend, target.intervalMs);
+            wheel.schedule(target.nextSend, ((unsigned long long)TIMER_SEND << 32) | index);
+        }
+    }
+
+    return true;
+}
+
+void PingEngine::processTimers(const struct timespec& now) {
+    expiredTimers.clear();
+    wheel.advance(now, expiredTimers);
+
+    for (size_t i = 0; i < expiredTimers.size(); i++) {
+        unsigned long long data = expiredTimers[i];
+        unsigned int value = (unsigned int)(data & 0xFFFFFFFFu);
+
+        if ((data >> 32) == TIMER_SEND) {
+            pushDue(value);
+            continue;
+        }
+
+        ProbeSlot& slot = probes[value];
+        if (!slot.active) {
+            continue;
+        }
+
+        Target& target = targets[slot.target];
+        if (Output::level >= OUTPUT_CLASSIC) {
+            appendLine("  %s: icmp_seq=%d timed out\n", target.hostname.c_str(), slot.targetSeq);
+        }
+        Output::records.timeout(target.hostname, target.ipAddress, slot.targetSeq);
+        probeLog.timeout((uint32_t)slot.target, slot.targetSeq, slot.sendTime);
+        target.stats.addError();
+        totals.errors++;
+        slot.active = false;
+        inFlightCount--;
+    }
+}
+
+void PingEngine::drainReplies() {
+    for (;;) {
+        int received = rxBatch.receiveBatch(sockfd, MSG_DONTWAIT);
+        if (received <= 0) {
+            if (received < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                appendLine("  [ERROR] Receive error: %s\n", strerror(errno));
+            }
+            return;
+        }
+
+        for (int i = 0; i < received; i++) {
+            ReplyView reply;
+            if (!parseReply(rxBatch.data(i), rxBatch.length(i), reply)) {
+                continue;
+            }
+            if (!isEchoReplyFor(reply, id)) {
+                acceptFailure(reply);
+                continue;
+            }
+
+            ProbeSlot& slot = probes[reply.sequence];
+            if (!slot.active) {
+                continue; // Duplicate or reply to an expired probe
+            }
+
+            Target& target = targets[slot.target];
+            if (target.addr.sin_addr.s_addr != reply.source) {
+                continue; // Sequence belongs to a different destination
+            }
+
+            double rtt = stampRttMs(slot.sendTime, rxBatch.stamp(i));
+            target.stats.addReceived(rtt);
+            totals.addReceived(rtt);
+            wheel.cancel(slot.expiryTimer);
+            slot.active = false;
+            inFlightCount--;
+
+            if (Output::level >= OUTPUT_CLASSIC) {
+                appendLine("  %d bytes from %s (%s): icmp_seq=%d ttl=%d time=%.3f ms\n",
+                           reply.icmpLength, target.ipAddress.c_str(), target.hostname.c_str(),
+                           slot.targetSeq, (int)reply.ttl, rtt);
+            }
+            Output::records.reply(target.hostname, target.ipAddress, slot.targetSeq,
+                                  reply.icmpLength, reply.ttl, rtt);
+            probeLog.reply((uint32_t)slot.target, slot.targetSeq, slot.sendTime, rtt, reply.ttl);
+        }
+
+        if (received < rxBatch.getCapacity()) {
+            return;
+        }
+    }
+}
+
+// An ICMP error quoting one of our probes settles it now rather than at its
+// expiry; the quoted destination guards against a recycled sequence
+bool PingEngine::acceptFailure(const ReplyView& reply) {
+    if (!isErrorFor(reply, id)) {
+        return false;
+    }
+
+    ProbeSlot& slot = probes[reply.quotedSequence];
+    if (!slot.active) {
+        return false;
+    }
+
+    Target& target = targets[slot.target];
+    if (target.addr.sin_addr.s_addr != reply.quotedDestination) {
+        return false;
+    }
+
+    FailureKind kind = classifyIcmpError(reply.type, reply.code);
+    target.stats.addFailure(kind);
+    totals.errors++;
+    wheel.cancel(slot.expiryTimer);
+    slot.active = false;
+    inFlightCount--;
+
+    char fromText[INET_ADDRSTRLEN];
+    inet_ntop(AF_INET, &reply.source, fromText, sizeof(fromText));
+    if (Output::level >= OUTPUT_CLASSIC) {
+        appendLine("  %s: icmp_seq=%d %s from %s\n", target.hostname.c_str(), slot.targetSeq,
+                   getFailureDescription(kind), fromText);
+    }
+    Output::records.failure(target.hostname, target.ipAddress, slot.targetSeq, fromText,
+                            getFailureName(kind));
+    probeLog.failure((uint32_t)slot.target, slot.targetSeq, slot.sendTime, kind);
+    return true;
+}
+
+// Now if a target is waiting to send (subject to the rate limit), otherwise
+// the wheel's next send or expiry
+bool PingEngine::nextDeadline(const struct timespec& now, struct timespec& deadline) {
+    if (dueCount > 0) {
+        deadline = addMs(now, limiter.msUntilDue(now));
+        return true;
+    }
+    return wheel.nextExpiry(deadline);
+}
+
+void PingEngine::armTimer(const struct timespec& deadline) {
+    if (deadline.tv_sec == armedDeadline.tv_sec && deadline.tv_nsec == armedDeadline.tv_nsec) {
+        return; // Already armed for this instant; skip the syscall
+    }
+
+    struct itimerspec spec;
+    memset(&spec, 0, sizeof(spec));
+    spec.it_value = deadline;
+    if (spec.it_value.tv_sec == 0 && spec.it_value.tv_nsec == 0) {
+        spec.it_value.tv_nsec = 1; // All-zero would disarm the timer
+    }
+    timerfd_settime(timerfd, TFD_TIMER_ABSTIME, &spec, nullptr);
+    armedDeadline = deadline;
+}
+
+void PingEngine::disarmTimer() {
+    if (armedDeadline.tv_sec == 0 && armedDeadline.tv_nsec == 0) {
+        return; // Fired and consumed, or never armed
+    }
+    struct itimerspec spec;
+    memset(&spec, 0, sizeof(spec));
+    timerfd_settime(timerfd, TFD_TIMER_ABSTIME, &spec, nullptr);
+    memset(&armedDeadline, 0, sizeof(armedDeadline));
+}
+
+void PingEngine::appendLine(const char* format, ...) {
+    char line[512];
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(line, sizeof(line), format, args);
+    va_end(args);
+    if (length > 0) {
+        pendingLines.append(line, length < (int)sizeof(line) ? (size_t)length : sizeof(line) - 1);
+    }
+}
+
+void PingEngine::pushDue(size_t index) {
+    dueTargets[(dueHead + dueCount) % dueTargets.size()] = index;
+    dueCount++;
+}
+
+// Per-probe lines and records leave in one hand-off per loop turn, and the
+// totals are republished, so sharded workers never share a lock per probe
+void PingEngine::flushOutput() {
+    Output::writeHuman(pendingLines);
+    pendingLines.clear();
+    Output::records.flush();
+    if (aggregator != nullptr) {
+        aggregator->publish(shardIndex, totals);
+    }
+}
+
+bool PingEngine::publishPending() const {
+    return statsSegment != nullptr &&
+           totals.transmitted + totals.received + totals.errors != publishedEvents;
+}
+
+// Republishes the targets whose counters moved since the last publish, at
+// most every PUBLISH_INTERVAL_MS; one scan of the target list, no probe-path work
+void PingEngine::publishStats(const struct timespec& now, bool force) {
+    if (!publishPending() || (!force && elapsedMs(nextPublish, now) < 0.0)) {
+        return;
+    }
+    for (size_t i = 0; i < targets.size(); i++) {
+        Target& target = targets[i];
+        long long events = (long long)target.stats.getTransmitted() + target.stats.getReceived() +
+                           target.stats.getErrors();
+        if (events != target.publishedEvents) {
+            statsSegment->publish(statsFirstSlot + i * statsSlotStride, target.stats,
+                                  target.addr.sin_addr.s_addr);
+            target.publishedEvents = events;
+        }
+    }
+    publishedEvents = totals.transmitted + totals.received + totals.errors;
+    nextPublish = addMs(now, StatsSegment::PUBLISH_INTERVAL_MS);
+}
+
+void PingEngine::run(int count) {
+    if (traceEnabled()) {
+        std::cout << std::endl;
+        printHeader("STARTING MULTI-TARGET PING SEQUENCE");
+        printInfo("Probes Per Target", count);
+        std::cout << std::endl;
+    }
+    runShard(count);
+}
+
+void PingEngine::runShard(int count) {
+    startTime = monotonicNow();
+    limiter.start(startTime);
+    wheel.start(startTime);
+    dueTargets.assign(targets.size() > 0 ? targets.size() : 1, 0);
+    dueHead = 0;
+    dueCount = 0;
+    for (size_t i = 0; i < targets.size(); i++) {
+        resolver.submit(targets[i].hostname, i);
+    }
+    // Literal addresses and repeated names are already complete
+    collectResolutions(startTime);
+
+    struct epoll_event events[8];
+
+    while (dueCount > 0 || wheel.size() > 0 || resolver.pending() > 0) {
+        struct timespec now = monotonicNow();
+
+        processTimers(now);
+        if (stopRequested) {
+            // Nothing new goes out; the probes in flight still get their answer or timeout
+            dueCount = 0;
+            if (inFlightCount == 0) {
+                break;
+            }
+        }
+        bool sendReady = sendDue(now, count);
+
+        if (dueCount == 0 && wheel.size() == 0 && resolver.pending() == 0) {
+            break;
+        }
+
+        struct timespec deadline;
+        bool timed = true;
+        if (!sendReady) {
+            deadline = addMs(now, 1.0);
+        } else if (!nextDeadline(now, deadline)) {
+            // Only lookups outstanding: block until the resolver's eventfd
+            // fires (polling only if it could not be created)
+            timed = resolver.getEventFd() < 0;
+            deadline = addMs(now, 1.0);
+        }
+        // Counters that moved go out within one publish period, even on a quiet loop
+        publishStats(now, false);
+        if (publishPending() && (!timed || elapsedMs(nextPublish, deadline) > 0.0)) {
+            deadline = nextPublish;
+            timed = true;
+        }
+        if (timed) {
+            armTimer(deadline);
+        } else {
+            disarmTimer();
+        }
+        flushOutput();
+
+        int ready = epoll_wait(epollfd, events, 8, -1);
+
+        if (ready < 0 && errno != EINTR) {
+            appendLine("  [ERROR] epoll_wait() failed: %s\n", strerror(errno));
+            break;
+        }
+
+        for (int i = 0; i < ready; i++) {
+            if (events[i].data.fd == timerfd) {
+                unsigned long long expirations;
+                if (read(timerfd, &expirations, sizeof(expirations)) < 0) {
+                    // EAGAIN: already consumed; the deadline is rechecked above anyway
+                }
+                memset(&armedDeadline, 0, sizeof(armedDeadline));
+            } else if (events[i].data.fd == resolver.getEventFd()) {
+                collectResolutions(monotonicNow());
+            } else if (events[i].data.fd == stopFd) {
+                // Shared and never drained, so it would stay readable: stop watching it
+                epoll_ctl(epollfd, EPOLL_CTL_DEL, stopFd, nullptr);
+            } else {
+                drainReplies();
+            }
+        }
+    }
+
+    flushOutput();
+    endTime = monotonicNow();
+    publishStats(endTime, true);
+}
+
+const PingStatistics* PingEngine::summarizeTarget(size_t index) const {
+    const Target& target = targets[index];
+    if (!target.resolved) {
+        std::cout << "  " << std::left << std::setw(25) << target.hostname << ": unresolved";
+        if (target.resolveError != 0) {
+            std::cout << " (" << Resolver::describeError(target.resolveError) << ")";
+        }
+        std::cout << std::endl;
+        return nullptr;
+    }
+    target.stats.printSummaryLine(target.hostname);
+    Output::records.summary(target.hostname, target.ipAddress, target.stats);
+    return &target.stats;
+}
+
+double PingEngine::getDurationMs() const {
+    return elapsedMs(startTime, endTime);
+}
+
+void PingEngine::requestStop() {
+    stopRequested = 1;
+    if (stopFd >= 0) {
+        unsigned long long one = 1;
+        if (write(stopFd, &one, sizeof(one)) < 0) {
+            // Counter saturated: it is readable either way
+        }
+    }
+}
+
+void PingEngine::printTotals(size_t targetCount, int alive, const PingStatistics& all,
+                             double seconds) {
+    printSeparator('-', 80);
+    printInfo("Targets", (int)targetCount);
+    printInfo("Targets Alive", alive);
+    printInfo("Probes Transmitted", all.getTransmitted());
+    printInfo("Probes Received", all.getReceived());
+    if (all.getReceived() > 0) {
+        printInfo("RTT Min/Avg/Max (ms)", formatDouble(all.getMinTime()) + "/" +
+                                              formatDouble(all.getAverageTime()) + "/" +
+                                              formatDouble(all.getMaxTime()));
+        printInfo("RTT p50/p90/p99 (ms)", formatDouble(all.getPercentile(50.0)) + "/" +
+                                              formatDouble(all.getPercentile(90.0)) + "/" +
+                                              formatDouble(all.getPercentile(99.0)));
+    }
+    printInfo("Test Duration", seconds, 25, 3);
+    if (seconds > 0.0) {
+        printInfo("Probe Rate (per second)", all.getTransmitted() / seconds, 25, 1);
+    }
+    printSeparator('=', 80);
+}
+
+void PingEngine::printSummary() const {
+    std::cout << std::endl;
+    printHeader("MULTI-TARGET PING STATISTICS");
+
+    int alive = 0;
+    PingStatistics all;
+
+    for (size_t i = 0; i < targets.size(); i++) {
+        const PingStatistics* stats = summarizeTarget(i);
+        if (stats == nullptr) {
+            continue;
+        }
+        all.merge(*stats);
+        if (stats->getReceived() > 0) {
+            alive++;
+        }
+    }
+
+    printTotals(targets.size(), alive, all, getDurationMs() / 1000.0);
+}
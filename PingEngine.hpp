@@ -0,0 +1,166 @@
+#ifndef PING_ENGINE_HPP
+#define PING_ENGINE_HPP
+
+#include "PingStatistics.hpp"
+#include "Timestamp.hpp"
+#include "BatchIO.hpp"
+#include "ICMPPacket.hpp"
+#include "Pacer.hpp"
+#include "TimingWheel.hpp"
+#include "StatsAggregator.hpp"
+#include "ReplyView.hpp"
+#include "Resolver.hpp"
+#include "ProbeLog.hpp"
+#include "StatsSegment.hpp"
+#include <string>
+#include <vector>
+#include <netinet/in.h>
+#include <signal.h>
+
+// Event-driven multi-target pinger: one raw socket and one epoll loop shared
+// by every target. Names resolve on the Resolver's thread pool while the
+// loop runs, and each target starts probing as soon as its address
+// arrives. Replies are routed back to their target through a probe table
+// indexed by the (engine-wide) ICMP sequence number, then checked
+// against the source address and ICMP id. Send times and reply deadlines
+// are absolute CLOCK_MONOTONIC instants kept in a hierarchical timing wheel;
+// a timerfd in the same epoll set is armed for the wheel's next expiry, so
+// each target can carry its own interval and timeout at 100k-target scale.
+class PingEngine {
+private:
+    struct Target {
+        std::string hostname;
+        std::string ipAddress;
+        struct sockaddr_in addr;
+        PingStatistics stats;
+        bool resolved;
+        int resolveError;       // getaddrinfo() code once a lookup failed, 0 otherwise
+        int sent;
+        double intervalMs;
+        double timeoutMs;
+        struct timespec nextSend;
+        long long publishedEvents;  // Probe outcomes in the last statistics publish
+
+        Target() : stats(false), resolved(false), resolveError(0), sent(0), publishedEvents(0) {}
+    };
+
+    struct ProbeSlot {
+        bool active;
+        size_t target;
+        int targetSeq;
+        TimingWheel::TimerId expiryTimer;
+        SendStamp sendTime;
+    };
+
+    // Wheel timer data: kind in the high 32 bits, target index or seq below
+    enum TimerKind {
+        TIMER_SEND = 1,
+        TIMER_EXPIRY = 2
+    };
+
+    static const int SEQ_SPACE = 65536;
+
+    // Set by requestStop(); stopFd is one eventfd for the whole process,
+    // in every engine's epoll set, so a stop wakes all workers at once
+    static volatile sig_atomic_t stopRequested;
+    static int stopFd;
+
+    int sockfd;
+    int epollfd;
+    int timerfd;
+    double timeoutMs;
+    double interval;
+    TimestampMode timestampMode;
+    unsigned short nextSeq;
+    unsigned short id;
+    std::vector<Target> targets;
+    std::vector<ProbeSlot> probes;
+    ICMPPacket probe;
+    BatchIO rxBatch;
+    Pacer limiter;                    // Engine-wide token bucket across all targets
+    TimingWheel wheel;
+    std::vector<unsigned long long> expiredTimers;
+    // Targets whose send time has arrived: a ring sized to the target list,
+    // since a target is queued at most once, so the FIFO never allocates
+    std::vector<size_t> dueTargets;
+    size_t dueHead;
+    size_t dueCount;
+    int inFlightCount;
+    ShardTotals totals;               // Engine-wide counters, published to the aggregator
+    std::string probeLogPath;
+    ProbeLog probeLog;
+    // Live statistics: target i lives in slot statsFirstSlot + i * statsSlotStride
+    // of statsSegment, which is ownSegment unless a ShardedEngine shares its own
+    std::string statsSegmentName;
+    StatsSegment ownSegment;
+    StatsSegment* statsSegment;
+    size_t statsFirstSlot;
+    size_t statsSlotStride;
+    struct timespec nextPublish;
+    unsigned long publishedEvents;    // Engine-wide probe outcomes in the last publish
+    int resolverThreads;
+    Resolver resolver;
+    StatsAggregator* aggregator;
+    int shardIndex;
+    bool announce;
+    std::string pendingLines;         // Per-probe output, handed over once per loop turn
+    struct timespec startTime;
+    struct timespec endTime;
+    struct timespec armedDeadline;
+
+    bool createSocket();
+    void collectResolutions(const struct timespec& now);
+    bool sendDue(const struct timespec& now, int count);
+    void processTimers(const struct timespec& now);
+    void drainReplies();
+    bool acceptFailure(const ReplyView& reply);
+    bool nextDeadline(const struct timespec& now, struct timespec& deadline);
+    void armTimer(const struct timespec& deadline);
+    void disarmTimer();
+    void flushOutput();
+    bool publishPending() const;
+    void publishStats(const struct timespec& now, bool force);
+    // printf into pendingLines; its capacity is reused, so no allocation per line
+    void appendLine(const char* format, ...) __attribute__((format(printf, 2, 3)));
+    void pushDue(size_t index);
+
+public:
+    PingEngine(double timeoutMs = 2000.0, double intervalMs = 1000.0,
+               size_t payloadSize = ICMPPacket::DEFAULT_PAYLOAD_SIZE);
+    ~PingEngine();
+
+    // Interval and timeout of 0 fall back to the engine-wide defaults
+    void addTarget(const std::string& host, double intervalMs = 0.0, double timeoutMs = 0.0);
+    // Runs this engine as one worker of a ShardedEngine: its own ICMP id,
+    // totals published to the aggregator, and no per-engine banners
+    void setShard(StatsAggregator* shardAggregator, int shard, unsigned short icmpId);
+    void setRateLimit(double perSecond, double burst = 0.0);
+    void setResolverThreads(int threads);
+    // Records every probe to a binary log, opened by initialize()
+    void setProbeLog(const std::string& path);
+    // Publishes live per-target statistics to a segment created by initialize()
+    void setStatsSegment(const std::string& name);
+    // Publishes into a segment shared with other workers instead
+    void attachStatsSegment(StatsSegment* segment, size_t firstSlot, size_t slotStride);
+    size_t getTargetCount() const;
+
+    bool initialize();
+    void run(int count = 4);
+    // run() without the banner; safe to call from a worker thread
+    void runShard(int count);
+    void printSummary() const;
+
+    // Prints one target's summary line and record; nullptr if it never resolved
+    const PingStatistics* summarizeTarget(size_t index) const;
+    double getDurationMs() const;
+    // all is every target's statistics merged, histograms included, so the
+    // RTT percentiles cover the whole run rather than one target
+    static void printTotals(size_t targetCount, int alive, const PingStatistics& all,
+                            double seconds);
+
+    // Async-signal-safe: every running engine stops sending, waits for the
+    // probes in flight to be answered or expire, and returns from run()
+    static void requestStop();
+};
+
+#endif
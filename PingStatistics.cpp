@@ -1,29 +1,90 @@
 #include "PingStatistics.hpp"
 #include "utils.hpp"
+#include "Timestamp.hpp"
+#include "Output.hpp"
 #include <iostream>
 #include <iomanip>
 #include <cmath>
-#include <sys/time.h>
 
-PingStatistics::PingStatistics() 
-    : transmitted(0), received(0), errors(0), totalTime(0.0), 
-      minTime(999999.0), maxTime(0.0) {
-    gettimeofday(&startTime, nullptr);
+FailureKind classifyIcmpError(int type, int code) {
+    if (type == 11) {
+        return code == 1 ? FAILURE_REASSEMBLY_TIMEOUT : FAILURE_TTL_EXCEEDED;
+    }
+    if (type == 12) {
+        return FAILURE_PARAMETER_PROBLEM;
+    }
+    switch (code) {
+        case 0: case 6: case 11: return FAILURE_NET_UNREACHABLE;
+        case 1: case 7: case 12: return FAILURE_HOST_UNREACHABLE;
+        case 2: return FAILURE_PROTOCOL_UNREACHABLE;
+        case 3: return FAILURE_PORT_UNREACHABLE;
+        case 4: return FAILURE_FRAGMENTATION_NEEDED;
+        case 5: return FAILURE_SOURCE_ROUTE_FAILED;
+        case 9: case 10: case 13: return FAILURE_ADMIN_PROHIBITED;
+        default: return FAILURE_UNREACHABLE_OTHER;
+    }
+}
+
+const char* getFailureName(FailureKind kind) {
+    switch (kind) {
+        case FAILURE_NET_UNREACHABLE: return "net_unreachable";
+        case FAILURE_HOST_UNREACHABLE: return "host_unreachable";
+        case FAILURE_PROTOCOL_UNREACHABLE: return "protocol_unreachable";
+        case FAILURE_PORT_UNREACHABLE: return "port_unreachable";
+        case FAILURE_FRAGMENTATION_NEEDED: return "frag_needed";
+        case FAILURE_SOURCE_ROUTE_FAILED: return "source_route_failed";
+        case FAILURE_ADMIN_PROHIBITED: return "admin_prohibited";
+        case FAILURE_UNREACHABLE_OTHER: return "unreachable";
+        case FAILURE_TTL_EXCEEDED: return "ttl_exceeded";
+        case FAILURE_REASSEMBLY_TIMEOUT: return "reassembly_timeout";
+        case FAILURE_PARAMETER_PROBLEM: return "parameter_problem";
+        default: return "unknown";
+    }
+}
+
+const char* getFailureDescription(FailureKind kind) {
+    switch (kind) {
+        case FAILURE_NET_UNREACHABLE: return "Destination Net Unreachable";
+        case FAILURE_HOST_UNREACHABLE: return "Destination Host Unreachable";
+        case FAILURE_PROTOCOL_UNREACHABLE: return "Destination Protocol Unreachable";
+        case FAILURE_PORT_UNREACHABLE: return "Destination Port Unreachable";
+        case FAILURE_FRAGMENTATION_NEEDED: return "Frag needed and DF set";
+        case FAILURE_SOURCE_ROUTE_FAILED: return "Source Route Failed";
+        case FAILURE_ADMIN_PROHIBITED: return "Communication Administratively Prohibited";
+        case FAILURE_UNREACHABLE_OTHER: return "Destination Unreachable";
+        case FAILURE_TTL_EXCEEDED: return "Time to live exceeded";
+        case FAILURE_REASSEMBLY_TIMEOUT: return "Fragment reassembly time exceeded";
+        case FAILURE_PARAMETER_PROBLEM: return "Parameter Problem";
+        default: return "Unknown failure";
+    }
+}
+
+PingStatistics::PingStatistics(bool verboseOutput) 
+    : transmitted(0), received(0), errors(0), verbose(verboseOutput), meanTime(0.0), 
+      sumSquares(0.0), minTime(999999.0), maxTime(0.0) {
+    for (int i = 0; i < FAILURE_KIND_COUNT; i++) {
+        failures[i] = 0;
+    }
+    startTime = monotonicNow();
 }
 
 void PingStatistics::addTransmitted() {
     transmitted++;
+    if (!verbose || !traceEnabled()) return;
     std::cout << "  [TX] Packet transmitted (total: " << transmitted << ")" << std::endl;
 }
 
 void PingStatistics::addReceived(double rtt) {
     received++;
-    totalTime += rtt;
-    rttValues.push_back(rtt);
+    double delta = rtt - meanTime;
+    meanTime += delta / received;
+    sumSquares += delta * (rtt - meanTime);
+    histogram.record(rtt);
     
     if (rtt < minTime) minTime = rtt;
     if (rtt > maxTime) maxTime = rtt;
     
+    if (!verbose || !traceEnabled()) return;
     std::cout << "  [RX] Packet received successfully" << std::endl;
     std::cout << "  [STAT] Total received: " << received << "/" << transmitted 
               << " (" << std::fixed << std::setprecision(1) 
@@ -32,43 +93,86 @@ void PingStatistics::addReceived(double rtt) {
 
 void PingStatistics::addError() {
     errors++;
+    if (!verbose || !traceEnabled()) return;
     std::cout << "  [ERROR] Packet processing error (total errors: " << errors << ")" << std::endl;
 }
 
+void PingStatistics::addFailure(FailureKind kind) {
+    failures[kind]++;
+    errors++;
+    if (!verbose || !traceEnabled()) return;
+    std::cout << "  [FAILED] " << getFailureDescription(kind)
+              << " (total errors: " << errors << ")" << std::endl;
+}
+
 int PingStatistics::getTransmitted() const { return transmitted; }
 int PingStatistics::getReceived() const { return received; }
 int PingStatistics::getErrors() const { return errors; }
+int PingStatistics::getFailures(FailureKind kind) const { return failures[kind]; }
+
+int PingStatistics::getTotalFailures() const {
+    int total = 0;
+    for (int i = 0; i < FAILURE_KIND_COUNT; i++) {
+        total += failures[i];
+    }
+    return total;
+}
 
 double PingStatistics::getAverageTime() const { 
-    return received > 0 ? totalTime / received : 0.0; 
+    return received > 0 ? meanTime : 0.0; 
 }
 
 double PingStatistics::getMinTime() const { return minTime; }
 double PingStatistics::getMaxTime() const { return maxTime; }
 
+double PingStatistics::getPercentile(double p) const {
+    if (received == 0) return 0.0;
+    // Bucket midpoints can overshoot the extremes; the exact min/max bound them
+    double value = histogram.percentile(p);
+    if (value < minTime) value = minTime;
+    if (value > maxTime) value = maxTime;
+    return value;
+}
+
+void PingStatistics::merge(const PingStatistics& other) {
+    if (other.received > 0) {
+        // Chan et al. pairwise combination of the Welford accumulators
+        double total = (double)received + other.received;
+        double delta = other.meanTime - meanTime;
+        sumSquares += other.sumSquares + delta * delta * received * other.received / total;
+        meanTime += delta * other.received / total;
+        if (other.minTime < minTime) minTime = other.minTime;
+        if (other.maxTime > maxTime) maxTime = other.maxTime;
+        histogram.merge(other.histogram);
+    }
+    
+    transmitted += other.transmitted;
+    received += other.received;
+    errors += other.errors;
+    for (int i = 0; i < FAILURE_KIND_COUNT; i++) {
+        failures[i] += other.failures[i];
+    }
+    if (elapsedMs(other.startTime, startTime) > 0.0) {
+        startTime = other.startTime;
+    }
+}
+
 int PingStatistics::getPacketLoss() const {
     return transmitted > 0 ? 
-           ((transmitted - received) * 100 / transmitted) : 0;
+           (int)((transmitted - received) * 100LL / transmitted) : 0;
+}
+
+const RttHistogram& PingStatistics::getHistogram() const {
+    return histogram;
 }
 
 double PingStatistics::calculateStdDev() const {
-    if (rttValues.size() < 2) return 0.0;
-    
-    double avg = getAverageTime();
-    double sumSquares = 0.0;
-    
-    for (double rtt : rttValues) {
-        double diff = rtt - avg;
-        sumSquares += diff * diff;
-    }
-    
-    return std::sqrt(sumSquares / rttValues.size());
+    if (received < 2) return 0.0;
+    return std::sqrt(sumSquares / received);
 }
 
 void PingStatistics::printDetailedStatistics(const std::string& host) const {
-    gettimeofday((struct timeval*)&endTime, nullptr);
-    double totalDuration = (endTime.tv_sec - startTime.tv_sec) + 
-                           (endTime.tv_usec - startTime.tv_usec) / 1000000.0;
+    double totalDuration = elapsedMs(startTime, monotonicNow()) / 1000.0;
     
     std::cout << std::endl;
     printHeader("PING STATISTICS");
@@ -86,6 +190,18 @@ void PingStatistics::printDetailedStatistics(const std::string& host) const {
     printInfo("Packet Loss Rate", std::to_string(getPacketLoss()) + " %");
     printInfo("Errors", errors);
     
+    if (getTotalFailures() > 0) {
+        printSeparator('-', 80);
+        std::cout << "  FAILURES REPORTED BY ICMP ERRORS" << std::endl;
+        printSeparator('-', 80);
+        
+        for (int i = 0; i < FAILURE_KIND_COUNT; i++) {
+            if (failures[i] > 0) {
+                printInfo(getFailureName((FailureKind)i), failures[i]);
+            }
+        }
+    }
+    
     if (received > 0) {
         printSeparator('-', 80);
         std::cout << "  ROUND-TRIP TIME (RTT) STATISTICS" << std::endl;
@@ -101,12 +217,51 @@ void PingStatistics::printDetailedStatistics(const std::string& host) const {
         std::cout << "  RTT DISTRIBUTION" << std::endl;
         printSeparator('-', 80);
         
-        std::cout << "  Individual RTT values (ms):" << std::endl;
-        for (size_t i = 0; i < rttValues.size(); i++) {
-            std::cout << "    Packet " << (i + 1) << ": " 
-                      << std::fixed << std::setprecision(3) << rttValues[i] << " ms" << std::endl;
-        }
+        printInfo("50th Percentile (p50)", getPercentile(50.0), 25, 3);
+        printInfo("90th Percentile (p90)", getPercentile(90.0), 25, 3);
+        printInfo("99th Percentile (p99)", getPercentile(99.0), 25, 3);
+        printInfo("99.9th Percentile", getPercentile(99.9), 25, 3);
     }
     
     printSeparator('=', 80);
 }
+
+void PingStatistics::printSummaryLine(const std::string& host) const {
+    std::cout << "  " << std::left << std::setw(25) << host
+              << ": xmt/rcv/%loss = " << transmitted << "/" << received
+              << "/" << getPacketLoss() << "%";
+    
+    if (received > 0) {
+        std::cout << ", min/avg/max/p99 = " << std::fixed << std::setprecision(3)
+                  << minTime << "/" << getAverageTime() << "/" << maxTime
+                  << "/" << getPercentile(99.0) << " ms";
+    }
+    
+    for (int i = 0; i < FAILURE_KIND_COUNT; i++) {
+        if (failures[i] > 0) {
+            std::cout << ", " << getFailureName((FailureKind)i) << "=" << failures[i];
+        }
+    }
+    
+    std::cout << std::endl;
+}
+
+void PingStatistics::printClassicSummary(const std::string& host) const {
+    double totalMs = elapsedMs(startTime, monotonicNow());
+    
+    std::cout << std::endl << "--- " << host << " ping statistics ---" << std::endl;
+    std::cout << transmitted << " packets transmitted, " << received << " received, ";
+    if (getTotalFailures() > 0) {
+        std::cout << "+" << getTotalFailures() << " errors, ";
+    }
+    std::cout << getPacketLoss() << "% packet loss, time " << (long)totalMs << "ms" << std::endl;
+    
+    if (received > 0) {
+        std::cout << "rtt min/avg/max/mdev = " << formatDouble(minTime) << "/"
+                  << formatDouble(getAverageTime()) << "/" << formatDouble(maxTime) << "/"
+                  << formatDouble(calculateStdDev()) << " ms" << std::endl;
+        std::cout << "rtt p50/p90/p99/p99.9 = " << formatDouble(getPercentile(50.0)) << "/"
+                  << formatDouble(getPercentile(90.0)) << "/" << formatDouble(getPercentile(99.0))
+                  << "/" << formatDouble(getPercentile(99.9)) << " ms" << std::endl;
+    }
+}
@@ -1,41 +1,78 @@
 #ifndef PING_STATISTICS_HPP
 #define PING_STATISTICS_HPP
 
-#include <vector>
+#include "RttHistogram.hpp"
 #include <string>
-#include <sys/time.h>
+#include <time.h>
 
+// Why a probe failed before its deadline, decoded from the ICMP error
+// (Destination Unreachable, Time Exceeded, Parameter Problem) that quoted it
+enum FailureKind {
+    FAILURE_NET_UNREACHABLE,
+    FAILURE_HOST_UNREACHABLE,
+    FAILURE_PROTOCOL_UNREACHABLE,
+    FAILURE_PORT_UNREACHABLE,
+    FAILURE_FRAGMENTATION_NEEDED,
+    FAILURE_SOURCE_ROUTE_FAILED,
+    FAILURE_ADMIN_PROHIBITED,
+    FAILURE_UNREACHABLE_OTHER,
+    FAILURE_TTL_EXCEEDED,
+    FAILURE_REASSEMBLY_TIMEOUT,
+    FAILURE_PARAMETER_PROBLEM,
+    FAILURE_KIND_COUNT
+};
+
+FailureKind classifyIcmpError(int type, int code);
+const char* getFailureName(FailureKind kind);         // Record key, e.g. "host_unreachable"
+const char* getFailureDescription(FailureKind kind);  // e.g. "Destination Host Unreachable"
+
+// Running RTT statistics in constant memory: Welford's online mean and
+// variance plus an RttHistogram for percentiles, so a run of any length
+// costs O(1) per reply and a few kilobytes in total.
 class PingStatistics {
 private:
     int transmitted;
     int received;
     int errors;
-    double totalTime;
+    int failures[FAILURE_KIND_COUNT];
+    bool verbose;
+    double meanTime;
+    double sumSquares;      // Welford M2: sum of squared deviations from the mean
     double minTime;
     double maxTime;
-    std::vector<double> rttValues;
-    struct timeval startTime;
-    struct timeval endTime;
-
-    double getAverageTime() const;
-    double calculateStdDev() const;
+    RttHistogram histogram;
+    struct timespec startTime;
 
 public:
-    PingStatistics();
+    PingStatistics(bool verboseOutput = true);
     
     void addTransmitted();
     void addReceived(double rtt);
     void addError();
+    // An ICMP error ended the probe early; also counted in the errors total
+    void addFailure(FailureKind kind);
 
     int getTransmitted() const;
     int getReceived() const;
     int getErrors() const;
+    int getFailures(FailureKind kind) const;
+    int getTotalFailures() const;
     int getPacketLoss() const;
 
     double getMinTime() const;
     double getMaxTime() const;
+    double getAverageTime() const;
+    double calculateStdDev() const;
+    double getPercentile(double p) const;
+    const RttHistogram& getHistogram() const;
+
+    // Combines another run's (or thread's) statistics into this one
+    void merge(const PingStatistics& other);
     
     void printDetailedStatistics(const std::string& host) const;
+    void printSummaryLine(const std::string& host) const;
+    // iputils-style "--- host ping statistics ---" block for quiet/classic output
+    void printClassicSummary(const std::string& host) const;
 };
 
 #endif
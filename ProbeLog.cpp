@@ -0,0 +1,261 @@
+#include "ProbeLog.hpp"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+static const char LOG_MAGIC[8] = {'P', 'I', 'N', 'G', 'L', 'O', 'G', '\0'};
+
+static size_t roundToPage(size_t bytes) {
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    return (bytes + page - 1) / page * page;
+}
+
+ProbeLog::ProbeLog()
+    : fd(-1), header(nullptr), headerBytes(0), mapping(nullptr), mappingBytes(0),
+      segment(nullptr), segmentFirstBlock(0),
+      blockIndex(0), slot(0), targets(nullptr), seqs(nullptr), sendTimes(nullptr),
+      rtts(nullptr), statuses(nullptr), ttls(nullptr) {}
+
+ProbeLog::~ProbeLog() {
+    close();
+}
+
+bool ProbeLog::open(const std::string& logPath, const std::vector<std::string>& names) {
+    close();
+    path = logPath;
+
+    size_t tableBytes = 0;
+    for (size_t i = 0; i < names.size(); i++) {
+        tableBytes += names[i].size() + 1;
+    }
+    headerBytes = roundToPage(sizeof(ProbeLogHeader) + tableBytes);
+
+    fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        std::cout << "  [FAILED] Cannot create probe log " << path << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+    if (ftruncate(fd, (off_t)headerBytes) < 0) {
+        std::cout << "  [FAILED] Cannot size probe log " << path << ": " << strerror(errno) << std::endl;
+        close();
+        return false;
+    }
+
+    void* mapped = mmap(nullptr, headerBytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (mapped == MAP_FAILED) {
+        std::cout << "  [FAILED] Cannot map probe log " << path << ": " << strerror(errno) << std::endl;
+        close();
+        return false;
+    }
+    header = (ProbeLogHeader*)mapped;
+    memcpy(header->magic, LOG_MAGIC, sizeof(LOG_MAGIC));
+    header->version = VERSION;
+    header->blockRecords = (uint32_t)BLOCK_RECORDS;
+    header->targetCount = (uint32_t)names.size();
+    header->headerBytes = (uint32_t)headerBytes;
+    header->recordCount = 0;
+
+    char* table = (char*)mapped + sizeof(ProbeLogHeader);
+    for (size_t i = 0; i < names.size(); i++) {
+        memcpy(table, names[i].c_str(), names[i].size() + 1);
+        table += names[i].size() + 1;
+    }
+
+    if (!mapSegment(0)) {
+        close();
+        return false;
+    }
+    selectBlock(0);
+    return true;
+}
+
+// Grows the file to hold SEGMENT_BLOCKS more blocks and maps them,
+// prefaulted, in place of the previous segment. mmap() offsets must be
+// page multiples, so the mapping starts at the page holding the first
+// block, which lies that many bytes into it.
+bool ProbeLog::mapSegment(size_t firstBlock) {
+    if (mapping != nullptr) {
+        munmap(mapping, mappingBytes);
+        mapping = nullptr;
+        segment = nullptr;
+    }
+
+    off_t offset = (off_t)(headerBytes + firstBlock * BLOCK_BYTES);
+    off_t end = offset + (off_t)(SEGMENT_BLOCKS * BLOCK_BYTES);
+    if (ftruncate(fd, end) < 0) {
+        std::cout << "  [ERROR] Cannot grow probe log " << path << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    off_t page = (off_t)sysconf(_SC_PAGESIZE);
+    off_t lead = offset % page;
+    void* mapped = mmap(nullptr, (size_t)(end - offset + lead), PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_POPULATE, fd, offset - lead);
+    if (mapped == MAP_FAILED) {
+        std::cout << "  [ERROR] Cannot map probe log " << path << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+    mapping = (char*)mapped;
+    mappingBytes = (size_t)(end - offset + lead);
+    segment = mapping + lead;
+    segmentFirstBlock = firstBlock;
+    return true;
+}
+
+void ProbeLog::selectBlock(size_t index) {
+    char* block = segment + (index - segmentFirstBlock) * BLOCK_BYTES;
+    targets = (uint32_t*)block;
+    seqs = (uint32_t*)(block + BLOCK_RECORDS * 4);
+    sendTimes = (int64_t*)(block + BLOCK_RECORDS * 8);
+    rtts = (float*)(block + BLOCK_RECORDS * 16);
+    statuses = (uint8_t*)(block + BLOCK_RECORDS * 20);
+    ttls = (uint8_t*)(block + BLOCK_RECORDS * 21);
+    blockIndex = index;
+    slot = 0;
+}
+
+void ProbeLog::append(uint32_t target, int seq, const SendStamp& sent, double rttMs, int status, int ttl) {
+    if (segment == nullptr) {
+        return;
+    }
+    if (slot == BLOCK_RECORDS) {
+        size_t next = blockIndex + 1;
+        if (next == segmentFirstBlock + SEGMENT_BLOCKS && !mapSegment(next)) {
+            return; // Disk full or similar: the log stops, the run goes on
+        }
+        selectBlock(next);
+    }
+
+    targets[slot] = target;
+    seqs[slot] = (uint32_t)seq;
+    sendTimes[slot] = (int64_t)sent.wall.tv_sec * 1000000000LL + sent.wall.tv_nsec;
+    rtts[slot] = (float)rttMs;
+    statuses[slot] = (uint8_t)status;
+    ttls[slot] = (uint8_t)ttl;
+    slot++;
+    header->recordCount++;
+}
+
+void ProbeLog::close() {
+    if (mapping != nullptr) {
+        munmap(mapping, mappingBytes);
+        mapping = nullptr;
+        segment = nullptr;
+    }
+    if (header != nullptr) {
+        uint64_t records = header->recordCount;
+        size_t blocks = (size_t)((records + BLOCK_RECORDS - 1) / BLOCK_RECORDS);
+        munmap(header, headerBytes);
+        header = nullptr;
+        if (ftruncate(fd, (off_t)(headerBytes + blocks * BLOCK_BYTES)) < 0) {
+            // The unused tail only costs disk space; readers go by recordCount
+        }
+    }
+    if (fd >= 0) {
+        ::close(fd);
+        fd = -1;
+    }
+}
+
+bool ProbeLog::isOpen() const {
+    return header != nullptr;
+}
+
+const std::string& ProbeLog::getPath() const {
+    return path;
+}
+
+uint64_t ProbeLog::getRecordCount() const {
+    return header != nullptr ? header->recordCount : 0;
+}
+
+ProbeLogReader::ProbeLogReader()
+    : fd(-1), data(nullptr), size(0), header(nullptr), recordCount(0) {}
+
+ProbeLogReader::~ProbeLogReader() {
+    if (data != nullptr) {
+        munmap((void*)data, size);
+    }
+    if (fd >= 0) {
+        close(fd);
+    }
+}
+
+bool ProbeLogReader::open(const std::string& path) {
+    fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        std::cerr << "ERROR: Cannot open " << path << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) < 0 || (size_t)info.st_size < sizeof(ProbeLogHeader)) {
+        std::cerr << "ERROR: " << path << " is too short to be a probe log" << std::endl;
+        return false;
+    }
+    size = (size_t)info.st_size;
+
+    void* mapped = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    if (mapped == MAP_FAILED) {
+        std::cerr << "ERROR: Cannot map " << path << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+    data = (const char*)mapped;
+    header = (const ProbeLogHeader*)data;
+
+    if (memcmp(header->magic, LOG_MAGIC, sizeof(LOG_MAGIC)) != 0 || header->version != ProbeLog::VERSION ||
+        header->blockRecords != ProbeLog::BLOCK_RECORDS || header->headerBytes > size) {
+        std::cerr << "ERROR: " << path << " is not a version " << ProbeLog::VERSION
+                  << " probe log" << std::endl;
+        return false;
+    }
+
+    const char* name = data + sizeof(ProbeLogHeader);
+    const char* tableEnd = data + header->headerBytes;
+    for (uint32_t i = 0; i < header->targetCount; i++) {
+        const char* end = (const char*)memchr(name, '\0', tableEnd - name);
+        if (end == nullptr) {
+            std::cerr << "ERROR: " << path << ": truncated target table" << std::endl;
+            return false;
+        }
+        names.push_back(std::string(name, end));
+        name = end + 1;
+    }
+
+    // Never trust the count past what the file actually holds
+    uint64_t capacity = (size - header->headerBytes) / ProbeLog::BLOCK_BYTES * ProbeLog::BLOCK_RECORDS;
+    recordCount = header->recordCount < capacity ? header->recordCount : capacity;
+    return true;
+}
+
+const std::vector<std::string>& ProbeLogReader::getTargets() const {
+    return names;
+}
+
+uint64_t ProbeLogReader::getRecordCount() const {
+    return recordCount;
+}
+
+size_t ProbeLogReader::getBlockCount() const {
+    return (size_t)((recordCount + ProbeLog::BLOCK_RECORDS - 1) / ProbeLog::BLOCK_RECORDS);
+}
+
+ProbeBlock ProbeLogReader::getBlock(size_t index) const {
+    const char* block = data + header->headerBytes + index * ProbeLog::BLOCK_BYTES;
+    ProbeBlock columns;
+    columns.target = (const uint32_t*)block;
+    columns.seq = (const uint32_t*)(block + ProbeLog::BLOCK_RECORDS * 4);
+    columns.sendNs = (const int64_t*)(block + ProbeLog::BLOCK_RECORDS * 8);
+    columns.rttMs = (const float*)(block + ProbeLog::BLOCK_RECORDS * 16);
+    columns.status = (const uint8_t*)(block + ProbeLog::BLOCK_RECORDS * 20);
+    columns.ttl = (const uint8_t*)(block + ProbeLog::BLOCK_RECORDS * 21);
+
+    uint64_t first = (uint64_t)index * ProbeLog::BLOCK_RECORDS;
+    uint64_t remaining = recordCount - first;
+    columns.count = remaining < ProbeLog::BLOCK_RECORDS ? (size_t)remaining : ProbeLog::BLOCK_RECORDS;
+    return columns;
+}
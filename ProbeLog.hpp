@@ -0,0 +1,136 @@
+#ifndef PROBE_LOG_HPP
+#define PROBE_LOG_HPP
+
+#include "PingStatistics.hpp"
+#include "Timestamp.hpp"
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// On-disk layout of a binary probe log (host byte order):
+//
+//   page 0..   ProbeLogHeader, then targetCount NUL-terminated names,
+//              padded to headerBytes (a page multiple)
+//   block i    at headerBytes + i * BLOCK_BYTES, BLOCK_RECORDS records
+//              stored column by column:
+//                uint32 target[]   index into the name table
+//                uint32 seq[]      per-target probe number
+//                int64  sendNs[]   CLOCK_REALTIME send time
+//                float  rttMs[]    round trip, -1 when no reply
+//                uint8  status[]   PROBE_REPLY, PROBE_TIMEOUT or
+//                                  PROBE_FAILURE + FailureKind
+//                uint8  ttl[]      reply TTL, 0 when no reply
+//
+// recordCount in the header is updated with every record, so a log cut
+// short by a crash still reads up to the last probe written.
+struct ProbeLogHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t blockRecords;
+    uint32_t targetCount;
+    uint32_t headerBytes;
+    uint64_t recordCount;
+};
+
+enum ProbeStatus {
+    PROBE_REPLY = 0,
+    PROBE_TIMEOUT = 1,
+    PROBE_FAILURE = 2       // Plus the FailureKind of the ICMP error
+};
+
+// Column pointers into one mapped block
+struct ProbeBlock {
+    const uint32_t* target;
+    const uint32_t* seq;
+    const int64_t* sendNs;
+    const float* rttMs;
+    const uint8_t* status;
+    const uint8_t* ttl;
+    size_t count;           // Valid records; only the last block is partial
+};
+
+// Appends per-probe records to a memory-mapped file. The file grows a
+// segment of blocks at a time (ftruncate and mmap), so recording a probe is
+// a handful of stores into the current block with no system call. One
+// writer per log: sharded runs give every worker its own file.
+class ProbeLog {
+public:
+    static const uint32_t VERSION = 1;
+    static const size_t BLOCK_RECORDS = 4096;
+    static const size_t RECORD_BYTES = 4 + 4 + 8 + 4 + 1 + 1;
+    // 22 pages of 4 KiB; blocks need not start on a page boundary of other
+    // page sizes, so segments are mapped from the page below their first block
+    static const size_t BLOCK_BYTES = BLOCK_RECORDS * RECORD_BYTES;
+    static const size_t SEGMENT_BLOCKS = 16;
+
+private:
+    int fd;
+    ProbeLogHeader* header;
+    size_t headerBytes;
+    char* mapping;          // Page-aligned start of the current segment's mapping
+    size_t mappingBytes;
+    char* segment;          // Its first block, inside mapping
+    size_t segmentFirstBlock;
+    size_t blockIndex;      // Absolute index of the block being filled
+    size_t slot;            // Next record within that block
+    std::string path;
+
+    // Current block's columns
+    uint32_t* targets;
+    uint32_t* seqs;
+    int64_t* sendTimes;
+    float* rtts;
+    uint8_t* statuses;
+    uint8_t* ttls;
+
+    bool mapSegment(size_t firstBlock);
+    void selectBlock(size_t index);
+    void append(uint32_t target, int seq, const SendStamp& sent, double rttMs, int status, int ttl);
+
+public:
+    ProbeLog();
+    ~ProbeLog();
+
+    // Creates (or truncates) path and writes the target name table
+    bool open(const std::string& logPath, const std::vector<std::string>& names);
+    bool isOpen() const;
+    // Trims the file to the records written and unmaps it
+    void close();
+    const std::string& getPath() const;
+    uint64_t getRecordCount() const;
+
+    void reply(uint32_t target, int seq, const SendStamp& sent, double rttMs, int ttl) {
+        append(target, seq, sent, rttMs, PROBE_REPLY, ttl);
+    }
+    void timeout(uint32_t target, int seq, const SendStamp& sent) {
+        append(target, seq, sent, -1.0, PROBE_TIMEOUT, 0);
+    }
+    void failure(uint32_t target, int seq, const SendStamp& sent, FailureKind kind) {
+        append(target, seq, sent, -1.0, PROBE_FAILURE + kind, 0);
+    }
+};
+
+// Read-only mapping of a finished (or crashed) log for analysis
+class ProbeLogReader {
+private:
+    int fd;
+    const char* data;
+    size_t size;
+    const ProbeLogHeader* header;
+    std::vector<std::string> names;
+    uint64_t recordCount;
+
+public:
+    ProbeLogReader();
+    ~ProbeLogReader();
+
+    // Prints the reason and returns false if path is not a usable log
+    bool open(const std::string& path);
+
+    const std::vector<std::string>& getTargets() const;
+    uint64_t getRecordCount() const;
+    size_t getBlockCount() const;
+    ProbeBlock getBlock(size_t index) const;
+};
+
+#endif
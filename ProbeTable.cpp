@@ -0,0 +1,65 @@
+#include "ProbeTable.hpp"
+
+ProbeTable::ProbeTable() : slots(SEQ_SPACE), tail(0), head(0), outstanding(0) {
+    clear();
+}
+
+bool ProbeTable::isFree(unsigned short seq) const {
+    return !slots[seq].active;
+}
+
+void ProbeTable::insert(unsigned short seq, const SendStamp& sendTime) {
+    Slot& slot = slots[seq];
+    if (!slot.active) {
+        outstanding++;
+    }
+    slot.sendTime = sendTime;
+    slot.active = true;
+
+    if (outstanding == 1) {
+        tail = seq;
+    }
+    head = (unsigned short)(seq + 1);
+}
+
+bool ProbeTable::take(unsigned short seq, SendStamp& sendTime) {
+    Slot& slot = slots[seq];
+    if (!slot.active) {
+        return false;
+    }
+    sendTime = slot.sendTime;
+    slot.active = false;
+    outstanding--;
+    return true;
+}
+
+void ProbeTable::erase(unsigned short seq) {
+    SendStamp unused;
+    take(seq, unused);
+}
+
+bool ProbeTable::oldest(unsigned short& seq, SendStamp& sendTime) {
+    if (outstanding == 0) {
+        tail = head;
+        return false;
+    }
+
+    while (!slots[tail].active) {
+        tail++;
+    }
+
+    seq = tail;
+    sendTime = slots[tail].sendTime;
+    return true;
+}
+
+void ProbeTable::clear() {
+    for (size_t i = 0; i < slots.size(); i++) {
+        slots[i].active = false;
+    }
+    tail = head;
+    outstanding = 0;
+}
+
+int ProbeTable::size() const { return outstanding; }
+bool ProbeTable::empty() const { return outstanding == 0; }
@@ -0,0 +1,39 @@
+#ifndef PROBE_TABLE_HPP
+#define PROBE_TABLE_HPP
+
+#include "Timestamp.hpp"
+#include <vector>
+
+// Send-time table for outstanding probes, indexed directly by the 16-bit
+// ICMP sequence number. Sequences are inserted in increasing (wrapping)
+// order, so the oldest outstanding probe is found by advancing a tail
+// index past answered slots: insert, match and expiry are all O(1).
+class ProbeTable {
+private:
+    struct Slot {
+        SendStamp sendTime;
+        bool active;
+    };
+
+    std::vector<Slot> slots;
+    unsigned short tail;
+    unsigned short head;
+    int outstanding;
+
+public:
+    static const int SEQ_SPACE = 65536;
+
+    ProbeTable();
+
+    bool isFree(unsigned short seq) const;
+    void insert(unsigned short seq, const SendStamp& sendTime);
+    bool take(unsigned short seq, SendStamp& sendTime);
+    void erase(unsigned short seq);
+    bool oldest(unsigned short& seq, SendStamp& sendTime);
+    void clear();
+
+    int size() const;
+    bool empty() const;
+};
+
+#endif
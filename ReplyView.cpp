@@ -0,0 +1,51 @@
+#include "ReplyView.hpp"
+#include "Checksum.hpp"
+
+bool parseReply(const char* data, int length, ReplyView& view) {
+    if (length < (int)sizeof(struct iphdr)) {
+        return false;
+    }
+
+    view.ip = (const struct iphdr*)data;
+    view.ipHeaderLength = view.ip->ihl * 4;
+    if (view.ipHeaderLength < (int)sizeof(struct iphdr) ||
+        length < view.ipHeaderLength + (int)sizeof(struct icmphdr)) {
+        return false;
+    }
+
+    view.icmp = (const struct icmphdr*)(data + view.ipHeaderLength);
+    view.icmpLength = length - view.ipHeaderLength;
+    view.payload = (const unsigned char*)view.icmp + sizeof(struct icmphdr);
+    view.payloadLength = view.icmpLength - (int)sizeof(struct icmphdr);
+    view.type = view.icmp->type;
+    view.code = view.icmp->code;
+    view.ttl = view.ip->ttl;
+    view.id = view.icmp->un.echo.id;
+    view.sequence = view.icmp->un.echo.sequence;
+    view.source = view.ip->saddr;
+
+    // Summing a message that includes its own checksum folds to zero
+    view.checksumValid = internetChecksum(view.icmp, view.icmpLength) == 0;
+
+    // Errors quote the offending IP header plus the first 8 bytes after it,
+    // which for a probe of ours is its whole ICMP header
+    view.isError = false;
+    if (view.type == ICMP_DEST_UNREACH || view.type == ICMP_TIME_EXCEEDED ||
+        view.type == ICMP_PARAMETERPROB) {
+        if (view.payloadLength >= (int)sizeof(struct iphdr)) {
+            const struct iphdr* quotedIp = (const struct iphdr*)view.payload;
+            int quotedHeaderLength = quotedIp->ihl * 4;
+            if (quotedHeaderLength >= (int)sizeof(struct iphdr) &&
+                view.payloadLength >= quotedHeaderLength + (int)sizeof(struct icmphdr)) {
+                const struct icmphdr* quoted =
+                    (const struct icmphdr*)(view.payload + quotedHeaderLength);
+                view.isError = true;
+                view.quotedType = quoted->type;
+                view.quotedId = quoted->un.echo.id;
+                view.quotedSequence = quoted->un.echo.sequence;
+                view.quotedDestination = quotedIp->daddr;
+            }
+        }
+    }
+    return true;
+}
@@ -0,0 +1,50 @@
+#ifndef REPLY_VIEW_HPP
+#define REPLY_VIEW_HPP
+
+#include <netinet/ip.h>
+#include <netinet/ip_icmp.h>
+
+// Zero-copy view of one received IPv4 ICMP packet. Every pointer refers
+// into the caller's receive buffer, which comes from a preallocated pool
+// (the client's rxBuffer, BatchIO's arena or UringIO's buffer ring), so
+// parsing a reply performs no allocation and no copy.
+struct ReplyView {
+    const struct iphdr* ip;
+    const struct icmphdr* icmp;
+    const unsigned char* payload;
+    int ipHeaderLength;
+    int icmpLength;             // ICMP header plus payload
+    int payloadLength;
+    unsigned char type;
+    unsigned char code;
+    unsigned char ttl;
+    unsigned short id;          // Host order, as the probes send it
+    unsigned short sequence;
+    unsigned int source;        // Network order
+    bool checksumValid;
+
+    // ICMP errors only: the header of our probe, quoted back by the router
+    // or host that reported the failure
+    bool isError;
+    unsigned char quotedType;
+    unsigned short quotedId;
+    unsigned short quotedSequence;
+    unsigned int quotedDestination;  // Network order
+};
+
+// False when the packet is too short to carry an ICMP header. The ICMP
+// checksum is verified over the whole message either way.
+bool parseReply(const char* data, int length, ReplyView& view);
+
+// Echo Reply with a valid checksum carrying the given identifier
+inline bool isEchoReplyFor(const ReplyView& view, unsigned short icmpId) {
+    return view.type == ICMP_ECHOREPLY && view.id == icmpId && view.checksumValid;
+}
+
+// ICMP error with a valid checksum quoting one of our Echo Requests
+inline bool isErrorFor(const ReplyView& view, unsigned short icmpId) {
+    return view.isError && view.quotedType == ICMP_ECHO && view.quotedId == icmpId &&
+           view.checksumValid;
+}
+
+#endif
@@ -0,0 +1,201 @@
+#include "Resolver.hpp"
+#include "Timestamp.hpp"
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <cstring>
+
+Resolver::Resolver(int threads, double positiveTtlSeconds, double negativeTtlSeconds)
+    : threadLimit(threads > 0 ? threads : 1), positiveTtl(positiveTtlSeconds),
+      negativeTtl(negativeTtlSeconds), notifyFd(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)),
+      lookupFunction(&Resolver::lookup), outstanding(0), lookups(0), stopping(false) {}
+
+Resolver::~Resolver() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    work.notify_all();
+    for (size_t i = 0; i < workers.size(); i++) {
+        workers[i].join();
+    }
+    if (notifyFd >= 0) {
+        close(notifyFd);
+    }
+}
+
+void Resolver::setThreadLimit(int threads) {
+    std::lock_guard<std::mutex> lock(mutex);
+    threadLimit = threads > 0 ? threads : 1;
+}
+
+void Resolver::setLookupFunction(LookupFunction function) {
+    std::lock_guard<std::mutex> lock(mutex);
+    lookupFunction = function != nullptr ? function : &Resolver::lookup;
+}
+
+int Resolver::getEventFd() const {
+    return notifyFd;
+}
+
+bool Resolver::lookup(const std::string& host, struct in_addr& addr, int& error) {
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_DGRAM;    // One entry per address instead of one per socket type
+
+    struct addrinfo* result = nullptr;
+    error = getaddrinfo(host.c_str(), nullptr, &hints, &result);
+    if (error != 0) {
+        return false;
+    }
+    addr = ((struct sockaddr_in*)result->ai_addr)->sin_addr;
+    freeaddrinfo(result);
+    return true;
+}
+
+const char* Resolver::describeError(int error) {
+    return gai_strerror(error);
+}
+
+void Resolver::signal() {
+    if (notifyFd >= 0) {
+        unsigned long long one = 1;
+        if (write(notifyFd, &one, sizeof(one)) < 0) {
+            // Counter saturated: it is readable either way
+        }
+    }
+}
+
+// Called with the mutex held. The eventfd is only written when the queue
+// turns non-empty: the reader clears it once it has drained the queue, so
+// one wakeup covers any number of results.
+void Resolver::post(const Resolution& result) {
+    if (completed.empty()) {
+        signal();
+    }
+    completed.push_back(result);
+}
+
+// Called with the mutex held: caches the answer and releases every tag
+// that was waiting on this name
+void Resolver::complete(const std::string& host, const CacheEntry& entry, double elapsedMs) {
+    cache[host] = entry;
+
+    std::unordered_map<std::string, std::vector<size_t> >::iterator it = waiting.find(host);
+    if (it == waiting.end()) {
+        return;
+    }
+    for (size_t i = 0; i < it->second.size(); i++) {
+        Resolution result;
+        result.tag = it->second[i];
+        result.ok = entry.ok;
+        result.addr = entry.addr;
+        result.error = entry.error;
+        result.elapsedMs = elapsedMs;
+        post(result);
+    }
+    waiting.erase(it);
+}
+
+void Resolver::submit(const std::string& host, size_t tag) {
+    Resolution result;
+    result.tag = tag;
+    result.error = 0;
+    result.elapsedMs = 0.0;
+
+    std::unique_lock<std::mutex> lock(mutex);
+    outstanding++;
+
+    if (inet_aton(host.c_str(), &result.addr) != 0) {
+        result.ok = true;
+        post(result);
+        return;
+    }
+
+    std::unordered_map<std::string, CacheEntry>::iterator cached = cache.find(host);
+    if (cached != cache.end() && elapsedMs(monotonicNow(), cached->second.expires) > 0.0) {
+        result.ok = cached->second.ok;
+        result.addr = cached->second.addr;
+        result.error = cached->second.error;
+        post(result);
+        return;
+    }
+
+    std::vector<size_t>& tags = waiting[host];
+    tags.push_back(tag);
+    if (tags.size() > 1) {
+        return; // Already being looked up; this tag rides along
+    }
+
+    Request request;
+    request.host = host;
+    request.submitted = monotonicNow();
+    requests.push_back(request);
+    lookups++;
+
+    // Threads start on demand, so a list of literal addresses never spawns one
+    if ((int)workers.size() < threadLimit) {
+        workers.push_back(std::thread(&Resolver::run, this));
+    }
+    lock.unlock();
+    work.notify_one();
+}
+
+void Resolver::run() {
+    std::unique_lock<std::mutex> lock(mutex);
+
+    for (;;) {
+        while (requests.empty() && !stopping) {
+            work.wait(lock);
+        }
+        if (stopping) {
+            break;
+        }
+
+        Request request = requests.front();
+        requests.pop_front();
+        LookupFunction resolve = lookupFunction;
+        lock.unlock();
+
+        CacheEntry entry;
+        memset(&entry.addr, 0, sizeof(entry.addr));
+        entry.ok = resolve(request.host, entry.addr, entry.error);
+        struct timespec now = monotonicNow();
+        entry.expires = addMs(now, (entry.ok ? positiveTtl : negativeTtl) * 1000.0);
+
+        lock.lock();
+        complete(request.host, entry, elapsedMs(request.submitted, now));
+    }
+}
+
+bool Resolver::next(Resolution& result) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if (completed.empty()) {
+        // Drain the counter only once the queue is empty, so a reader that
+        // stops early still sees the fd readable next time
+        unsigned long long count;
+        if (notifyFd >= 0 && read(notifyFd, &count, sizeof(count)) < 0) {
+            // EAGAIN: nothing was signalled
+        }
+        return false;
+    }
+
+    result = completed.front();
+    completed.pop_front();
+    outstanding--;
+    return true;
+}
+
+size_t Resolver::pending() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return outstanding;
+}
+
+size_t Resolver::getLookupCount() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return lookups;
+}
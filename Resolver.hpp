@@ -0,0 +1,101 @@
+#ifndef RESOLVER_HPP
+#define RESOLVER_HPP
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <netinet/in.h>
+#include <time.h>
+
+// Outcome of one submitted lookup, matched to the caller by its tag
+struct Resolution {
+    size_t tag;
+    bool ok;
+    struct in_addr addr;
+    int error;              // getaddrinfo() EAI_* code when !ok
+    double elapsedMs;       // Submit to completion, 0 for numeric and cached names
+};
+
+// Asynchronous IPv4 name resolution for large target lists. Lookups run on
+// a small pool of threads calling the reentrant getaddrinfo(), so /etc/hosts,
+// nsswitch and the system DNS configuration all apply. Completions are
+// queued and signalled on an eventfd the caller can add to its epoll set,
+// so probing can start per target as its address arrives. Numeric
+// addresses and cache hits complete at submit time without touching the
+// pool, and concurrent lookups of the same name share one query.
+//
+// getaddrinfo() does not expose record TTLs, so cached answers live for a
+// fixed time instead: positiveTtl seconds for addresses, negativeTtl for
+// failures.
+class Resolver {
+public:
+    // Blocking lookup of one name: the address, or false and an EAI_* code
+    typedef bool (*LookupFunction)(const std::string& host, struct in_addr& addr, int& error);
+
+private:
+    struct CacheEntry {
+        bool ok;
+        struct in_addr addr;
+        int error;
+        struct timespec expires;
+    };
+
+    struct Request {
+        std::string host;
+        struct timespec submitted;
+    };
+
+    int threadLimit;
+    double positiveTtl;
+    double negativeTtl;
+    int notifyFd;
+    LookupFunction lookupFunction;
+
+    std::mutex mutex;
+    std::condition_variable work;
+    std::deque<Request> requests;
+    std::deque<Resolution> completed;
+    std::unordered_map<std::string, std::vector<size_t> > waiting;  // Tags per in-flight name
+    std::unordered_map<std::string, CacheEntry> cache;
+    std::vector<std::thread> workers;
+    size_t outstanding;     // Submitted, not yet handed back through next()
+    size_t lookups;         // Names handed to lookupFunction
+    bool stopping;
+
+    void run();
+    void complete(const std::string& host, const CacheEntry& entry, double elapsedMs);
+    void post(const Resolution& result);
+    void signal();
+
+public:
+    static const int DEFAULT_THREADS = 8;
+
+    explicit Resolver(int threads = DEFAULT_THREADS, double positiveTtlSeconds = 300.0,
+                      double negativeTtlSeconds = 30.0);
+    ~Resolver();
+
+    // Takes effect for threads not yet started
+    void setThreadLimit(int threads);
+    // lookup() by default; tests substitute their own. Set before the first submit().
+    void setLookupFunction(LookupFunction function);
+    // Readable while completions are waiting; -1 if eventfd() failed
+    int getEventFd() const;
+
+    void submit(const std::string& host, size_t tag);
+    // Non-blocking; clears the eventfd once the queue is empty
+    bool next(Resolution& result);
+    // Lookups submitted but not yet returned by next()
+    size_t pending();
+    // Queries issued so far; names answered at submit or riding along do not count
+    size_t getLookupCount();
+
+    // One blocking lookup, for callers with a single name
+    static bool lookup(const std::string& host, struct in_addr& addr, int& error);
+    static const char* describeError(int error);
+};
+
+#endif
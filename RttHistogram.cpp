@@ -0,0 +1,119 @@
+#include "RttHistogram.hpp"
+#include <cmath>
+
+RttHistogram::RttHistogram() : total(0) {}
+
+int RttHistogram::bucketIndex(unsigned long long ns) {
+    const unsigned long long subBuckets = 1ULL << SUB_BUCKET_BITS;
+    const unsigned long long maxValue = (1ULL << MAX_EXPONENT) - 1;
+
+    if (ns < subBuckets) {
+        return (int)ns;
+    }
+    if (ns > maxValue) {
+        ns = maxValue;
+    }
+
+    int exponent = 63 - __builtin_clzll(ns);
+    int shift = exponent - (SUB_BUCKET_BITS - 1);
+    int mantissa = (int)(ns >> shift) - (int)(subBuckets / 2);
+    return (int)subBuckets + (exponent - SUB_BUCKET_BITS) * (int)(subBuckets / 2) + mantissa;
+}
+
+unsigned long long RttHistogram::bucketMidpoint(int index) {
+    const int subBuckets = 1 << SUB_BUCKET_BITS;
+
+    if (index < subBuckets) {
+        return (unsigned long long)index;
+    }
+
+    int offset = index - subBuckets;
+    int exponent = SUB_BUCKET_BITS + offset / (subBuckets / 2);
+    int shift = exponent - (SUB_BUCKET_BITS - 1);
+    unsigned long long mantissa = (unsigned long long)(subBuckets / 2 + offset % (subBuckets / 2));
+    unsigned long long lower = mantissa << shift;
+    return lower + ((1ULL << shift) >> 1);
+}
+
+int RttHistogram::indexOf(double rttMs) {
+    double ns = rttMs * 1000000.0;
+    return bucketIndex(ns > 0.0 ? (unsigned long long)ns : 0ULL);
+}
+
+void RttHistogram::record(double rttMs) {
+    if (counts.empty()) {
+        counts.assign(BUCKET_COUNT, 0);
+    }
+
+    counts[indexOf(rttMs)]++;
+    total++;
+}
+
+void RttHistogram::merge(const RttHistogram& other) {
+    if (other.total == 0) {
+        return;
+    }
+    if (counts.empty()) {
+        counts.assign(BUCKET_COUNT, 0);
+    }
+
+    for (int i = 0; i < BUCKET_COUNT; i++) {
+        counts[i] += other.counts[i];
+    }
+    total += other.total;
+}
+
+void RttHistogram::subtract(const RttHistogram& other) {
+    if (other.total == 0 || counts.empty()) {
+        return;
+    }
+
+    for (int i = 0; i < BUCKET_COUNT; i++) {
+        counts[i] -= other.counts[i];
+    }
+    total -= other.total;
+}
+
+void RttHistogram::clear() {
+    counts.clear();
+    total = 0;
+}
+
+double RttHistogram::percentile(double p) const {
+    if (total == 0) {
+        return 0.0;
+    }
+
+    unsigned long long rank = (unsigned long long)std::ceil(p / 100.0 * total);
+    if (rank < 1) rank = 1;
+    if (rank > total) rank = total;
+
+    unsigned long long seen = 0;
+    for (int i = 0; i < BUCKET_COUNT; i++) {
+        seen += counts[i];
+        if (seen >= rank) {
+            return bucketMidpoint(i) / 1000000.0;
+        }
+    }
+
+    return bucketMidpoint(BUCKET_COUNT - 1) / 1000000.0;
+}
+
+unsigned long long RttHistogram::getCount() const {
+    return total;
+}
+
+unsigned int RttHistogram::getBucket(int index) const {
+    return counts.empty() ? 0 : counts[index];
+}
+
+void RttHistogram::addToBucket(int index, unsigned int count) {
+    if (count == 0) {
+        return;
+    }
+    if (counts.empty()) {
+        counts.assign(BUCKET_COUNT, 0);
+    }
+    counts[index] += count;
+    total += count;
+}
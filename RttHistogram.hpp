@@ -0,0 +1,44 @@
+#ifndef RTT_HISTOGRAM_HPP
+#define RTT_HISTOGRAM_HPP
+
+#include <vector>
+
+// Fixed-memory log-linear (HDR-style) histogram of RTTs in nanoseconds.
+// Values below 64 ns are exact; above that every power of two is split
+// into 32 linear sub-buckets, so any reported percentile is within ~1.6%
+// of the true sample. Recording is O(1), and two histograms merge by
+// adding their counts, so per-run or per-thread results can be combined.
+// The bucket array is only allocated on the first sample, which keeps
+// unreachable targets in a large sweep essentially free.
+class RttHistogram {
+private:
+    std::vector<unsigned int> counts;
+    unsigned long long total;
+
+    static int bucketIndex(unsigned long long ns);
+    static unsigned long long bucketMidpoint(int index);
+
+public:
+    static const int SUB_BUCKET_BITS = 6;
+    static const int MAX_EXPONENT = 37;   // Values are clamped below 2^37 ns (~137 s)
+    static const int BUCKET_COUNT = (1 << SUB_BUCKET_BITS) +
+                                    (MAX_EXPONENT - SUB_BUCKET_BITS) * (1 << (SUB_BUCKET_BITS - 1));
+
+    RttHistogram();
+
+    void record(double rttMs);
+    void merge(const RttHistogram& other);
+    // Undoes an earlier merge: other must be a subset of the samples held
+    void subtract(const RttHistogram& other);
+    void clear();
+
+    double percentile(double p) const;
+    unsigned long long getCount() const;
+
+    // Raw bucket access for copying a histogram into shared memory and back
+    static int indexOf(double rttMs);
+    unsigned int getBucket(int index) const;
+    void addToBucket(int index, unsigned int count);
+};
+
+#endif
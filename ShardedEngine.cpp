@@ -0,0 +1,191 @@
+#include "ShardedEngine.hpp"
+#include "utils.hpp"
+#include "Output.hpp"
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <thread>
+
+ShardedEngine::ShardedEngine(int workers, double timeoutMs, double intervalMs, size_t payloadSize)
+    : aggregator(workers > 0 ? workers : 1), targetCount(0), durationMs(0.0) {
+    int count = aggregator.getShardCount();
+    unsigned short baseId = (unsigned short)getpid();
+
+    for (int i = 0; i < count; i++) {
+        shards.push_back(std::unique_ptr<PingEngine>(new PingEngine(timeoutMs, intervalMs, payloadSize)));
+        shards[i]->setShard(&aggregator, i, (unsigned short)(baseId + i));
+        // Split the lookup pool so W workers do not start W full pools
+        shards[i]->setResolverThreads(std::max(2, Resolver::DEFAULT_THREADS / count));
+    }
+
+    // Pin to the cores this process may use, not simply 0..n-1
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) == 0) {
+        for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+            if (CPU_ISSET(cpu, &allowed)) {
+                cpus.push_back(cpu);
+            }
+        }
+    }
+}
+
+void ShardedEngine::setRateLimit(double perSecond, double burst) {
+    double workers = (double)shards.size();
+    for (size_t i = 0; i < shards.size(); i++) {
+        shards[i]->setRateLimit(perSecond / workers, burst > 0.0 ? burst / workers : 0.0);
+    }
+}
+
+void ShardedEngine::setProbeLog(const std::string& path) {
+    for (size_t i = 0; i < shards.size(); i++) {
+        shards[i]->setProbeLog(path + "." + std::to_string(i));
+    }
+}
+
+void ShardedEngine::setStatsSegment(const std::string& name) {
+    statsSegmentName = name;
+}
+
+void ShardedEngine::addTarget(const std::string& host, double intervalMs, double timeoutMs) {
+    shards[targetCount % shards.size()]->addTarget(host, intervalMs, timeoutMs);
+    targetNames.push_back(host);
+    targetCount++;
+}
+
+int ShardedEngine::getWorkerCount() const {
+    return (int)shards.size();
+}
+
+bool ShardedEngine::initialize() {
+    if (traceEnabled()) {
+        printHeader("ICMP PING - MULTI-TARGET MODE (SHARDED)");
+
+        std::cout << std::endl;
+        printInfo("Target Count", (int)targetCount);
+        printInfo("Worker Threads", (int)shards.size());
+        printInfo("Usable CPUs", (int)cpus.size());
+        printInfo("Process ID", getpid());
+        std::cout << std::endl;
+    }
+
+    if (!statsSegmentName.empty()) {
+        if (!statsSegment.open(statsSegmentName, targetNames)) {
+            return false;
+        }
+        // Worker i holds targets i, i + W, i + 2W, ...
+        for (size_t i = 0; i < shards.size(); i++) {
+            shards[i]->attachStatsSegment(&statsSegment, i, shards.size());
+        }
+        if (traceEnabled()) {
+            printInfo("Statistics Segment", statsSegment.getName() + " (read with pingstat)");
+        }
+    }
+
+    int ready = 0;
+    for (size_t i = 0; i < shards.size(); i++) {
+        if (shards[i]->getTargetCount() == 0) {
+            continue; // More workers than targets
+        }
+        if (traceEnabled()) {
+            std::cout << std::endl;
+            printSection("WORKER " + std::to_string(i));
+            printInfo("Targets", (int)shards[i]->getTargetCount());
+            printInfo("ICMP ID", (unsigned short)(getpid() + i));
+            if (!cpus.empty()) {
+                printInfo("Pinned To CPU", cpus[i % cpus.size()]);
+            }
+        }
+        if (shards[i]->initialize()) {
+            ready++;
+        }
+    }
+
+    return ready > 0;
+}
+
+void ShardedEngine::run(int count) {
+    bool trace = traceEnabled();
+    if (trace) {
+        std::cout << std::endl;
+        printHeader("STARTING SHARDED PING SEQUENCE");
+        printInfo("Probes Per Target", count);
+        std::cout << std::endl;
+    }
+    std::cout.flush();
+
+    std::mutex doneMutex;
+    std::condition_variable doneSignal;
+    int running = 0;
+    std::vector<std::thread> workers;
+    struct timespec start = monotonicNow();
+
+    for (size_t i = 0; i < shards.size(); i++) {
+        if (shards[i]->getTargetCount() == 0) {
+            continue;
+        }
+        PingEngine* shard = shards[i].get();
+        running++;
+        workers.push_back(std::thread([shard, count, &doneMutex, &doneSignal, &running]() {
+            shard->runShard(count);
+            std::lock_guard<std::mutex> lock(doneMutex);
+            running--;
+            doneSignal.notify_one();
+        }));
+
+        if (!cpus.empty()) {
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            CPU_SET(cpus[i % cpus.size()], &set);
+            pthread_setaffinity_np(workers.back().native_handle(), sizeof(set), &set);
+        }
+    }
+
+    // The workers never touch this lock while probing; it only ends the wait
+    std::unique_lock<std::mutex> lock(doneMutex);
+    while (running > 0) {
+        doneSignal.wait_for(lock, std::chrono::seconds(1));
+        if (trace && running > 0) {
+            ShardTotals live = aggregator.collect();
+            Output::writeHuman("  [PROGRESS] transmitted=" + std::to_string(live.transmitted) +
+                               " received=" + std::to_string(live.received) +
+                               " errors=" + std::to_string(live.errors) + "\n");
+        }
+    }
+    lock.unlock();
+
+    for (size_t i = 0; i < workers.size(); i++) {
+        workers[i].join();
+    }
+    durationMs = elapsedMs(start, monotonicNow());
+}
+
+void ShardedEngine::printSummary() const {
+    std::cout << std::endl;
+    printHeader("MULTI-TARGET PING STATISTICS");
+
+    // Targets were dealt round-robin; walking them back the same way keeps
+    // input order. The aggregator only carries counters and extremes, so the
+    // totals merge the workers' full statistics, histograms included.
+    int alive = 0;
+    PingStatistics all;
+    for (size_t i = 0; i < targetCount; i++) {
+        const PingStatistics* stats = shards[i % shards.size()]->summarizeTarget(i / shards.size());
+        if (stats == nullptr) {
+            continue;
+        }
+        all.merge(*stats);
+        if (stats->getReceived() > 0) {
+            alive++;
+        }
+    }
+
+    PingEngine::printTotals(targetCount, alive, all, durationMs / 1000.0);
+}
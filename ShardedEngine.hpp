@@ -0,0 +1,47 @@
+#ifndef SHARDED_ENGINE_HPP
+#define SHARDED_ENGINE_HPP
+
+#include "PingEngine.hpp"
+#include "StatsAggregator.hpp"
+#include "StatsSegment.hpp"
+#include <memory>
+#include <string>
+#include <vector>
+
+// Multi-core multi-target mode: targets are dealt round-robin to worker
+// threads pinned to separate cores. Each worker is a complete PingEngine
+// with its own raw socket, epoll loop and per-target statistics; a
+// distinct ICMP id per worker, enforced by each socket's BPF filter, keeps
+// the kernel from waking one worker for another's replies. The only state
+// shared while probing is the lock-free StatsAggregator (and the slots of
+// the statistics segment, one writer each).
+class ShardedEngine {
+private:
+    std::vector<std::unique_ptr<PingEngine> > shards;
+    std::vector<int> cpus;
+    StatsAggregator aggregator;
+    std::string statsSegmentName;
+    StatsSegment statsSegment;          // One segment, slots in input order across workers
+    std::vector<std::string> targetNames;
+    size_t targetCount;
+    double durationMs;
+
+public:
+    ShardedEngine(int workers, double timeoutMs = 2000.0, double intervalMs = 1000.0,
+                  size_t payloadSize = ICMPPacket::DEFAULT_PAYLOAD_SIZE);
+
+    // Split evenly, so the whole process still honors the requested rate
+    void setRateLimit(double perSecond, double burst = 0.0);
+    // One log file per worker: <path>.0, <path>.1, ...
+    void setProbeLog(const std::string& path);
+    // One live statistics segment for the whole process
+    void setStatsSegment(const std::string& name);
+    void addTarget(const std::string& host, double intervalMs = 0.0, double timeoutMs = 0.0);
+    int getWorkerCount() const;
+
+    bool initialize();
+    void run(int count = 4);
+    void printSummary() const;
+};
+
+#endif
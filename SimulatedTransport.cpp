@@ -0,0 +1,408 @@
+#include "SimulatedTransport.hpp"
+#include "Checksum.hpp"
+#include "Output.hpp"
+#include "utils.hpp"
+#include <arpa/inet.h>
+#include <netinet/ip.h>
+#include <netinet/ip_icmp.h>
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+
+static long long toNs(const struct timespec& ts) {
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static struct timespec fromNs(long long ns) {
+    struct timespec ts;
+    ts.tv_sec = (time_t)(ns / 1000000000LL);
+    ts.tv_nsec = (long)(ns % 1000000000LL);
+    return ts;
+}
+
+static bool parseRate(const std::string& text, double& rate) {
+    char* end = nullptr;
+    rate = strtod(text.c_str(), &end);
+    return end != text.c_str() && *end == '\0' && rate >= 0.0 && rate <= 1.0;
+}
+
+static bool parseMs(const std::string& text, double& ms) {
+    char* end = nullptr;
+    ms = strtod(text.c_str(), &end);
+    return end != text.c_str() && *end == '\0' && ms >= 0.0;
+}
+
+bool parseSimulation(const std::string& spec, SimulationConfig& config, std::string& error) {
+    std::stringstream fields(spec);
+    std::string field;
+
+    while (std::getline(fields, field, ',')) {
+        if (field.empty()) {
+            continue;
+        }
+        size_t equals = field.find('=');
+        std::string key = field.substr(0, equals);
+        std::string value = equals == std::string::npos ? "" : field.substr(equals + 1);
+        bool ok = true;
+
+        if (key == "dist") {
+            if (value == "fixed") config.model = LATENCY_FIXED;
+            else if (value == "uniform") config.model = LATENCY_UNIFORM;
+            else if (value == "normal") config.model = LATENCY_NORMAL;
+            else if (value == "exp" || value == "exponential") config.model = LATENCY_EXPONENTIAL;
+            else ok = false;
+        } else if (key == "latency") {
+            ok = parseMs(value, config.latencyMs);
+        } else if (key == "jitter") {
+            ok = parseMs(value, config.jitterMs);
+        } else if (key == "hold") {
+            ok = parseMs(value, config.reorderDelayMs);
+        } else if (key == "loss") {
+            ok = parseRate(value, config.lossRate);
+        } else if (key == "dup") {
+            ok = parseRate(value, config.duplicateRate);
+        } else if (key == "reorder") {
+            ok = parseRate(value, config.reorderRate);
+        } else if (key == "error") {
+            ok = parseRate(value, config.errorRate);
+        } else if (key == "code") {
+            config.errorCode = atoi(value.c_str());
+            ok = !value.empty() && config.errorCode >= 0 && config.errorCode <= 15;
+        } else if (key == "ttl") {
+            config.replyTtl = atoi(value.c_str());
+            ok = !value.empty() && config.replyTtl >= 1 && config.replyTtl <= 255;
+        } else if (key == "seed") {
+            config.seed = strtoull(value.c_str(), nullptr, 10);
+            ok = !value.empty();
+        } else {
+            error = "unknown simulation field \"" + key + "\"";
+            return false;
+        }
+
+        if (!ok) {
+            error = "bad value for simulation field \"" + key + "\": \"" + value + "\"";
+            return false;
+        }
+    }
+    return true;
+}
+
+const char* getLatencyModelName(LatencyModel model) {
+    switch (model) {
+        case LATENCY_FIXED: return "fixed";
+        case LATENCY_UNIFORM: return "uniform";
+        case LATENCY_NORMAL: return "normal";
+        case LATENCY_EXPONENTIAL: return "exponential";
+    }
+    return "unknown";
+}
+
+SimulatedTransport::SimulatedTransport(const SimulationConfig& simulation)
+    : config(simulation), state(simulation.seed), opened(false), slotSize(0), nextOrder(0),
+      requests(0), dropped(0), errors(0), duplicated(0), reordered(0), delivered(0) {}
+
+const char* SimulatedTransport::getName() const {
+    return "simulated";
+}
+
+bool SimulatedTransport::open(unsigned short icmpId, size_t replySize, size_t queueBytes) {
+    (void)icmpId;
+
+    // Room for the largest reply or an error quoting a minimal probe
+    slotSize = std::max(replySize, (size_t)(2 * sizeof(struct iphdr) + 2 * sizeof(struct icmphdr)));
+    slab.clear();
+    freeSlots.clear();
+    arrivals.clear();
+    // A stalled reader can find a whole window of late replies still queued
+    // behind the next window, so leave room for several; the bookkeeping
+    // gets the same capacity, so the stalls a run hits do not change what
+    // it allocates
+    slab.reserve(std::max(queueBytes * 4, slotSize * 256));
+    freeSlots.reserve(slab.capacity() / slotSize);
+    arrivals.reserve(slab.capacity() / slotSize);
+    opened = true;
+
+    if (traceEnabled()) {
+        printSection("SIMULATED NETWORK");
+        std::cout << "  [SUCCESS] In-process echo responder ready (no socket, no root)" << std::endl;
+        printInfo("Latency Model", getLatencyModelName(config.model));
+        printInfo("Base Latency", formatDouble(config.latencyMs) + " ms");
+        printInfo("Jitter", formatDouble(config.jitterMs) + " ms");
+        printInfo("Loss Rate", config.lossRate, 25, 4);
+        printInfo("Duplicate Rate", config.duplicateRate, 25, 4);
+        printInfo("Reorder Rate", formatDouble(config.reorderRate, 4) + " (held " +
+                                  formatDouble(config.reorderDelayMs) + " ms)");
+        printInfo("ICMP Error Rate", formatDouble(config.errorRate, 4) + " (code " +
+                                     std::to_string(config.errorCode) + ")");
+        printInfo("Random Seed", std::to_string(config.seed));
+    }
+    return true;
+}
+
+void SimulatedTransport::close() {
+    opened = false;
+    arrivals.clear();
+}
+
+int SimulatedTransport::getFd() const {
+    return -1;
+}
+
+TimestampMode SimulatedTransport::getTimestampMode() const {
+    return TIMESTAMP_NONE;
+}
+
+// splitmix64: tiny, fast and good enough to drive fault injection
+double SimulatedTransport::uniform() {
+    unsigned long long z = (state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    z ^= z >> 31;
+    return (double)(z >> 11) * (1.0 / 9007199254740992.0);
+}
+
+long long SimulatedTransport::sampleLatencyNs() {
+    double ms = config.latencyMs;
+    switch (config.model) {
+        case LATENCY_FIXED:
+            break;
+        case LATENCY_UNIFORM:
+            ms += config.jitterMs * uniform();
+            break;
+        case LATENCY_NORMAL: {
+            // Box-Muller; 1 - u keeps the logarithm finite
+            double u1 = 1.0 - uniform();
+            double u2 = uniform();
+            ms += config.jitterMs * std::sqrt(-2.0 * std::log(u1)) * std::cos(2.0 * M_PI * u2);
+            break;
+        }
+        case LATENCY_EXPONENTIAL:
+            ms += -config.jitterMs * std::log(1.0 - uniform());
+            break;
+    }
+    return ms > 0.0 ? (long long)(ms * 1000000.0) : 0;
+}
+
+char* SimulatedTransport::allocate(unsigned int& slot) {
+    if (freeSlots.empty()) {
+        slot = (unsigned int)(slab.size() / slotSize);
+        slab.resize(slab.size() + slotSize);
+    } else {
+        slot = freeSlots.back();
+        freeSlots.pop_back();
+    }
+    return &slab[slot * slotSize];
+}
+
+void SimulatedTransport::schedule(unsigned int slot, unsigned int length, unsigned int source, long long atNs) {
+    Arrival arrival;
+    arrival.atNs = atNs;
+    arrival.order = nextOrder++;
+    arrival.slot = slot;
+    arrival.length = length;
+    arrival.source = source;
+    arrivals.push_back(arrival);
+    std::push_heap(arrivals.begin(), arrivals.end(), Later());
+}
+
+// The request with type 0 and an IP header in front, as the target's
+// stack would send it back
+void SimulatedTransport::queueReply(const char* request, size_t length, const struct sockaddr_in& dest,
+                                    long long atNs) {
+    unsigned int slot;
+    char* packet = allocate(slot);
+    size_t total = std::min(sizeof(struct iphdr) + length, slotSize);
+
+    struct iphdr* ip = (struct iphdr*)packet;
+    memset(ip, 0, sizeof(*ip));
+    ip->version = 4;
+    ip->ihl = 5;
+    ip->tot_len = htons((unsigned short)(sizeof(struct iphdr) + length));
+    ip->ttl = (unsigned char)config.replyTtl;
+    ip->protocol = IPPROTO_ICMP;
+    ip->saddr = dest.sin_addr.s_addr;
+    ip->daddr = htonl(INADDR_LOOPBACK);
+    ip->check = internetChecksum(ip, sizeof(*ip));
+
+    memcpy(packet + sizeof(struct iphdr), request, total - sizeof(struct iphdr));
+    struct icmphdr* icmp = (struct icmphdr*)(packet + sizeof(struct iphdr));
+    unsigned short oldWord;
+    memcpy(&oldWord, icmp, sizeof(oldWord));
+    icmp->type = ICMP_ECHOREPLY;
+    unsigned short newWord;
+    memcpy(&newWord, icmp, sizeof(newWord));
+    icmp->checksum = checksumUpdate(icmp->checksum, oldWord, newWord);
+
+    schedule(slot, (unsigned int)total, dest.sin_addr.s_addr, atNs);
+}
+
+// Destination Unreachable from the simulated router, quoting the probe's IP
+// header and first 8 ICMP bytes (RFC 792)
+void SimulatedTransport::queueError(const char* request, size_t length, const struct sockaddr_in& dest,
+                                    long long atNs) {
+    unsigned int slot;
+    char* packet = allocate(slot);
+    size_t total = 2 * sizeof(struct iphdr) + 2 * sizeof(struct icmphdr);
+
+    struct iphdr* ip = (struct iphdr*)packet;
+    memset(ip, 0, sizeof(*ip));
+    ip->version = 4;
+    ip->ihl = 5;
+    ip->tot_len = htons((unsigned short)total);
+    ip->ttl = (unsigned char)config.replyTtl;
+    ip->protocol = IPPROTO_ICMP;
+    ip->saddr = htonl(ROUTER_ADDRESS);
+    ip->daddr = htonl(INADDR_LOOPBACK);
+    ip->check = internetChecksum(ip, sizeof(*ip));
+
+    struct icmphdr* icmp = (struct icmphdr*)(packet + sizeof(struct iphdr));
+    memset(icmp, 0, sizeof(*icmp));
+    icmp->type = ICMP_DEST_UNREACH;
+    icmp->code = (unsigned char)config.errorCode;
+
+    struct iphdr* quoted = (struct iphdr*)(icmp + 1);
+    memset(quoted, 0, sizeof(*quoted));
+    quoted->version = 4;
+    quoted->ihl = 5;
+    quoted->tot_len = htons((unsigned short)(sizeof(struct iphdr) + length));
+    quoted->ttl = 64;
+    quoted->protocol = IPPROTO_ICMP;
+    quoted->saddr = htonl(INADDR_LOOPBACK);
+    quoted->daddr = dest.sin_addr.s_addr;
+    quoted->check = internetChecksum(quoted, sizeof(*quoted));
+    memcpy(quoted + 1, request, sizeof(struct icmphdr));
+
+    icmp->checksum = internetChecksum(icmp, total - sizeof(struct iphdr));
+
+    schedule(slot, (unsigned int)total, htonl(ROUTER_ADDRESS), atNs);
+}
+
+int SimulatedTransport::send(const char* data, size_t length, const struct sockaddr_in& dest) {
+    if (!opened) {
+        errno = EBADF;
+        return -1;
+    }
+    if (length < sizeof(struct icmphdr) || sizeof(struct iphdr) + length > slotSize) {
+        errno = EMSGSIZE;
+        return -1;
+    }
+    if (((const struct icmphdr*)data)->type != ICMP_ECHO) {
+        return (int)length; // Nothing answers anything else
+    }
+    requests++;
+
+    // Every request draws the same numbers, so one fault never shifts the
+    // random stream of the probes after it
+    double lossDraw = uniform();
+    double errorDraw = uniform();
+    double duplicateDraw = uniform();
+    double reorderDraw = uniform();
+    long long now = toNs(monotonicNow());
+    long long arrival = now + sampleLatencyNs();
+
+    if (lossDraw < config.lossRate) {
+        dropped++;
+        return (int)length;
+    }
+    if (reorderDraw < config.reorderRate) {
+        arrival += (long long)(config.reorderDelayMs * 1000000.0);
+        reordered++;
+    }
+
+    if (errorDraw < config.errorRate) {
+        queueError(data, length, dest, arrival);
+        errors++;
+        return (int)length;
+    }
+
+    queueReply(data, length, dest, arrival);
+    if (duplicateDraw < config.duplicateRate) {
+        queueReply(data, length, dest, now + sampleLatencyNs());
+        duplicated++;
+    }
+    return (int)length;
+}
+
+int SimulatedTransport::receive(char* buffer, size_t length, struct sockaddr_in* from, RecvStamp& stamp) {
+    if (arrivals.empty() || arrivals.front().atNs > toNs(monotonicNow())) {
+        errno = EAGAIN;
+        return -1;
+    }
+
+    Arrival arrival = arrivals.front();
+    std::pop_heap(arrivals.begin(), arrivals.end(), Later());
+    arrivals.pop_back();
+
+    size_t copied = std::min((size_t)arrival.length, length);
+    memcpy(buffer, &slab[arrival.slot * slotSize], copied);
+    freeSlots.push_back(arrival.slot);
+    delivered++;
+
+    if (from != nullptr) {
+        memset(from, 0, sizeof(*from));
+        from->sin_family = AF_INET;
+        from->sin_addr.s_addr = arrival.source;
+    }
+    stamp.mono = fromNs(arrival.atNs);
+    stamp.hasKernel = false;
+    stamp.hasHardware = false;
+    return (int)copied;
+}
+
+int SimulatedTransport::wait(double waitMs) {
+    long long now = toNs(monotonicNow());
+    long long deadline = now + (long long)(waitMs * 1000000.0);
+
+    if (!arrivals.empty() && arrivals.front().atNs < deadline) {
+        deadline = arrivals.front().atNs;
+    }
+    // Sleep most of the way, then spin: timer slack would otherwise add
+    // tens of microseconds to every simulated microsecond-scale RTT
+    if (deadline - now > SPIN_NS) {
+        struct timespec until = fromNs(deadline - SPIN_NS);
+        int result;
+        do {
+            result = clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &until, nullptr);
+        } while (result == EINTR);
+    }
+    while (toNs(monotonicNow()) < deadline) {
+    }
+    return !arrivals.empty() && arrivals.front().atNs <= deadline ? 1 : 0;
+}
+
+void SimulatedTransport::printSummary() const {
+    if (Output::level < OUTPUT_CLASSIC) {
+        return;
+    }
+    std::cout << "simulated network: " << requests << " requests, " << dropped << " dropped, "
+              << errors << " errors, " << duplicated << " duplicated, " << reordered
+              << " reordered, " << delivered << " delivered" << std::endl;
+}
+
+unsigned long long SimulatedTransport::getRequests() const {
+    return requests;
+}
+
+unsigned long long SimulatedTransport::getDropped() const {
+    return dropped;
+}
+
+unsigned long long SimulatedTransport::getErrors() const {
+    return errors;
+}
+
+unsigned long long SimulatedTransport::getDuplicated() const {
+    return duplicated;
+}
+
+unsigned long long SimulatedTransport::getReordered() const {
+    return reordered;
+}
+
+unsigned long long SimulatedTransport::getDelivered() const {
+    return delivered;
+}
@@ -0,0 +1,114 @@
+#ifndef SIMULATED_TRANSPORT_HPP
+#define SIMULATED_TRANSPORT_HPP
+
+#include "Transport.hpp"
+#include <string>
+#include <vector>
+
+enum LatencyModel {
+    LATENCY_FIXED,          // Every reply takes latencyMs
+    LATENCY_UNIFORM,        // latencyMs plus up to jitterMs, evenly spread
+    LATENCY_NORMAL,         // Mean latencyMs, standard deviation jitterMs, never below 0
+    LATENCY_EXPONENTIAL     // latencyMs plus an exponential tail of mean jitterMs
+};
+
+struct SimulationConfig {
+    LatencyModel model;
+    double latencyMs;
+    double jitterMs;
+    double lossRate;        // Probabilities per probe, 0 - 1
+    double duplicateRate;
+    double reorderRate;
+    double reorderDelayMs;  // Extra hold for a reordered reply
+    double errorRate;       // Answered by Destination Unreachable instead
+    int errorCode;
+    int replyTtl;
+    unsigned long long seed;
+
+    SimulationConfig() : model(LATENCY_FIXED), latencyMs(0.05), jitterMs(0.0), lossRate(0.0),
+                         duplicateRate(0.0), reorderRate(0.0), reorderDelayMs(1.0), errorRate(0.0),
+                         errorCode(1), replyTtl(64), seed(1) {}
+};
+
+// Parses "key=value,key=value" (dist, latency, jitter, loss, dup, reorder,
+// hold, error, code, ttl, seed) over the defaults; false with a message
+// naming the bad field otherwise
+bool parseSimulation(const std::string& spec, SimulationConfig& config, std::string& error);
+const char* getLatencyModelName(LatencyModel model);
+
+// An echo responder inside the process: every request is answered at
+// send() time, and the answer is queued with the instant it "arrives".
+// receive() hands out whatever has arrived and wait() sleeps until the next
+// arrival, so a run needs no root, no network and no second thread, and
+// replies come back as fast as the caller can take them.
+//
+// Loss, errors, duplicates and reordering are drawn from a seeded
+// generator in send order, so the same options and seed inject the same
+// faults into the same probes on every run. The receive stamp is the
+// arrival instant, which is what a kernel timestamp would report.
+class SimulatedTransport : public Transport {
+private:
+    struct Arrival {
+        long long atNs;             // CLOCK_MONOTONIC
+        unsigned long long order;   // Ties keep send order
+        unsigned int slot;
+        unsigned int length;
+        unsigned int source;        // Network order
+    };
+
+    struct Later {
+        bool operator()(const Arrival& a, const Arrival& b) const {
+            return a.atNs != b.atNs ? a.atNs > b.atNs : a.order > b.order;
+        }
+    };
+
+    SimulationConfig config;
+    unsigned long long state;
+    bool opened;
+    size_t slotSize;
+    std::vector<char> slab;
+    std::vector<unsigned int> freeSlots;
+    std::vector<Arrival> arrivals;      // Min-heap on arrival time
+    unsigned long long nextOrder;
+
+    unsigned long long requests;
+    unsigned long long dropped;
+    unsigned long long errors;
+    unsigned long long duplicated;
+    unsigned long long reordered;
+    unsigned long long delivered;
+
+    double uniform();
+    long long sampleLatencyNs();
+    char* allocate(unsigned int& slot);
+    void schedule(unsigned int slot, unsigned int length, unsigned int source, long long atNs);
+    void queueReply(const char* request, size_t length, const struct sockaddr_in& dest, long long atNs);
+    void queueError(const char* request, size_t length, const struct sockaddr_in& dest, long long atNs);
+
+public:
+    static const long long SPIN_NS = 50000;
+    static const unsigned int ROUTER_ADDRESS = 0xC0000201u;  // 192.0.2.1 (host order) sends the errors
+
+    explicit SimulatedTransport(const SimulationConfig& simulation = SimulationConfig());
+
+    const char* getName() const;
+    bool open(unsigned short icmpId, size_t replySize, size_t queueBytes);
+    void close();
+    int getFd() const;
+    TimestampMode getTimestampMode() const;
+
+    int send(const char* data, size_t length, const struct sockaddr_in& dest);
+    int receive(char* buffer, size_t length, struct sockaddr_in* from, RecvStamp& stamp);
+    int wait(double waitMs);
+
+    void printSummary() const;
+
+    unsigned long long getRequests() const;
+    unsigned long long getDropped() const;
+    unsigned long long getErrors() const;
+    unsigned long long getDuplicated() const;
+    unsigned long long getReordered() const;
+    unsigned long long getDelivered() const;
+};
+
+#endif
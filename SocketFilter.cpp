@@ -0,0 +1,49 @@
+#include "SocketFilter.hpp"
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/ip_icmp.h>
+#include <linux/filter.h>
+
+bool attachReplyFilter(int sockfd, unsigned short icmpId) {
+    // A raw IPv4 socket hands the filter the packet from the IP header on.
+    // BPF_H loads are big-endian; the id goes out in host order, so compare
+    // against htons(id) to match the bytes actually on the wire. ICMP errors
+    // (unreachable, time exceeded, parameter problem) pass only when the
+    // packet they quote, found past both IP headers, is one of our probes.
+    struct sock_filter code[] = {
+        BPF_STMT(BPF_LDX | BPF_B | BPF_MSH, 0),                       // X = IP header length
+        BPF_STMT(BPF_LD | BPF_B | BPF_IND, 0),                        // A = ICMP type
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, ICMP_ECHOREPLY, 0, 2),
+        BPF_STMT(BPF_LD | BPF_H | BPF_IND, 4),                        // A = ICMP id
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, htons(icmpId), 12, 13),
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, ICMP_DEST_UNREACH, 2, 0),
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, ICMP_TIME_EXCEEDED, 1, 0),
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, ICMP_PARAMETERPROB, 0, 10),
+        BPF_STMT(BPF_LD | BPF_B | BPF_IND, 8),                        // A = quoted version/IHL
+        BPF_STMT(BPF_ALU | BPF_AND | BPF_K, 0x0F),
+        BPF_STMT(BPF_ALU | BPF_LSH | BPF_K, 2),
+        BPF_STMT(BPF_ALU | BPF_ADD | BPF_X, 0),
+        BPF_STMT(BPF_MISC | BPF_TAX, 0),                              // X = both IP headers
+        BPF_STMT(BPF_LD | BPF_B | BPF_IND, 8),                        // A = quoted ICMP type
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, ICMP_ECHO, 0, 3),
+        BPF_STMT(BPF_LD | BPF_H | BPF_IND, 12),                       // A = quoted ICMP id
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, htons(icmpId), 0, 1),
+        BPF_STMT(BPF_RET | BPF_K, 0xFFFF),                            // Accept whole packet
+        BPF_STMT(BPF_RET | BPF_K, 0),                                 // Drop
+    };
+
+    struct sock_fprog program;
+    program.len = sizeof(code) / sizeof(code[0]);
+    program.filter = code;
+
+    return setsockopt(sockfd, SOL_SOCKET, SO_ATTACH_FILTER, &program, sizeof(program)) == 0;
+}
+
+int flushSocket(int sockfd) {
+    char buffer[128];
+    int flushed = 0;
+    while (recv(sockfd, buffer, sizeof(buffer), MSG_DONTWAIT) >= 0) {
+        flushed++;
+    }
+    return flushed;
+}
@@ -0,0 +1,13 @@
+#ifndef SOCKET_FILTER_HPP
+#define SOCKET_FILTER_HPP
+
+// Classic BPF program for raw ICMP sockets: the kernel drops everything
+// except Echo Replies carrying our ICMP identifier and ICMP errors quoting
+// one of our Echo Requests, so a process is only woken for its own traffic
+// even when many pingers share the host.
+bool attachReplyFilter(int sockfd, unsigned short icmpId);
+
+// Discards packets queued before the filter was attached
+int flushSocket(int sockfd);
+
+#endif
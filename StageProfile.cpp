@@ -0,0 +1,94 @@
+#include "StageProfile.hpp"
+#include "PingStatistics.hpp"
+#include "Output.hpp"
+#include "utils.hpp"
+#include <cstdio>
+#include <iostream>
+
+const char* getStageName(ProbeStage stage) {
+    switch (stage) {
+        case STAGE_BUILD: return "build";
+        case STAGE_PRE_SEND: return "pre-send output";
+        case STAGE_SEND: return "send call";
+        case STAGE_WAKEUP: return "arrival to wakeup";
+        case STAGE_RECEIVE: return "receive call";
+        case STAGE_PARSE: return "parse and match";
+        case STAGE_REPORT: return "report";
+        default: return "unknown";
+    }
+}
+
+StageProfile::StageProfile() : enabled(false) {
+    for (int i = 0; i < STAGE_COUNT; i++) {
+        maxNs[i] = 0;
+    }
+}
+
+void StageProfile::enable() {
+    enabled = true;
+}
+
+unsigned long long StageProfile::getCount(ProbeStage stage) const {
+    return histograms[stage].getCount();
+}
+
+double StageProfile::getPercentileUs(ProbeStage stage, double p) const {
+    if (histograms[stage].getCount() == 0) {
+        return 0.0;
+    }
+    // Bucket midpoints can overshoot the largest sample
+    double us = histograms[stage].percentile(p) * 1000.0;
+    return us < getMaxUs(stage) ? us : getMaxUs(stage);
+}
+
+double StageProfile::getMaxUs(ProbeStage stage) const {
+    return maxNs[stage] / 1000.0;
+}
+
+static void printRow(const char* name, bool inRtt, unsigned long long samples,
+                     const double values[5]) {
+    char line[160];
+    char label[32];
+    snprintf(label, sizeof(label), "%s%s", name, inRtt ? " *" : "");
+    if (samples == 0) {
+        snprintf(line, sizeof(line), "%-22s %10d %10s %10s %10s %10s %10s\n", label, 0,
+                 "-", "-", "-", "-", "-");
+    } else {
+        snprintf(line, sizeof(line), "%-22s %10llu %10.3f %10.3f %10.3f %10.3f %10.3f\n", label,
+                 samples, values[0], values[1], values[2], values[3], values[4]);
+    }
+    std::cout << line;
+}
+
+void StageProfile::printReport(const PingStatistics& rtt, const bool inRtt[STAGE_COUNT]) const {
+    if (traceEnabled()) {
+        std::cout << std::endl;
+        printSection("TOOL OVERHEAD");
+    } else {
+        std::cout << std::endl << "--- tool overhead per probe (us) ---" << std::endl;
+    }
+
+    char header[160];
+    snprintf(header, sizeof(header), "%-22s %10s %10s %10s %10s %10s %10s\n", "stage", "samples",
+             "p50", "p90", "p99", "p99.9", "max");
+    std::cout << header;
+
+    const double points[4] = {50.0, 90.0, 99.0, 99.9};
+    for (int i = 0; i < STAGE_COUNT; i++) {
+        ProbeStage stage = (ProbeStage)i;
+        double values[5];
+        for (int p = 0; p < 4; p++) {
+            values[p] = getPercentileUs(stage, points[p]);
+        }
+        values[4] = getMaxUs(stage);
+        printRow(getStageName(stage), inRtt[i], getCount(stage), values);
+    }
+
+    double values[5];
+    for (int p = 0; p < 4; p++) {
+        values[p] = rtt.getPercentile(points[p]) * 1000.0;
+    }
+    values[4] = rtt.getReceived() > 0 ? rtt.getMaxTime() * 1000.0 : 0.0;
+    printRow("network rtt", false, (unsigned long long)rtt.getReceived(), values);
+    std::cout << "* runs between the send and receive stamps, so it can inflate the RTT" << std::endl;
+}
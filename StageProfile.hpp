@@ -0,0 +1,84 @@
+#ifndef STAGE_PROFILE_HPP
+#define STAGE_PROFILE_HPP
+
+#include "RttHistogram.hpp"
+#include <time.h>
+
+class PingStatistics;
+
+// Where a probe spends its time inside the tool rather than on the network
+enum ProbeStage {
+    STAGE_BUILD,        // Sequence patch and checksum (prepare() and its trace when verbose);
+                        // flood and io_uring record the per-packet average of each batch
+    STAGE_PRE_SEND,     // Output between the finished packet and the send stamp
+    STAGE_SEND,         // The send call; flood times one sendmmsg() per batch, io_uring
+                        // submits inside its wait and is not timed
+    STAGE_WAKEUP,       // Arrival (kernel receive stamp) until the receive call returned
+    STAGE_RECEIVE,      // The receive call; flood mode times one recvmmsg() per batch
+    STAGE_PARSE,        // Header parsing and matching the reply to its probe
+    STAGE_REPORT,       // Statistics, reply line, record and log entry
+    STAGE_COUNT
+};
+
+const char* getStageName(ProbeStage stage);
+
+// Per-stage latency histograms for the client's own work on each probe.
+// A stage costs two CLOCK_MONOTONIC reads (vDSO, no system call), and
+// adjacent stages share their boundary reading; each sample goes into a
+// fixed-memory RttHistogram. Disabled, every probe point is a single
+// predictable branch, so the instrumentation stays compiled in.
+class StageProfile {
+private:
+    bool enabled;
+    RttHistogram histograms[STAGE_COUNT];
+    unsigned long long maxNs[STAGE_COUNT];
+
+public:
+    StageProfile();
+
+    void enable();
+    bool isEnabled() const { return enabled; }
+
+    // Monotonic nanoseconds, the unit every probe point works in
+    static long long now() {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+    }
+
+    // CLOCK_REALTIME nanoseconds, the domain of kernel receive stamps
+    static long long wallNow() {
+        struct timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+    }
+
+    // A stage boundary: now() when profiling, 0 (no clock read) otherwise
+    long long mark() const {
+        return enabled ? now() : 0;
+    }
+
+    static long long toNs(const struct timespec& ts) {
+        return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+    }
+
+    // No-op unless enabled, so probe points need no guard of their own
+    void record(ProbeStage stage, long long ns) {
+        if (!enabled) return;
+        if (ns < 0) ns = 0;
+        histograms[stage].record(ns / 1000000.0);
+        if ((unsigned long long)ns > maxNs[stage]) maxNs[stage] = (unsigned long long)ns;
+    }
+
+    unsigned long long getCount(ProbeStage stage) const;
+    // Percentile of a stage in microseconds, 0 without samples
+    double getPercentileUs(ProbeStage stage, double p) const;
+    double getMaxUs(ProbeStage stage) const;
+
+    // Stage percentiles next to the network RTT; inRtt marks the stages
+    // that run between the send stamp and the receive stamp, so the
+    // measured RTT can contain part or all of them
+    void printReport(const PingStatistics& rtt, const bool inRtt[STAGE_COUNT]) const;
+};
+
+#endif
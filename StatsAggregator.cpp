@@ -0,0 +1,102 @@
+#include "StatsAggregator.hpp"
+#include <new>
+#include <stdlib.h>
+
+void ShardTotals::addReceived(double rtt) {
+    if (received == 0 || rtt < minMs) minMs = rtt;
+    if (received == 0 || rtt > maxMs) maxMs = rtt;
+    received++;
+    rttSumMs += rtt;
+}
+
+void ShardTotals::merge(const ShardTotals& other) {
+    if (other.received > 0) {
+        if (received == 0 || other.minMs < minMs) minMs = other.minMs;
+        if (received == 0 || other.maxMs > maxMs) maxMs = other.maxMs;
+    }
+    transmitted += other.transmitted;
+    received += other.received;
+    errors += other.errors;
+    rttSumMs += other.rttSumMs;
+}
+
+StatsAggregator::StatsAggregator(int shardCount)
+    : slots(nullptr), slotCount(shardCount > 0 ? shardCount : 1) {
+    void* memory = nullptr;
+    if (posix_memalign(&memory, alignof(Slot), slotCount * sizeof(Slot)) != 0) {
+        throw std::bad_alloc();
+    }
+    slots = (Slot*)memory;
+    for (int i = 0; i < slotCount; i++) {
+        Slot& slot = *new (&slots[i]) Slot;
+        slot.sequence.store(0, std::memory_order_relaxed);
+        slot.transmitted.store(0, std::memory_order_relaxed);
+        slot.received.store(0, std::memory_order_relaxed);
+        slot.errors.store(0, std::memory_order_relaxed);
+        slot.rttSumMs.store(0.0, std::memory_order_relaxed);
+        slot.minMs.store(0.0, std::memory_order_relaxed);
+        slot.maxMs.store(0.0, std::memory_order_relaxed);
+    }
+    std::atomic_thread_fence(std::memory_order_release);
+}
+
+StatsAggregator::~StatsAggregator() {
+    for (int i = 0; i < slotCount; i++) {
+        slots[i].~Slot();
+    }
+    free(slots);
+}
+
+int StatsAggregator::getShardCount() const {
+    return slotCount;
+}
+
+void StatsAggregator::publish(int shard, const ShardTotals& totals) {
+    Slot& slot = slots[shard];
+    unsigned sequence = slot.sequence.load(std::memory_order_relaxed);
+
+    // Odd while the fields are being rewritten
+    slot.sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    slot.transmitted.store(totals.transmitted, std::memory_order_relaxed);
+    slot.received.store(totals.received, std::memory_order_relaxed);
+    slot.errors.store(totals.errors, std::memory_order_relaxed);
+    slot.rttSumMs.store(totals.rttSumMs, std::memory_order_relaxed);
+    slot.minMs.store(totals.minMs, std::memory_order_relaxed);
+    slot.maxMs.store(totals.maxMs, std::memory_order_relaxed);
+
+    slot.sequence.store(sequence + 2, std::memory_order_release);
+}
+
+ShardTotals StatsAggregator::snapshot(int shard) const {
+    const Slot& slot = slots[shard];
+    ShardTotals totals;
+
+    for (;;) {
+        unsigned before = slot.sequence.load(std::memory_order_acquire);
+        if (before & 1) {
+            continue; // Writer mid-update; it finishes in a few stores
+        }
+
+        totals.transmitted = slot.transmitted.load(std::memory_order_relaxed);
+        totals.received = slot.received.load(std::memory_order_relaxed);
+        totals.errors = slot.errors.load(std::memory_order_relaxed);
+        totals.rttSumMs = slot.rttSumMs.load(std::memory_order_relaxed);
+        totals.minMs = slot.minMs.load(std::memory_order_relaxed);
+        totals.maxMs = slot.maxMs.load(std::memory_order_relaxed);
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.sequence.load(std::memory_order_relaxed) == before) {
+            return totals;
+        }
+    }
+}
+
+ShardTotals StatsAggregator::collect() const {
+    ShardTotals total;
+    for (int i = 0; i < slotCount; i++) {
+        total.merge(snapshot(i));
+    }
+    return total;
+}
@@ -0,0 +1,57 @@
+#ifndef STATS_AGGREGATOR_HPP
+#define STATS_AGGREGATOR_HPP
+
+#include <atomic>
+#include <cstddef>
+
+// Running totals of one shard; plain fields, owned by its worker thread
+struct ShardTotals {
+    unsigned long transmitted;
+    unsigned long received;
+    unsigned long errors;
+    double rttSumMs;
+    double minMs;
+    double maxMs;
+
+    ShardTotals() : transmitted(0), received(0), errors(0), rttSumMs(0.0), minMs(0.0), maxMs(0.0) {}
+
+    void addReceived(double rtt);
+    void merge(const ShardTotals& other);
+};
+
+// Lock-free merge point for sharded workers. Each shard publishes into its
+// own cache-line sized slot under a seqlock (single writer, no RMW on the
+// data), and readers retry until they copy a consistent snapshot, so a
+// reporter can sum every shard without ever blocking a worker.
+class StatsAggregator {
+private:
+    struct alignas(64) Slot {
+        std::atomic<unsigned> sequence;
+        std::atomic<unsigned long> transmitted;
+        std::atomic<unsigned long> received;
+        std::atomic<unsigned long> errors;
+        std::atomic<double> rttSumMs;
+        std::atomic<double> minMs;
+        std::atomic<double> maxMs;
+    };
+
+    // std::allocator ignores over-alignment before C++17, so the slots
+    // live in a posix_memalign() block rather than a std::vector
+    Slot* slots;
+    int slotCount;
+
+public:
+    explicit StatsAggregator(int shardCount);
+    ~StatsAggregator();
+    StatsAggregator(const StatsAggregator&) = delete;
+    StatsAggregator& operator=(const StatsAggregator&) = delete;
+
+    int getShardCount() const;
+
+    // Worker side: only the shard's own thread may publish to it
+    void publish(int shard, const ShardTotals& totals);
+    ShardTotals snapshot(int shard) const;
+    ShardTotals collect() const;
+};
+
+#endif
@@ -0,0 +1,289 @@
+#include "StatsSegment.hpp"
+#include <fcntl.h>
+#include <sched.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+static const char SEGMENT_MAGIC[8] = {'P', 'I', 'N', 'G', 'S', 'T', 'A', 'T'};
+
+// A reader gives up on a slot that stays mid-update this many times
+static const int MAX_SNAPSHOT_ATTEMPTS = 100000;
+
+static bool processAlive(int64_t pid) {
+    return pid > 0 && (kill((pid_t)pid, 0) == 0 || errno == EPERM);
+}
+
+// An existing segment may be replaced only when its writer is gone
+static bool segmentStale(const std::string& name) {
+    int fd = shm_open(name.c_str(), O_RDONLY | O_CLOEXEC, 0);
+    if (fd < 0) {
+        return errno == ENOENT;
+    }
+
+    bool stale = true;
+    struct stat info;
+    if (fstat(fd, &info) == 0 && (size_t)info.st_size >= sizeof(StatsSegmentHeader)) {
+        void* mapped = mmap(nullptr, sizeof(StatsSegmentHeader), PROT_READ, MAP_SHARED, fd, 0);
+        if (mapped != MAP_FAILED) {
+            stale = !processAlive(((const StatsSegmentHeader*)mapped)->pid);
+            munmap(mapped, sizeof(StatsSegmentHeader));
+        }
+    }
+    ::close(fd);
+    return stale;
+}
+
+StatsSegment::StatsSegment() : fd(-1), header(nullptr), slots(nullptr), size(0) {}
+
+StatsSegment::~StatsSegment() {
+    close();
+}
+
+std::string StatsSegment::normalizeName(const std::string& segmentName) {
+    return (!segmentName.empty() && segmentName[0] == '/') ? segmentName : "/" + segmentName;
+}
+
+bool StatsSegment::open(const std::string& segmentName, const std::vector<std::string>& targets) {
+    close();
+    name = normalizeName(segmentName);
+    size = sizeof(StatsSegmentHeader) + targets.size() * sizeof(StatsSlot);
+
+    fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+    if (fd < 0 && errno == EEXIST) {
+        if (!segmentStale(name)) {
+            std::cout << "  [FAILED] Statistics segment " << name
+                      << " belongs to a running process" << std::endl;
+            name.clear();
+            return false;
+        }
+        shm_unlink(name.c_str());
+        fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+    }
+    if (fd < 0) {
+        std::cout << "  [FAILED] Cannot create statistics segment " << name << ": "
+                  << strerror(errno) << std::endl;
+        name.clear();
+        return false;
+    }
+
+    // ftruncate() zero-fills, which is every counter's and sequence's starting value
+    if (ftruncate(fd, (off_t)size) < 0) {
+        std::cout << "  [FAILED] Cannot size statistics segment " << name << ": "
+                  << strerror(errno) << std::endl;
+        close();
+        return false;
+    }
+    void* mapped = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, 0);
+    if (mapped == MAP_FAILED) {
+        std::cout << "  [FAILED] Cannot map statistics segment " << name << ": "
+                  << strerror(errno) << std::endl;
+        close();
+        return false;
+    }
+    header = (StatsSegmentHeader*)mapped;
+    slots = (StatsSlot*)((char*)mapped + sizeof(StatsSegmentHeader));
+
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    memcpy(header->magic, SEGMENT_MAGIC, sizeof(SEGMENT_MAGIC));
+    header->headerBytes = (uint32_t)sizeof(StatsSegmentHeader);
+    header->slotBytes = (uint32_t)sizeof(StatsSlot);
+    header->slotCount = (uint32_t)targets.size();
+    header->nameBytes = (uint32_t)StatsSlot::NAME_BYTES;
+    header->failureKinds = (uint32_t)FAILURE_KIND_COUNT;
+    header->bucketCount = (uint32_t)RttHistogram::BUCKET_COUNT;
+    header->subBucketBits = (uint32_t)RttHistogram::SUB_BUCKET_BITS;
+    header->maxExponent = (uint32_t)RttHistogram::MAX_EXPONENT;
+    header->pid = (int64_t)getpid();
+    header->startNs = (int64_t)now.tv_sec * 1000000000LL + now.tv_nsec;
+
+    for (size_t i = 0; i < targets.size(); i++) {
+        // Longer names are cut; the slot order still identifies the target
+        strncpy(slots[i].name, targets[i].c_str(), StatsSlot::NAME_BYTES - 1);
+    }
+
+    header->version.store(VERSION, std::memory_order_release);
+    return true;
+}
+
+bool StatsSegment::isOpen() const {
+    return header != nullptr;
+}
+
+void StatsSegment::close() {
+    if (header != nullptr) {
+        munmap(header, size);
+        header = nullptr;
+        slots = nullptr;
+    }
+    if (fd >= 0) {
+        ::close(fd);
+        fd = -1;
+        shm_unlink(name.c_str());
+    }
+    size = 0;
+}
+
+const std::string& StatsSegment::getName() const {
+    return name;
+}
+
+size_t StatsSegment::getSlotCount() const {
+    return header != nullptr ? header->slotCount : 0;
+}
+
+void StatsSegment::publish(size_t index, const PingStatistics& stats, uint32_t address) {
+    if (header == nullptr || index >= header->slotCount) {
+        return;
+    }
+    StatsSlot& slot = slots[index];
+    uint32_t sequence = slot.sequence.load(std::memory_order_relaxed);
+
+    // Odd while the fields are being rewritten
+    slot.sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    slot.address.store(address, std::memory_order_relaxed);
+    slot.updatedNs.store((uint64_t)now.tv_sec * 1000000000ULL + now.tv_nsec, std::memory_order_relaxed);
+    slot.transmitted.store((uint64_t)stats.getTransmitted(), std::memory_order_relaxed);
+    slot.received.store((uint64_t)stats.getReceived(), std::memory_order_relaxed);
+    slot.errors.store((uint64_t)stats.getErrors(), std::memory_order_relaxed);
+    for (int k = 0; k < FAILURE_KIND_COUNT; k++) {
+        slot.failures[k].store((uint64_t)stats.getFailures((FailureKind)k), std::memory_order_relaxed);
+    }
+
+    if (stats.getReceived() > 0) {
+        slot.minMs.store(stats.getMinTime(), std::memory_order_relaxed);
+        slot.maxMs.store(stats.getMaxTime(), std::memory_order_relaxed);
+        slot.meanMs.store(stats.getAverageTime(), std::memory_order_relaxed);
+        slot.stddevMs.store(stats.calculateStdDev(), std::memory_order_relaxed);
+
+        // Counts only grow, and nothing lies outside [min, max]
+        const RttHistogram& histogram = stats.getHistogram();
+        int last = RttHistogram::indexOf(stats.getMaxTime());
+        for (int i = RttHistogram::indexOf(stats.getMinTime()); i <= last; i++) {
+            slot.buckets[i].store(histogram.getBucket(i), std::memory_order_relaxed);
+        }
+    }
+
+    slot.sequence.store(sequence + 2, std::memory_order_release);
+}
+
+StatsSegmentReader::StatsSegmentReader()
+    : fd(-1), header(nullptr), slots(nullptr), size(0), buckets(RttHistogram::BUCKET_COUNT) {}
+
+StatsSegmentReader::~StatsSegmentReader() {
+    if (header != nullptr) {
+        munmap((void*)header, size);
+    }
+    if (fd >= 0) {
+        close(fd);
+    }
+}
+
+bool StatsSegmentReader::open(const std::string& segmentName) {
+    std::string name = StatsSegment::normalizeName(segmentName);
+    fd = shm_open(name.c_str(), O_RDONLY | O_CLOEXEC, 0);
+    if (fd < 0) {
+        std::cerr << "ERROR: Cannot open statistics segment " << name << ": " << strerror(errno)
+                  << std::endl;
+        return false;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) < 0 || (size_t)info.st_size < sizeof(StatsSegmentHeader)) {
+        std::cerr << "ERROR: " << name << " is too short to be a statistics segment" << std::endl;
+        return false;
+    }
+    size = (size_t)info.st_size;
+
+    void* mapped = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    if (mapped == MAP_FAILED) {
+        std::cerr << "ERROR: Cannot map " << name << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+    header = (const StatsSegmentHeader*)mapped;
+
+    uint32_t version = header->version.load(std::memory_order_acquire);
+    if (version == 0) {
+        std::cerr << "ERROR: " << name << " is still being created" << std::endl;
+        return false;
+    }
+    if (memcmp(header->magic, SEGMENT_MAGIC, sizeof(SEGMENT_MAGIC)) != 0 ||
+        version != StatsSegment::VERSION || header->headerBytes != sizeof(StatsSegmentHeader) ||
+        header->slotBytes != sizeof(StatsSlot) || header->nameBytes != StatsSlot::NAME_BYTES ||
+        header->failureKinds != FAILURE_KIND_COUNT ||
+        header->bucketCount != RttHistogram::BUCKET_COUNT ||
+        header->subBucketBits != RttHistogram::SUB_BUCKET_BITS ||
+        header->maxExponent != RttHistogram::MAX_EXPONENT ||
+        header->headerBytes + (size_t)header->slotCount * header->slotBytes > size) {
+        std::cerr << "ERROR: " << name << " is not a version " << StatsSegment::VERSION
+                  << " statistics segment" << std::endl;
+        return false;
+    }
+    slots = (const StatsSlot*)((const char*)mapped + header->headerBytes);
+    return true;
+}
+
+size_t StatsSegmentReader::getSlotCount() const {
+    return header->slotCount;
+}
+
+int64_t StatsSegmentReader::getWriterPid() const {
+    return header->pid;
+}
+
+int64_t StatsSegmentReader::getStartNs() const {
+    return header->startNs;
+}
+
+bool StatsSegmentReader::isWriterAlive() const {
+    return processAlive(header->pid);
+}
+
+bool StatsSegmentReader::snapshot(size_t index, StatsSnapshot& out) const {
+    const StatsSlot& slot = slots[index];
+    out.name.assign(slot.name, strnlen(slot.name, StatsSlot::NAME_BYTES));
+
+    for (int attempt = 0; attempt < MAX_SNAPSHOT_ATTEMPTS; attempt++) {
+        uint32_t before = slot.sequence.load(std::memory_order_acquire);
+        if (before & 1) {
+            sched_yield(); // Let a preempted writer finish its stores
+            continue;
+        }
+
+        out.address = slot.address.load(std::memory_order_relaxed);
+        out.updatedNs = slot.updatedNs.load(std::memory_order_relaxed);
+        out.transmitted = slot.transmitted.load(std::memory_order_relaxed);
+        out.received = slot.received.load(std::memory_order_relaxed);
+        out.errors = slot.errors.load(std::memory_order_relaxed);
+        for (int k = 0; k < FAILURE_KIND_COUNT; k++) {
+            out.failures[k] = slot.failures[k].load(std::memory_order_relaxed);
+        }
+        out.minMs = slot.minMs.load(std::memory_order_relaxed);
+        out.maxMs = slot.maxMs.load(std::memory_order_relaxed);
+        out.meanMs = slot.meanMs.load(std::memory_order_relaxed);
+        out.stddevMs = slot.stddevMs.load(std::memory_order_relaxed);
+        for (int i = 0; i < RttHistogram::BUCKET_COUNT; i++) {
+            buckets[i] = slot.buckets[i].load(std::memory_order_relaxed);
+        }
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.sequence.load(std::memory_order_relaxed) == before) {
+            out.histogram.clear();
+            for (int i = 0; i < RttHistogram::BUCKET_COUNT; i++) {
+                out.histogram.addToBucket(i, buckets[i]);
+            }
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,137 @@
+#ifndef STATS_SEGMENT_HPP
+#define STATS_SEGMENT_HPP
+
+#include "PingStatistics.hpp"
+#include <atomic>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// Layout of a live statistics segment (POSIX shared memory, host byte
+// order): one StatsSegmentHeader, then slotCount StatsSlots, one per
+// target in command-line order. Every field a reader may see change is a
+// lock-free std::atomic, so the layout is the same in both processes.
+//
+// version is stored last, once the geometry and every target name are in
+// place; a reader that finds 0 is looking at a segment still being laid
+// out. Any change to the layout bumps VERSION.
+struct alignas(64) StatsSegmentHeader {
+    char magic[8];
+    std::atomic<uint32_t> version;
+    uint32_t headerBytes;               // Offset of slot 0
+    uint32_t slotBytes;
+    uint32_t slotCount;
+    uint32_t nameBytes;
+    uint32_t failureKinds;              // FAILURE_KIND_COUNT
+    uint32_t bucketCount;               // RttHistogram geometry of the buckets
+    uint32_t subBucketBits;
+    uint32_t maxExponent;
+    int64_t pid;                        // Writer process
+    int64_t startNs;                    // CLOCK_REALTIME when the segment was created
+};
+
+// One target's PingStatistics under a seqlock: the writer makes sequence
+// odd, rewrites the fields with relaxed stores and makes it even again;
+// a reader copies the fields and keeps the copy only if sequence was even
+// and unchanged across it. Slots are cache-line aligned, so workers that
+// publish neighbouring targets never share a line.
+struct alignas(64) StatsSlot {
+    static const int NAME_BYTES = 64;
+
+    std::atomic<uint32_t> sequence;
+    std::atomic<uint32_t> address;      // IPv4, network order, 0 until resolved
+    char name[NAME_BYTES];              // Written before version, never changed
+    std::atomic<uint64_t> updatedNs;    // CLOCK_REALTIME of the last publish, 0 before it
+    std::atomic<uint64_t> transmitted;
+    std::atomic<uint64_t> received;
+    std::atomic<uint64_t> errors;       // Timeouts and ICMP errors
+    std::atomic<uint64_t> failures[FAILURE_KIND_COUNT];
+    std::atomic<double> minMs;
+    std::atomic<double> maxMs;
+    std::atomic<double> meanMs;
+    std::atomic<double> stddevMs;
+    std::atomic<uint32_t> buckets[RttHistogram::BUCKET_COUNT];
+};
+
+// Publishes per-target statistics for scrapers in other processes
+// (pingstat, exporters, dashboards). Readers map the segment and copy a
+// slot themselves, so they never make a system call into the pinger nor
+// block it. The pinger publishes from its own loop on a fixed period
+// rather than per probe: a publish is a few dozen stores plus the
+// histogram buckets between the smallest and largest RTT, which are the
+// only ones a growing histogram can have touched.
+class StatsSegment {
+public:
+    static const uint32_t VERSION = 1;
+    static const int PUBLISH_INTERVAL_MS = 100;
+
+private:
+    int fd;
+    StatsSegmentHeader* header;
+    StatsSlot* slots;
+    size_t size;
+    std::string name;
+
+public:
+    StatsSegment();
+    ~StatsSegment();
+
+    // "name" and "/name" are the same segment
+    static std::string normalizeName(const std::string& segmentName);
+
+    // Creates the segment with one slot per target. A segment left behind
+    // by a process that no longer runs is replaced; a live one is not.
+    bool open(const std::string& segmentName, const std::vector<std::string>& targets);
+    bool isOpen() const;
+    // Unmaps and unlinks the segment; readers keep their mapping
+    void close();
+    const std::string& getName() const;
+    size_t getSlotCount() const;
+
+    // Only one thread may publish to a given slot
+    void publish(size_t slot, const PingStatistics& stats, uint32_t address);
+};
+
+// A consistent copy of one slot
+struct StatsSnapshot {
+    std::string name;
+    uint32_t address;
+    uint64_t updatedNs;
+    uint64_t transmitted;
+    uint64_t received;
+    uint64_t errors;
+    uint64_t failures[FAILURE_KIND_COUNT];
+    double minMs;
+    double maxMs;
+    double meanMs;
+    double stddevMs;
+    RttHistogram histogram;
+};
+
+// Read-only mapping of a live segment
+class StatsSegmentReader {
+private:
+    int fd;
+    const StatsSegmentHeader* header;
+    const StatsSlot* slots;
+    size_t size;
+    mutable std::vector<uint32_t> buckets;
+
+public:
+    StatsSegmentReader();
+    ~StatsSegmentReader();
+
+    // Prints the reason and returns false if name is not a usable segment
+    bool open(const std::string& segmentName);
+
+    size_t getSlotCount() const;
+    int64_t getWriterPid() const;
+    int64_t getStartNs() const;
+    // False once the pinger has exited; the last published values remain
+    bool isWriterAlive() const;
+    // Retries while the writer is mid-update; false if it never settles
+    // (a writer killed inside a publish)
+    bool snapshot(size_t slot, StatsSnapshot& out) const;
+};
+
+#endif
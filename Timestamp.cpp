@@ -0,0 +1,132 @@
+#include "Timestamp.hpp"
+#include <sys/socket.h>
+#include <linux/net_tstamp.h>
+#include <linux/errqueue.h>
+#include <cstring>
+
+TimestampMode enableKernelTimestamps(int sockfd) {
+    int flags = SOF_TIMESTAMPING_RX_SOFTWARE | SOF_TIMESTAMPING_SOFTWARE |
+                SOF_TIMESTAMPING_RX_HARDWARE | SOF_TIMESTAMPING_RAW_HARDWARE;
+    if (setsockopt(sockfd, SOL_SOCKET, SO_TIMESTAMPING, &flags, sizeof(flags)) == 0) {
+        return TIMESTAMP_TIMESTAMPING;
+    }
+
+    int enable = 1;
+    if (setsockopt(sockfd, SOL_SOCKET, SO_TIMESTAMPNS, &enable, sizeof(enable)) == 0) {
+        return TIMESTAMP_NS;
+    }
+
+    return TIMESTAMP_NONE;
+}
+
+const char* getTimestampModeName(TimestampMode mode) {
+    switch (mode) {
+        case TIMESTAMP_TIMESTAMPING: return "SO_TIMESTAMPING (kernel)";
+        case TIMESTAMP_NS: return "SO_TIMESTAMPNS (kernel)";
+        default: return "CLOCK_MONOTONIC (userspace)";
+    }
+}
+
+void stampSend(SendStamp& stamp) {
+    clock_gettime(CLOCK_MONOTONIC, &stamp.mono);
+    clock_gettime(CLOCK_REALTIME, &stamp.wall);
+}
+
+struct timespec monotonicNow() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now;
+}
+
+double elapsedMs(const struct timespec& start, const struct timespec& end) {
+    return (end.tv_sec - start.tv_sec) * 1000.0 +
+           (end.tv_nsec - start.tv_nsec) / 1000000.0;
+}
+
+struct timespec addMs(const struct timespec& start, double ms) {
+    long long ns = (long long)(ms * 1000000.0);
+    struct timespec result;
+    result.tv_sec = start.tv_sec + (time_t)(ns / 1000000000LL);
+    result.tv_nsec = start.tv_nsec + (long)(ns % 1000000000LL);
+    if (result.tv_nsec >= 1000000000L) {
+        result.tv_sec++;
+        result.tv_nsec -= 1000000000L;
+    } else if (result.tv_nsec < 0) {
+        result.tv_sec--;
+        result.tv_nsec += 1000000000L;
+    }
+    return result;
+}
+
+void readTimestampControl(struct msghdr* msg, RecvStamp& stamp) {
+    stamp.hasKernel = false;
+    stamp.hasHardware = false;
+
+    for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(msg); cmsg != nullptr; cmsg = CMSG_NXTHDR(msg, cmsg)) {
+        if (cmsg->cmsg_level != SOL_SOCKET) {
+            continue;
+        }
+
+        if (cmsg->cmsg_type == SCM_TIMESTAMPING) {
+            struct scm_timestamping ts;
+            memcpy(&ts, CMSG_DATA(cmsg), sizeof(ts));
+            if (ts.ts[0].tv_sec != 0 || ts.ts[0].tv_nsec != 0) {
+                stamp.kernel = ts.ts[0];
+                stamp.hasKernel = true;
+            }
+            if (ts.ts[2].tv_sec != 0 || ts.ts[2].tv_nsec != 0) {
+                stamp.hardware = ts.ts[2];
+                stamp.hasHardware = true;
+            }
+        } else if (cmsg->cmsg_type == SCM_TIMESTAMPNS) {
+            memcpy(&stamp.kernel, CMSG_DATA(cmsg), sizeof(stamp.kernel));
+            stamp.hasKernel = true;
+        }
+    }
+}
+
+ssize_t recvWithTimestamp(int sockfd, void* buffer, size_t length, int flags,
+                          struct sockaddr_in* fromAddr, RecvStamp& stamp) {
+    char control[TIMESTAMP_CONTROL_SIZE];
+    struct iovec iov;
+    iov.iov_base = buffer;
+    iov.iov_len = length;
+
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_name = fromAddr;
+    msg.msg_namelen = fromAddr ? sizeof(*fromAddr) : 0;
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+
+    ssize_t received = recvmsg(sockfd, &msg, flags);
+    clock_gettime(CLOCK_MONOTONIC, &stamp.mono);
+
+    if (received < 0) {
+        stamp.hasKernel = false;
+        stamp.hasHardware = false;
+        return received;
+    }
+
+    readTimestampControl(&msg, stamp);
+    return received;
+}
+
+double stampRttMs(const SendStamp& sent, const RecvStamp& received, bool* fromKernel) {
+    double monoRtt = elapsedMs(sent.mono, received.mono);
+
+    if (received.hasKernel) {
+        double kernelRtt = elapsedMs(sent.wall, received.kernel);
+        // The kernel stamp always precedes our monotonic read, so anything outside
+        // [0, monoRtt] means the wall clock was stepped while the probe was out
+        if (kernelRtt >= 0.0 && kernelRtt <= monoRtt) {
+            if (fromKernel) *fromKernel = true;
+            return kernelRtt;
+        }
+    }
+
+    if (fromKernel) *fromKernel = false;
+    return monoRtt;
+}
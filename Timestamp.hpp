@@ -0,0 +1,53 @@
+#ifndef TIMESTAMP_HPP
+#define TIMESTAMP_HPP
+
+#include <time.h>
+#include <cstddef>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+
+enum TimestampMode {
+    TIMESTAMP_NONE,          // Userspace monotonic clock only
+    TIMESTAMP_NS,            // SO_TIMESTAMPNS software receive stamps
+    TIMESTAMP_TIMESTAMPING   // SO_TIMESTAMPING (software, plus hardware where the NIC supports it)
+};
+
+// Taken immediately before sendto(), after all packet building and printing
+struct SendStamp {
+    struct timespec mono;
+    struct timespec wall;
+};
+
+// Filled by recvWithTimestamp(); the kernel stamp is in the CLOCK_REALTIME
+// domain, the monotonic reading is the userspace fallback
+struct RecvStamp {
+    struct timespec mono;
+    struct timespec kernel;
+    struct timespec hardware;
+    bool hasKernel;
+    bool hasHardware;
+};
+
+// Room for an SCM_TIMESTAMPING or SCM_TIMESTAMPNS control message
+const size_t TIMESTAMP_CONTROL_SIZE = 128;
+
+TimestampMode enableKernelTimestamps(int sockfd);
+const char* getTimestampModeName(TimestampMode mode);
+
+void stampSend(SendStamp& stamp);
+struct timespec monotonicNow();
+double elapsedMs(const struct timespec& start, const struct timespec& end);
+// Absolute deadline ms after start (fractions kept to the nanosecond)
+struct timespec addMs(const struct timespec& start, double ms);
+
+// Extracts kernel/hardware stamps from a received message; leaves stamp.mono alone
+void readTimestampControl(struct msghdr* msg, RecvStamp& stamp);
+ssize_t recvWithTimestamp(int sockfd, void* buffer, size_t length, int flags,
+                          struct sockaddr_in* fromAddr, RecvStamp& stamp);
+
+// Kernel receive stamp minus wall send stamp, unless the wall clock moved
+// in between; then the monotonic difference is used instead
+double stampRttMs(const SendStamp& sent, const RecvStamp& received, bool* fromKernel = nullptr);
+
+#endif
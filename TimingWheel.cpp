@@ -0,0 +1,238 @@
+#include "TimingWheel.hpp"
+#include "Timestamp.hpp"
+#include <cstring>
+
+// The vector fill constructor binds it by reference, which -O0 builds link against
+const TimingWheel::TimerId TimingWheel::INVALID_TIMER;
+
+TimingWheel::TimingWheel(double tickMs)
+    : tickNs(tickMs > 0.0 ? (long long)(tickMs * 1000000.0) : 100000), currentTick(0),
+      heads(LEVELS * SLOTS, INVALID_TIMER), freeList(INVALID_TIMER), active(0) {
+    if (tickNs < 1) tickNs = 1;
+    memset(occupied, 0, sizeof(occupied));
+    origin = monotonicNow();
+}
+
+void TimingWheel::start(const struct timespec& now) {
+    origin = now;
+    currentTick = 0;
+}
+
+unsigned long long TimingWheel::toTick(const struct timespec& when, bool roundUp) const {
+    long long ns = (long long)(when.tv_sec - origin.tv_sec) * 1000000000LL +
+                   (when.tv_nsec - origin.tv_nsec);
+    if (ns <= 0) return 0;
+    return roundUp ? (unsigned long long)((ns + tickNs - 1) / tickNs)
+                   : (unsigned long long)(ns / tickNs);
+}
+
+// Places a node by its distance from the current tick: within 256 ticks in
+// level 0, within 65536 in level 1, and so on
+void TimingWheel::link(TimerId id) {
+    Node& node = nodes[id];
+    unsigned long long delta = node.expires - currentTick;
+    unsigned long long maxDelta = 1ULL << (LEVELS * SLOT_BITS);
+    if (delta >= maxDelta) {
+        node.expires = currentTick + maxDelta - 1;
+        delta = maxDelta - 1;
+    }
+
+    int level = 0;
+    while (level < LEVELS - 1 && delta >= (1ULL << ((level + 1) * SLOT_BITS))) {
+        level++;
+    }
+    int index = (int)((node.expires >> (level * SLOT_BITS)) & (SLOTS - 1));
+    int slot = level * SLOTS + index;
+
+    node.slot = slot;
+    node.prev = INVALID_TIMER;
+    node.next = heads[slot];
+    if (node.next != INVALID_TIMER) {
+        nodes[node.next].prev = id;
+    }
+    heads[slot] = id;
+    occupied[level][index / 64] |= 1ULL << (index % 64);
+}
+
+void TimingWheel::unlink(TimerId id) {
+    Node& node = nodes[id];
+    int slot = node.slot;
+
+    if (node.prev != INVALID_TIMER) {
+        nodes[node.prev].next = node.next;
+    } else {
+        heads[slot] = node.next;
+    }
+    if (node.next != INVALID_TIMER) {
+        nodes[node.next].prev = node.prev;
+    }
+    if (heads[slot] == INVALID_TIMER) {
+        int level = slot / SLOTS;
+        int index = slot % SLOTS;
+        occupied[level][index / 64] &= ~(1ULL << (index % 64));
+    }
+    node.slot = -1;
+}
+
+TimingWheel::TimerId TimingWheel::schedule(const struct timespec& when, unsigned long long data) {
+    TimerId id;
+    if (freeList != INVALID_TIMER) {
+        id = freeList;
+        freeList = nodes[id].next;
+    } else {
+        id = (TimerId)nodes.size();
+        nodes.push_back(Node());
+    }
+
+    Node& node = nodes[id];
+    node.data = data;
+    node.expires = toTick(when, true);
+    if (node.expires <= currentTick) {
+        node.expires = currentTick + 1; // That tick has already been processed
+    }
+    link(id);
+    active++;
+    return id;
+}
+
+void TimingWheel::cancel(TimerId id) {
+    if (id >= nodes.size() || nodes[id].slot < 0) {
+        return; // Already fired or cancelled
+    }
+    unlink(id);
+    nodes[id].next = freeList;
+    freeList = id;
+    active--;
+}
+
+// Re-files the timers of the level's current slot into the levels below
+void TimingWheel::cascade(int level) {
+    int index = (int)((currentTick >> (level * SLOT_BITS)) & (SLOTS - 1));
+    int slot = level * SLOTS + index;
+    TimerId id = heads[slot];
+
+    heads[slot] = INVALID_TIMER;
+    occupied[level][index / 64] &= ~(1ULL << (index % 64));
+
+    while (id != INVALID_TIMER) {
+        TimerId next = nodes[id].next;
+        link(id);
+        id = next;
+    }
+}
+
+// First occupied slot index >= from in a level, or -1
+int TimingWheel::nextOccupied(int level, int from) const {
+    for (int word = from / 64; word < SLOTS / 64; word++) {
+        unsigned long long bits = occupied[level][word];
+        if (word == from / 64) {
+            bits &= ~0ULL << (from % 64);
+        }
+        if (bits) {
+            return word * 64 + __builtin_ctzll(bits);
+        }
+    }
+    return -1;
+}
+
+// Earliest tick anything can be due: exact for level 0, the start of the
+// slot's block for the levels above (their timers are cascaded from there)
+bool TimingWheel::nextTick(unsigned long long& tick) const {
+    if (active == 0) {
+        return false;
+    }
+
+    int index = (int)(currentTick & (SLOTS - 1));
+    int slot = index + 1 < SLOTS ? nextOccupied(0, index + 1) : -1;
+    if (slot >= 0) {
+        tick = currentTick - index + slot;
+        return true; // Nothing in this block can beat it
+    }
+
+    bool found = false;
+    slot = nextOccupied(0, 0);
+    if (slot >= 0) {
+        tick = (currentTick | (SLOTS - 1)) + 1 + slot; // Wrapped into the next block
+        found = true;
+    }
+
+    for (int level = 1; level < LEVELS; level++) {
+        int shift = level * SLOT_BITS;
+        int current = (int)((currentTick >> shift) & (SLOTS - 1));
+        slot = current + 1 < SLOTS ? nextOccupied(level, current + 1) : -1;
+        unsigned long long distance;
+        if (slot >= 0) {
+            distance = slot - current;
+        } else {
+            slot = nextOccupied(level, 0);
+            if (slot < 0) continue;
+            distance = slot + SLOTS - current; // Wrapped; current itself means a full turn
+        }
+        unsigned long long start = ((currentTick >> shift) + distance) << shift;
+        if (!found || start < tick) {
+            tick = start;
+            found = true;
+        }
+    }
+
+    return found;
+}
+
+void TimingWheel::advance(const struct timespec& now, std::vector<unsigned long long>& expired) {
+    unsigned long long target = toTick(now, false);
+
+    while (currentTick < target) {
+        // Jump straight to the next tick with work; empty slots are never visited
+        unsigned long long tick;
+        if (!nextTick(tick) || tick > target) {
+            currentTick = target;
+            break;
+        }
+        currentTick = tick;
+
+        if ((currentTick & (SLOTS - 1)) == 0) {
+            // Block boundary: pull the new block's timers down, highest level first
+            int level = 1;
+            while (level < LEVELS - 1 &&
+                   ((currentTick >> (level * SLOT_BITS)) & (SLOTS - 1)) == 0) {
+                level++;
+            }
+            for (; level >= 1; level--) {
+                cascade(level);
+            }
+        }
+
+        int slot = (int)(currentTick & (SLOTS - 1));
+        TimerId id = heads[slot];
+        heads[slot] = INVALID_TIMER;
+        occupied[0][slot / 64] &= ~(1ULL << (slot % 64));
+
+        while (id != INVALID_TIMER) {
+            Node& node = nodes[id];
+            TimerId next = node.next;
+            expired.push_back(node.data);
+            node.slot = -1;
+            node.next = freeList;
+            freeList = id;
+            active--;
+            id = next;
+        }
+    }
+}
+
+bool TimingWheel::nextExpiry(struct timespec& when) const {
+    unsigned long long tick;
+    if (!nextTick(tick)) {
+        return false;
+    }
+    when = addMs(origin, (double)(tick * tickNs) / 1000000.0);
+    return true;
+}
+
+size_t TimingWheel::size() const {
+    return active;
+}
+
+double TimingWheel::getTickMs() const {
+    return tickNs / 1000000.0;
+}
@@ -0,0 +1,65 @@
+#ifndef TIMING_WHEEL_HPP
+#define TIMING_WHEEL_HPP
+
+#include <time.h>
+#include <vector>
+
+// Hierarchical timing wheel (four levels of 256 slots) over a fixed tick.
+// schedule(), cancel() and the per-timer share of advance() are O(1), so
+// hundreds of thousands of send and expiry timers cost the same per event
+// as a handful. Timers never fire early and at most one tick late.
+class TimingWheel {
+public:
+    typedef unsigned int TimerId;
+    static const TimerId INVALID_TIMER = 0xFFFFFFFFu;
+
+private:
+    static const int LEVELS = 4;
+    static const int SLOT_BITS = 8;
+    static const int SLOTS = 1 << SLOT_BITS;
+
+    struct Node {
+        unsigned long long expires;   // Absolute tick
+        unsigned long long data;
+        TimerId prev;
+        TimerId next;
+        int slot;                     // level * SLOTS + index, -1 when free
+    };
+
+    long long tickNs;
+    struct timespec origin;
+    unsigned long long currentTick;   // Every timer at or before this tick has fired
+    std::vector<Node> nodes;
+    std::vector<TimerId> heads;       // LEVELS * SLOTS list heads
+    unsigned long long occupied[LEVELS][SLOTS / 64];  // Non-empty slot bitmaps
+    TimerId freeList;
+    size_t active;
+
+    unsigned long long toTick(const struct timespec& when, bool roundUp) const;
+    void link(TimerId id);
+    void unlink(TimerId id);
+    void cascade(int level);
+    int nextOccupied(int level, int from) const;
+    bool nextTick(unsigned long long& tick) const;
+
+public:
+    explicit TimingWheel(double tickMs = 0.1);
+
+    // Ticks count from here; call before scheduling
+    void start(const struct timespec& now);
+
+    TimerId schedule(const struct timespec& when, unsigned long long data);
+    void cancel(TimerId id);
+
+    // Appends the data of every timer due at or before now to expired
+    void advance(const struct timespec& now, std::vector<unsigned long long>& expired);
+
+    // Earliest instant a timer can be due (exact for the next 256 ticks, a
+    // lower bound beyond that); false when nothing is scheduled
+    bool nextExpiry(struct timespec& when) const;
+
+    size_t size() const;
+    double getTickMs() const;
+};
+
+#endif
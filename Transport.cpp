@@ -0,0 +1,162 @@
+#include "Transport.hpp"
+#include "SocketFilter.hpp"
+#include "Output.hpp"
+#include "utils.hpp"
+#include <unistd.h>
+#include <poll.h>
+#include <netinet/ip.h>
+#include <sys/socket.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+int Transport::sendBatch(BatchIO& batch, int count) {
+    if (count > batch.getCapacity()) count = batch.getCapacity();
+
+    int sent = 0;
+    while (sent < count) {
+        const ICMPPacket& packet = batch.packet(sent);
+        if (send((const char*)packet.getData(), packet.getSize(), batch.destination(sent)) < 0) {
+            break;
+        }
+        sent++;
+    }
+    // Like sendmmsg(): an error only surfaces when nothing went out
+    return sent > 0 ? sent : -1;
+}
+
+int Transport::receiveBatch(BatchIO& batch) {
+    int received = 0;
+    while (received < batch.getCapacity()) {
+        struct sockaddr_in from;
+        RecvStamp stamp;
+        int length = receive(batch.buffer(received), batch.getBufferSize(), &from, stamp);
+        if (length < 0) {
+            break;
+        }
+        batch.setReceived(received, length, from, stamp);
+        received++;
+    }
+    return received > 0 ? received : -1;
+}
+
+RawSocketTransport::RawSocketTransport() : sockfd(-1), timestampMode(TIMESTAMP_NONE) {}
+
+RawSocketTransport::~RawSocketTransport() {
+    close();
+}
+
+const char* RawSocketTransport::getName() const {
+    return "raw socket";
+}
+
+bool RawSocketTransport::open(unsigned short icmpId, size_t replySize, size_t queueBytes) {
+    (void)replySize;
+
+    if (traceEnabled()) {
+        printSection("SOCKET CREATION");
+        std::cout << "  Creating raw socket..." << std::endl;
+    }
+
+    sockfd = socket(AF_INET, SOCK_RAW, IPPROTO_ICMP);
+
+    if (sockfd < 0) {
+        std::cout << "  [FAILED] Cannot create socket" << std::endl;
+        std::cout << "  Error Code: " << errno << std::endl;
+        std::cout << "  Error Message: " << strerror(errno) << std::endl;
+        std::cout << "  Note: Root privileges required for raw sockets" << std::endl;
+        return false;
+    }
+
+    if (traceEnabled()) {
+        std::cout << "  [SUCCESS] Socket created" << std::endl;
+        printInfo("Socket File Descriptor", sockfd);
+        printInfo("Socket Type", "SOCK_RAW");
+        printInfo("Protocol", "IPPROTO_ICMP");
+        std::cout << std::endl << "  Configuring socket options..." << std::endl;
+    }
+
+    if (queueBytes > 0) {
+        // A full window of large replies can arrive back to back; only grow the
+        // buffer when the default cannot hold it (a bigger one just costs cache)
+        int current = 0;
+        socklen_t optLen = sizeof(current);
+        getsockopt(sockfd, SOL_SOCKET, SO_RCVBUF, &current, &optLen);
+        if (queueBytes > (size_t)current) {
+            int bufSize = (int)std::min<size_t>(32 * 1024 * 1024, queueBytes * 2);
+            if (setsockopt(sockfd, SOL_SOCKET, SO_RCVBUFFORCE, &bufSize, sizeof(bufSize)) < 0) {
+                setsockopt(sockfd, SOL_SOCKET, SO_RCVBUF, &bufSize, sizeof(bufSize));
+            }
+        }
+    }
+
+    timestampMode = enableKernelTimestamps(sockfd);
+    if (traceEnabled()) {
+        printInfo("RTT Timestamp Source", getTimestampModeName(timestampMode));
+    }
+
+    if (attachReplyFilter(sockfd, icmpId)) {
+        flushSocket(sockfd);
+        if (traceEnabled()) {
+            std::cout << "  [SUCCESS] Kernel BPF filter attached" << std::endl;
+            printInfo("Accepted Packets", "Echo Reply and ICMP errors for ICMP ID " + std::to_string(icmpId));
+        }
+    } else {
+        std::cout << "  [WARNING] Cannot attach BPF filter: " << strerror(errno) << std::endl;
+        std::cout << "  Foreign ICMP traffic will be filtered in userspace" << std::endl;
+    }
+
+    return true;
+}
+
+void RawSocketTransport::close() {
+    if (sockfd >= 0) {
+        if (traceEnabled()) {
+            std::cout << std::endl << "  Closing socket (fd: " << sockfd << ")..." << std::endl;
+        }
+        ::close(sockfd);
+        sockfd = -1;
+        if (traceEnabled()) {
+            std::cout << "  [SUCCESS] Socket closed" << std::endl;
+        }
+    }
+}
+
+int RawSocketTransport::getFd() const {
+    return sockfd;
+}
+
+TimestampMode RawSocketTransport::getTimestampMode() const {
+    return timestampMode;
+}
+
+int RawSocketTransport::send(const char* data, size_t length, const struct sockaddr_in& dest) {
+    return (int)sendto(sockfd, data, length, 0, (const struct sockaddr*)&dest, sizeof(dest));
+}
+
+int RawSocketTransport::receive(char* buffer, size_t length, struct sockaddr_in* from, RecvStamp& stamp) {
+    return (int)recvWithTimestamp(sockfd, buffer, length, MSG_DONTWAIT, from, stamp);
+}
+
+int RawSocketTransport::wait(double waitMs) {
+    struct pollfd pfd;
+    pfd.fd = sockfd;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+
+    // ppoll() keeps sub-millisecond waits that poll() would round away
+    struct timespec wait;
+    wait.tv_sec = (time_t)(waitMs / 1000.0);
+    wait.tv_nsec = (long)((waitMs - wait.tv_sec * 1000.0) * 1000000.0);
+
+    return ppoll(&pfd, 1, &wait, nullptr);
+}
+
+int RawSocketTransport::sendBatch(BatchIO& batch, int count) {
+    return batch.sendBatch(sockfd, count);
+}
+
+int RawSocketTransport::receiveBatch(BatchIO& batch) {
+    return batch.receiveBatch(sockfd, MSG_DONTWAIT);
+}
@@ -0,0 +1,63 @@
+#ifndef TRANSPORT_HPP
+#define TRANSPORT_HPP
+
+#include "BatchIO.hpp"
+#include "Timestamp.hpp"
+#include <cstddef>
+#include <netinet/in.h>
+
+// What PingClient needs from the network for echo traffic. Calls follow
+// the socket conventions they replace: send and receive return a byte
+// count or -1 with errno set (EAGAIN when nothing is queued), and wait()
+// returns > 0 once something can be received, 0 at the timeout and -1 on
+// error. Packets handed to send() start at the ICMP header; received ones
+// start at the IP header, as on a raw socket.
+class Transport {
+public:
+    virtual ~Transport() {}
+
+    virtual const char* getName() const = 0;
+    // replySize is the largest reply the caller will read; queueBytes is how
+    // much may arrive back to back before it reads (0 leaves the default)
+    virtual bool open(unsigned short icmpId, size_t replySize, size_t queueBytes) = 0;
+    virtual void close() = 0;
+    // Underlying descriptor for socket options and io_uring, -1 if there is none
+    virtual int getFd() const = 0;
+    virtual TimestampMode getTimestampMode() const = 0;
+
+    virtual int send(const char* data, size_t length, const struct sockaddr_in& dest) = 0;
+    virtual int receive(char* buffer, size_t length, struct sockaddr_in* from, RecvStamp& stamp) = 0;
+    virtual int wait(double waitMs) = 0;
+
+    // One packet at a time by default; the raw socket uses sendmmsg()/recvmmsg()
+    virtual int sendBatch(BatchIO& batch, int count);
+    virtual int receiveBatch(BatchIO& batch);
+
+    // End-of-run report, if the transport has anything to add
+    virtual void printSummary() const {}
+};
+
+// A raw ICMP socket with kernel timestamps and the BPF reply filter
+class RawSocketTransport : public Transport {
+private:
+    int sockfd;
+    TimestampMode timestampMode;
+
+public:
+    RawSocketTransport();
+    ~RawSocketTransport();
+
+    const char* getName() const;
+    bool open(unsigned short icmpId, size_t replySize, size_t queueBytes);
+    void close();
+    int getFd() const;
+    TimestampMode getTimestampMode() const;
+
+    int send(const char* data, size_t length, const struct sockaddr_in& dest);
+    int receive(char* buffer, size_t length, struct sockaddr_in* from, RecvStamp& stamp);
+    int wait(double waitMs);
+    int sendBatch(BatchIO& batch, int count);
+    int receiveBatch(BatchIO& batch);
+};
+
+#endif
@@ -0,0 +1,400 @@
+#include "UringIO.hpp"
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+
+// Completion tags in user_data; sends carry their slot in the low bits
+static const unsigned long long TAG_RECV = 1ULL << 32;
+static const unsigned long long TAG_SEND = 2ULL << 32;
+
+static const unsigned RING_ENTRIES = 1024;
+static const size_t RX_POOL_BYTES = 4 * 1024 * 1024;
+
+static int uringSetup(unsigned entries, struct io_uring_params* params) {
+    return (int)syscall(__NR_io_uring_setup, entries, params);
+}
+
+static int uringEnter(int fd, unsigned toSubmit, unsigned minComplete, unsigned flags,
+                      void* arg, size_t argSize) {
+    return (int)syscall(__NR_io_uring_enter, fd, toSubmit, minComplete, flags, arg, argSize);
+}
+
+static int uringRegister(int fd, unsigned opcode, void* arg, unsigned count) {
+    return (int)syscall(__NR_io_uring_register, fd, opcode, arg, count);
+}
+
+UringIO::UringIO(int sendSlots, size_t rxBufferSize, size_t payloadSize)
+    : ringfd(-1), sockfd(-1), sqRing(MAP_FAILED), sqRingSize(0), cqRing(MAP_FAILED),
+      cqRingSize(0), sqes(nullptr), sqesSize(0), sqHead(nullptr), sqTail(nullptr), sqMask(0),
+      sqArray(nullptr), sqEntries(0), cqHead(nullptr), cqTail(nullptr), cqMask(0),
+      cqes(nullptr), pendingSubmit(0), bufRing(nullptr), bufRingSize(0), bufCount(0),
+      bufTail(0), bufSize(0), recvArmed(false), heldBuffer(-1) {
+    if (sendSlots < 1) sendSlots = 1;
+
+    txPackets.assign(sendSlots, ICMPPacket(payloadSize));
+    txSeqs.resize(sendSlots);
+    txAddrs.resize(sendSlots);
+    txIov.resize(sendSlots);
+    txMsgs.resize(sendSlots);
+    for (int i = sendSlots - 1; i >= 0; i--) {
+        memset(&txMsgs[i], 0, sizeof(txMsgs[i]));
+        txIov[i].iov_base = const_cast<void*>(txPackets[i].getData());
+        txIov[i].iov_len = txPackets[i].getSize();
+        txMsgs[i].msg_name = &txAddrs[i];
+        txMsgs[i].msg_namelen = sizeof(txAddrs[i]);
+        txMsgs[i].msg_iov = &txIov[i];
+        txMsgs[i].msg_iovlen = 1;
+        freeSlots.push_back(i);
+    }
+
+    memset(&recvTemplate, 0, sizeof(recvTemplate));
+    recvTemplate.msg_namelen = sizeof(struct sockaddr_in);
+    recvTemplate.msg_controllen = TIMESTAMP_CONTROL_SIZE;
+    bufSize = sizeof(struct io_uring_recvmsg_out) + sizeof(struct sockaddr_in) +
+              TIMESTAMP_CONTROL_SIZE + rxBufferSize;
+
+    // A power of two, as the buffer ring requires, within a fixed memory budget
+    bufCount = 1024;
+    while (bufCount > 16 && bufCount * bufSize > RX_POOL_BYTES) {
+        bufCount /= 2;
+    }
+}
+
+UringIO::~UringIO() {
+    teardown();
+}
+
+void UringIO::teardown() {
+    if (bufRing != nullptr) {
+        munmap(bufRing, bufRingSize);
+        bufRing = nullptr;
+    }
+    if (sqes != nullptr) {
+        munmap(sqes, sqesSize);
+        sqes = nullptr;
+    }
+    if (cqRing != MAP_FAILED && cqRing != sqRing) {
+        munmap(cqRing, cqRingSize);
+    }
+    if (sqRing != MAP_FAILED) {
+        munmap(sqRing, sqRingSize);
+    }
+    sqRing = MAP_FAILED;
+    cqRing = MAP_FAILED;
+    if (ringfd >= 0) {
+        close(ringfd); // Also cancels the posted multishot receive
+        ringfd = -1;
+    }
+}
+
+const std::string& UringIO::getFailure() const {
+    return failure;
+}
+
+bool UringIO::mapRings(unsigned entries) {
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    params.flags = IORING_SETUP_CQSIZE | IORING_SETUP_COOP_TASKRUN | IORING_SETUP_SINGLE_ISSUER;
+    params.cq_entries = entries * 4;
+
+    ringfd = uringSetup(entries, &params);
+    if (ringfd < 0 && errno == EINVAL) {
+        // Kernels before 6.0 reject the task-running hints; they are only an optimization
+        memset(&params, 0, sizeof(params));
+        params.flags = IORING_SETUP_CQSIZE;
+        params.cq_entries = entries * 4;
+        ringfd = uringSetup(entries, &params);
+    }
+    if (ringfd < 0) {
+        failure = std::string("io_uring_setup: ") + strerror(errno);
+        return false;
+    }
+    if (!(params.features & IORING_FEAT_EXT_ARG) || !(params.features & IORING_FEAT_NODROP)) {
+        failure = "kernel lacks io_uring wait timeouts (needs 5.11+)";
+        return false;
+    }
+
+    sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    bool single = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single && cqRingSize > sqRingSize) {
+        sqRingSize = cqRingSize;
+    }
+
+    sqRing = mmap(nullptr, sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                  ringfd, IORING_OFF_SQ_RING);
+    if (sqRing == MAP_FAILED) {
+        failure = std::string("mmap(SQ ring): ") + strerror(errno);
+        return false;
+    }
+    cqRing = single ? sqRing
+                    : mmap(nullptr, cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                           ringfd, IORING_OFF_CQ_RING);
+    if (cqRing == MAP_FAILED) {
+        failure = std::string("mmap(CQ ring): ") + strerror(errno);
+        return false;
+    }
+
+    sqesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+    void* sqeMap = mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                        ringfd, IORING_OFF_SQES);
+    if (sqeMap == MAP_FAILED) {
+        failure = std::string("mmap(SQEs): ") + strerror(errno);
+        return false;
+    }
+    sqes = (struct io_uring_sqe*)sqeMap;
+
+    char* sq = (char*)sqRing;
+    sqHead = (unsigned*)(sq + params.sq_off.head);
+    sqTail = (unsigned*)(sq + params.sq_off.tail);
+    sqMask = *(unsigned*)(sq + params.sq_off.ring_mask);
+    sqArray = (unsigned*)(sq + params.sq_off.array);
+    sqEntries = params.sq_entries;
+
+    char* cq = (char*)cqRing;
+    cqHead = (unsigned*)(cq + params.cq_off.head);
+    cqTail = (unsigned*)(cq + params.cq_off.tail);
+    cqMask = *(unsigned*)(cq + params.cq_off.ring_mask);
+    cqes = (struct io_uring_cqe*)(cq + params.cq_off.cqes);
+    return true;
+}
+
+bool UringIO::registerBuffers() {
+    bufRingSize = bufCount * sizeof(struct io_uring_buf);
+    void* ringMem = mmap(nullptr, bufRingSize, PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (ringMem == MAP_FAILED) {
+        failure = std::string("mmap(buffer ring): ") + strerror(errno);
+        return false;
+    }
+    bufRing = (struct io_uring_buf_ring*)ringMem;
+
+    struct io_uring_buf_reg reg;
+    memset(&reg, 0, sizeof(reg));
+    reg.ring_addr = (unsigned long long)(unsigned long)bufRing;
+    reg.ring_entries = bufCount;
+    reg.bgid = BUFFER_GROUP;
+    if (uringRegister(ringfd, IORING_REGISTER_PBUF_RING, &reg, 1) < 0) {
+        failure = std::string("provided buffer ring (needs 5.19+): ") + strerror(errno);
+        return false;
+    }
+
+    rxBuffers.resize(bufCount * bufSize);
+    bufTail = 0;
+    for (unsigned i = 0; i < bufCount; i++) {
+        provideBuffer((unsigned short)i);
+    }
+    return true;
+}
+
+void UringIO::provideBuffer(unsigned short id) {
+    // Index the entries by hand: in C++ the header's flexible-array wrapper
+    // shifts bufs[] by 8 bytes, while the kernel expects it at offset 0
+    struct io_uring_buf* buf = (struct io_uring_buf*)bufRing + (bufTail & (bufCount - 1));
+    buf->addr = (unsigned long long)(unsigned long)&rxBuffers[id * bufSize];
+    buf->len = (unsigned)bufSize;
+    buf->bid = id;
+    bufTail++;
+    __atomic_store_n(&bufRing->tail, bufTail, __ATOMIC_RELEASE);
+}
+
+struct io_uring_sqe* UringIO::getSqe() {
+    unsigned head = __atomic_load_n(sqHead, __ATOMIC_ACQUIRE);
+    unsigned tail = *sqTail + pendingSubmit;
+    if (tail - head >= sqEntries) {
+        return nullptr;
+    }
+    unsigned index = tail & sqMask;
+    struct io_uring_sqe* sqe = &sqes[index];
+    memset(sqe, 0, sizeof(*sqe));
+    sqArray[index] = index;
+    pendingSubmit++;
+    return sqe;
+}
+
+bool UringIO::armReceive() {
+    struct io_uring_sqe* sqe = getSqe();
+    if (sqe == nullptr) {
+        return false;
+    }
+    sqe->opcode = IORING_OP_RECVMSG;
+    sqe->fd = sockfd;
+    sqe->addr = (unsigned long long)(unsigned long)&recvTemplate;
+    sqe->len = 1;
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = BUFFER_GROUP;
+    sqe->user_data = TAG_RECV;
+    recvArmed = true;
+    return true;
+}
+
+bool UringIO::setup(int socketFd) {
+    sockfd = socketFd;
+
+    if (!mapRings(RING_ENTRIES) || !registerBuffers() || !armReceive()) {
+        teardown();
+        return false;
+    }
+
+    // Kernels before 6.0 reject multishot recvmsg inline, so the error is
+    // already in the completion queue once the submit returns
+    if (submitAndWait(0.0) < 0) {
+        teardown();
+        return false;
+    }
+    unsigned head = *cqHead;
+    unsigned tail = __atomic_load_n(cqTail, __ATOMIC_ACQUIRE);
+    for (; head != tail; head++) {
+        const struct io_uring_cqe& cqe = cqes[head & cqMask];
+        if (cqe.user_data == TAG_RECV && cqe.res < 0 && cqe.res != -ENOBUFS) {
+            failure = std::string("multishot recvmsg (needs 6.0+): ") + strerror(-cqe.res);
+            teardown();
+            return false;
+        }
+    }
+    return true;
+}
+
+bool UringIO::canSend() const {
+    return !freeSlots.empty();
+}
+
+bool UringIO::queueSend(unsigned short seq, const struct sockaddr_in& dest) {
+    if (freeSlots.empty()) {
+        return false;
+    }
+    struct io_uring_sqe* sqe = getSqe();
+    if (sqe == nullptr) {
+        return false;
+    }
+
+    int slot = freeSlots.back();
+    freeSlots.pop_back();
+    txPackets[slot].build(seq);
+    txSeqs[slot] = seq;
+    txAddrs[slot] = dest;
+
+    sqe->opcode = IORING_OP_SENDMSG;
+    sqe->fd = sockfd;
+    sqe->addr = (unsigned long long)(unsigned long)&txMsgs[slot];
+    sqe->len = 1;
+    sqe->user_data = TAG_SEND | (unsigned)slot;
+    return true;
+}
+
+int UringIO::submitAndWait(double waitMs) {
+    if (pendingSubmit > 0) {
+        __atomic_store_n(sqTail, *sqTail + pendingSubmit, __ATOMIC_RELEASE);
+    }
+    unsigned toSubmit = pendingSubmit;
+    pendingSubmit = 0;
+
+    // No point sleeping while completions are already waiting to be reaped
+    bool haveEvents = *cqHead != __atomic_load_n(cqTail, __ATOMIC_ACQUIRE);
+    unsigned flags = 0;
+    unsigned minComplete = 0;
+    struct __kernel_timespec wait;
+    struct io_uring_getevents_arg arg;
+    memset(&arg, 0, sizeof(arg));
+
+    if (waitMs > 0.0 && !haveEvents) {
+        wait.tv_sec = (long long)(waitMs / 1000.0);
+        wait.tv_nsec = (long long)((waitMs - wait.tv_sec * 1000.0) * 1000000.0);
+        arg.ts = (unsigned long long)(unsigned long)&wait;
+        flags = IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG;
+        minComplete = 1;
+    } else if (toSubmit == 0) {
+        // Still enter so deferred task work posts its completions
+        flags = IORING_ENTER_GETEVENTS;
+    }
+
+    int result = uringEnter(ringfd, toSubmit, minComplete, flags,
+                            flags & IORING_ENTER_EXT_ARG ? &arg : nullptr,
+                            flags & IORING_ENTER_EXT_ARG ? sizeof(arg) : 0);
+    if (result < 0) {
+        if (errno == ETIME || errno == EINTR || errno == EBUSY || errno == EAGAIN) {
+            return 0;
+        }
+        failure = std::string("io_uring_enter: ") + strerror(errno);
+        return -1;
+    }
+    return result;
+}
+
+void UringIO::releaseHeld() {
+    if (heldBuffer >= 0) {
+        provideBuffer((unsigned short)heldBuffer);
+        heldBuffer = -1;
+    }
+}
+
+bool UringIO::nextCompletion(UringCompletion& completion) {
+    releaseHeld();
+
+    for (;;) {
+        unsigned head = *cqHead;
+        if (head == __atomic_load_n(cqTail, __ATOMIC_ACQUIRE)) {
+            if (!recvArmed) {
+                armReceive(); // Submitted with the next submitAndWait()
+            }
+            return false;
+        }
+
+        struct io_uring_cqe cqe = cqes[head & cqMask];
+        __atomic_store_n(cqHead, head + 1, __ATOMIC_RELEASE);
+
+        if ((cqe.user_data & TAG_SEND) != 0) {
+            int slot = (int)(cqe.user_data & 0xFFFFFFFFu);
+            completion.kind = UringCompletion::SEND;
+            completion.result = cqe.res;
+            completion.seq = txSeqs[slot];
+            freeSlots.push_back(slot);
+            return true;
+        }
+
+        // The multishot receive ends on errors and when the buffers run out;
+        // replies stay queued on the socket until it is re-armed
+        if (!(cqe.flags & IORING_CQE_F_MORE)) {
+            recvArmed = false;
+        }
+        if (!(cqe.flags & IORING_CQE_F_BUFFER)) {
+            continue;
+        }
+
+        unsigned short id = (unsigned short)(cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+        heldBuffer = id;
+        if (cqe.res < 0) {
+            releaseHeld();
+            continue;
+        }
+
+        char* base = &rxBuffers[id * bufSize];
+        const struct io_uring_recvmsg_out* out = (const struct io_uring_recvmsg_out*)base;
+        char* name = base + sizeof(*out);
+        char* control = name + recvTemplate.msg_namelen;
+
+        completion.kind = UringCompletion::RECV;
+        completion.result = cqe.res;
+        completion.seq = 0;
+        completion.data = control + recvTemplate.msg_controllen;
+        completion.length = (int)out->payloadlen;
+        if ((size_t)completion.length > bufSize - (completion.data - base)) {
+            completion.length = (int)(bufSize - (completion.data - base)); // MSG_TRUNC
+        }
+        memcpy(&completion.source, name, sizeof(completion.source));
+
+        completion.stamp.mono = monotonicNow();
+        completion.stamp.hasKernel = false;
+        completion.stamp.hasHardware = false;
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_control = control;
+        msg.msg_controllen = out->controllen;
+        readTimestampControl(&msg, completion.stamp);
+        return true;
+    }
+}
@@ -0,0 +1,103 @@
+#ifndef URING_IO_HPP
+#define URING_IO_HPP
+
+#include "ICMPPacket.hpp"
+#include "Timestamp.hpp"
+#include <string>
+#include <vector>
+#include <sys/socket.h>
+#include <netinet/in.h>
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+struct io_uring_buf_ring;
+
+// One reaped completion: a finished send, or a reply delivered by the
+// multishot receive into a registered buffer
+struct UringCompletion {
+    enum Kind { SEND, RECV };
+
+    Kind kind;
+    int result;                 // Bytes moved, or -errno
+    unsigned short seq;         // SEND: sequence number the slot carried
+    const char* data;           // RECV: IP packet, valid until the next call
+    int length;
+    struct sockaddr_in source;
+    RecvStamp stamp;
+};
+
+// io_uring transport for the pipelined and flood paths, driven through the
+// raw syscalls (no liburing). A single multishot recvmsg stays posted
+// against a ring of provided buffers, sends are queued as SENDMSG entries,
+// and one io_uring_enter() both submits the batch and waits for
+// completions. setup() fails on kernels without the needed features and
+// the caller falls back to the poll backend.
+class UringIO {
+private:
+    static const unsigned short BUFFER_GROUP = 1;
+
+    int ringfd;
+    int sockfd;
+    std::string failure;
+
+    void* sqRing;
+    size_t sqRingSize;
+    void* cqRing;
+    size_t cqRingSize;
+    struct io_uring_sqe* sqes;
+    size_t sqesSize;
+    unsigned* sqHead;
+    unsigned* sqTail;
+    unsigned sqMask;
+    unsigned* sqArray;
+    unsigned sqEntries;
+    unsigned* cqHead;
+    unsigned* cqTail;
+    unsigned cqMask;
+    struct io_uring_cqe* cqes;
+    unsigned pendingSubmit;
+
+    // Provided receive buffers: recvmsg_out header, source address,
+    // control messages, then the packet
+    struct io_uring_buf_ring* bufRing;
+    size_t bufRingSize;
+    unsigned bufCount;
+    unsigned short bufTail;
+    size_t bufSize;
+    std::vector<char> rxBuffers;
+    struct msghdr recvTemplate;
+    bool recvArmed;
+    int heldBuffer;
+
+    std::vector<ICMPPacket> txPackets;
+    std::vector<unsigned short> txSeqs;
+    std::vector<struct sockaddr_in> txAddrs;
+    std::vector<struct iovec> txIov;
+    std::vector<struct msghdr> txMsgs;
+    std::vector<int> freeSlots;
+
+    struct io_uring_sqe* getSqe();
+    bool mapRings(unsigned entries);
+    bool registerBuffers();
+    void provideBuffer(unsigned short id);
+    bool armReceive();
+    void releaseHeld();
+    void teardown();
+
+public:
+    UringIO(int sendSlots = 64, size_t rxBufferSize = 1024,
+            size_t payloadSize = ICMPPacket::DEFAULT_PAYLOAD_SIZE);
+    ~UringIO();
+
+    bool setup(int socketFd);
+    const std::string& getFailure() const;
+
+    bool canSend() const;
+    bool queueSend(unsigned short seq, const struct sockaddr_in& dest);
+    // Submits queued entries and waits up to waitMs for a completion;
+    // returns -1 on a hard error
+    int submitAndWait(double waitMs);
+    bool nextCompletion(UringCompletion& completion);
+};
+
+#endif
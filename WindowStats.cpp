@@ -0,0 +1,119 @@
+#include "WindowStats.hpp"
+
+static const int WINDOW_SECONDS[WindowStats::WINDOW_COUNT] = {10, 60, 300};
+
+WindowStats::WindowStats() : current(-1) {
+    for (int w = 0; w < WINDOW_COUNT; w++) {
+        windows[w].seconds = WINDOW_SECONDS[w];
+    }
+    reset(-1);
+}
+
+void WindowStats::resetBucket(Bucket& bucket) {
+    bucket.answered = 0;
+    bucket.lost = 0;
+    bucket.rttSum = 0.0;
+    bucket.minTime = 0.0;
+    bucket.maxTime = 0.0;
+    bucket.histogram.clear();   // Keeps its capacity, so a refill does not allocate
+}
+
+void WindowStats::reset(long long second) {
+    for (int i = 0; i < RING_SECONDS; i++) {
+        resetBucket(buckets[i]);
+    }
+    for (int w = 0; w < WINDOW_COUNT; w++) {
+        windows[w].answered = 0;
+        windows[w].lost = 0;
+        windows[w].histogram.clear();
+    }
+    current = second;
+}
+
+void WindowStats::advance(const struct timespec& now) {
+    long long second = (long long)now.tv_sec;
+    if (second <= current) {
+        return;
+    }
+    // First call, or a stall longer than the ring: every bucket is stale
+    if (current < 0 || second - current >= RING_SECONDS) {
+        reset(second);
+        return;
+    }
+
+    while (current < second) {
+        current++;
+        // The slot about to be reused holds the second the longest window
+        // just dropped, so it is subtracted before it is cleared
+        for (int w = 0; w < WINDOW_COUNT; w++) {
+            const Bucket& leaving = bucketAt(current - windows[w].seconds);
+            windows[w].answered -= leaving.answered;
+            windows[w].lost -= leaving.lost;
+            windows[w].histogram.subtract(leaving.histogram);
+        }
+        resetBucket(bucketAt(current));
+    }
+}
+
+void WindowStats::addReply(double rttMs) {
+    if (current < 0) {
+        return;
+    }
+    Bucket& bucket = bucketAt(current);
+    if (bucket.answered == 0 || rttMs < bucket.minTime) bucket.minTime = rttMs;
+    if (bucket.answered == 0 || rttMs > bucket.maxTime) bucket.maxTime = rttMs;
+    bucket.answered++;
+    bucket.rttSum += rttMs;
+    bucket.histogram.record(rttMs);
+
+    for (int w = 0; w < WINDOW_COUNT; w++) {
+        windows[w].answered++;
+        windows[w].histogram.record(rttMs);
+    }
+}
+
+void WindowStats::addLoss() {
+    if (current < 0) {
+        return;
+    }
+    bucketAt(current).lost++;
+    for (int w = 0; w < WINDOW_COUNT; w++) {
+        windows[w].lost++;
+    }
+}
+
+WindowSummary WindowStats::summarize(int window) const {
+    const Window& source = windows[window];
+    WindowSummary summary;
+    summary.seconds = source.seconds;
+    summary.answered = source.answered;
+    summary.lost = source.lost;
+    summary.lossPercent = source.answered + source.lost > 0
+                              ? source.lost * 100.0 / (source.answered + source.lost) : 0.0;
+    summary.minTime = 0.0;
+    summary.avgTime = 0.0;
+    summary.maxTime = 0.0;
+    summary.p99Time = 0.0;
+    if (source.answered == 0 || current < 0) {
+        return summary;
+    }
+
+    // Extremes cannot be subtracted, and sums are taken from the buckets
+    // so a month of additions and subtractions cannot drift
+    double sum = 0.0;
+    bool first = true;
+    for (long long second = current - source.seconds + 1; second <= current; second++) {
+        if (second < 0) continue;
+        const Bucket& bucket = bucketAt(second);
+        if (bucket.answered == 0) continue;
+        if (first || bucket.minTime < summary.minTime) summary.minTime = bucket.minTime;
+        if (first || bucket.maxTime > summary.maxTime) summary.maxTime = bucket.maxTime;
+        sum += bucket.rttSum;
+        first = false;
+    }
+    summary.avgTime = sum / source.answered;
+    // Bucket midpoints can overshoot the largest sample
+    double p99 = source.histogram.percentile(99.0);
+    summary.p99Time = p99 < summary.maxTime ? p99 : summary.maxTime;
+    return summary;
+}
@@ -0,0 +1,75 @@
+#ifndef WINDOW_STATS_HPP
+#define WINDOW_STATS_HPP
+
+#include "RttHistogram.hpp"
+#include <time.h>
+
+// One sliding window as a daemon summary line reports it; times in ms,
+// 0 while the window holds no replies
+struct WindowSummary {
+    int seconds;
+    unsigned long long answered;
+    unsigned long long lost;        // Timeouts and ICMP errors
+    double lossPercent;
+    double minTime;
+    double avgTime;
+    double maxTime;
+    double p99Time;
+};
+
+// Loss and RTT over the last 10 s, 1 min and 5 min for daemon mode.
+// Outcomes land in one-second buckets of a ring that spans the longest
+// window. Each window keeps running counts and a running RttHistogram:
+// a sample is added once, on arrival, and a bucket is subtracted once, as
+// it slides out. Recording is O(1), advancing costs one histogram
+// subtraction per window per second, and a summary reads at most
+// RING_SECONDS buckets, so no cost grows with uptime. The windows count
+// the current, partial second as their newest.
+class WindowStats {
+public:
+    static const int WINDOW_COUNT = 3;
+    static const int RING_SECONDS = 300;
+
+private:
+    struct Bucket {
+        unsigned long long answered;
+        unsigned long long lost;
+        double rttSum;
+        double minTime;
+        double maxTime;
+        RttHistogram histogram;
+    };
+
+    struct Window {
+        int seconds;
+        unsigned long long answered;
+        unsigned long long lost;
+        RttHistogram histogram;
+    };
+
+    Bucket buckets[RING_SECONDS];
+    Window windows[WINDOW_COUNT];
+    long long current;      // Monotonic second being filled, -1 before the first advance()
+
+    // A window can reach back before boot, so negative seconds must wrap too
+    static int slotOf(long long second) { return (int)(((second % RING_SECONDS) + RING_SECONDS) % RING_SECONDS); }
+    Bucket& bucketAt(long long second) { return buckets[slotOf(second)]; }
+    const Bucket& bucketAt(long long second) const { return buckets[slotOf(second)]; }
+    static void resetBucket(Bucket& bucket);
+    void reset(long long second);
+
+public:
+    WindowStats();
+
+    // Moves the newest bucket to now's CLOCK_MONOTONIC second, sliding the
+    // buckets that left each window out of its totals
+    void advance(const struct timespec& now);
+
+    void addReply(double rttMs);
+    void addLoss();
+
+    int getWindowCount() const { return WINDOW_COUNT; }
+    WindowSummary summarize(int window) const;
+};
+
+#endif
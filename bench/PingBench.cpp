@@ -0,0 +1,473 @@
+// ping_bench: micro benchmarks of the per-probe hot path and end-to-end
+// throughput runs, reported as one JSON document so results can be diffed
+// between releases.
+//
+// Micro benchmarks repeat an operation until a batch takes about 50 ms and
+// report the median of several batches. The end-to-end runs drive a whole
+// PingClient in flood and stop-and-wait mode over the simulated network and
+// over loopback (the latter needs root and is marked skipped otherwise).
+
+#include "Checksum.hpp"
+#include "ICMPPacket.hpp"
+#include "ReplyView.hpp"
+#include "PingStatistics.hpp"
+#include "PingClient.hpp"
+#include "Timestamp.hpp"
+#include "Output.hpp"
+#include "utils.hpp"
+#include <sys/utsname.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Keeps the compiler from discarding a result it can see is unused
+template <class T>
+static inline void keep(const T& value) {
+    asm volatile("" : : "g"(&value) : "memory");
+}
+
+class NullBuf : public std::streambuf {
+protected:
+    int overflow(int c) { return c == EOF ? 0 : c; }
+    std::streamsize xsputn(const char*, std::streamsize length) { return length; }
+};
+
+// Discards std::cout for as long as it lives
+class MuteStdout {
+private:
+    NullBuf discard;
+    std::streambuf* original;
+
+public:
+    MuteStdout() : original(std::cout.rdbuf(&discard)) {}
+    ~MuteStdout() { std::cout.rdbuf(original); }
+};
+
+// One result line of the report; fields beyond the timing are free-form
+// numbers (throughput, RTT, counts) or a skip reason
+struct Result {
+    std::string name;
+    std::string group;
+    std::vector<std::pair<std::string, double> > metrics;
+    std::string skipped;
+
+    Result(const std::string& resultName, const std::string& resultGroup)
+        : name(resultName), group(resultGroup) {}
+
+    Result& set(const std::string& key, double value) {
+        metrics.push_back(std::make_pair(key, value));
+        return *this;
+    }
+};
+
+struct BenchOptions {
+    double batchMs;         // Target duration of one timed batch
+    int repetitions;        // Batches per micro benchmark; the median is kept
+    int floodProbes;
+    int stopWaitProbes;
+    std::string filter;
+
+    BenchOptions() : batchMs(50.0), repetitions(7), floodProbes(500000), stopWaitProbes(20000) {}
+};
+
+static BenchOptions options;
+static std::vector<Result> results;
+
+static bool selected(const std::string& name) {
+    return options.filter.empty() || name.find(options.filter) != std::string::npos;
+}
+
+// Times operation(iterations) in batches sized to options.batchMs and
+// returns the median nanoseconds per iteration
+template <class Operation>
+static double measure(Operation operation, unsigned long long& iterations) {
+    iterations = 1;
+    for (;;) {
+        struct timespec start = monotonicNow();
+        operation(iterations);
+        double ms = elapsedMs(start, monotonicNow());
+        if (ms >= options.batchMs / 4 || iterations >= (1ULL << 40)) {
+            // Scale straight to the target batch length
+            if (ms > 0.0) {
+                iterations = std::max(1ULL, (unsigned long long)(iterations * options.batchMs / ms));
+            }
+            break;
+        }
+        iterations *= 4;
+    }
+
+    std::vector<double> perIteration;
+    for (int r = 0; r < options.repetitions; r++) {
+        struct timespec start = monotonicNow();
+        operation(iterations);
+        perIteration.push_back(elapsedMs(start, monotonicNow()) * 1e6 / iterations);
+    }
+    std::sort(perIteration.begin(), perIteration.end());
+    return perIteration[perIteration.size() / 2];
+}
+
+template <class Operation>
+static Result& micro(const std::string& name, Operation operation) {
+    unsigned long long iterations = 0;
+    double ns = measure(operation, iterations);
+    results.push_back(Result(name, "micro"));
+    results.back().set("ns_per_op", ns).set("ops_per_sec", ns > 0.0 ? 1e9 / ns : 0.0)
+                   .set("iterations", (double)iterations);
+    std::cerr << "  " << name << ": " << formatDouble(ns, 2) << " ns/op" << std::endl;
+    return results.back();
+}
+
+static void benchChecksum() {
+    // ICMP header plus the payload sizes the tool precompiles, and the extremes
+    const size_t payloads[] = {0, 56, 512, 1472, 8972, 65507};
+    for (size_t p = 0; p < sizeof(payloads) / sizeof(payloads[0]); p++) {
+        size_t bytes = sizeof(struct icmphdr) + payloads[p];
+        std::string name = "checksum/" + std::to_string(payloads[p]);
+        if (!selected(name)) continue;
+
+        std::vector<unsigned char> buffer(bytes);
+        for (size_t i = 0; i < bytes; i++) buffer[i] = (unsigned char)(i * 31 + 7);
+        const unsigned char* data = &buffer[0];
+        Result& result = micro(name, [data, bytes](unsigned long long n) {
+            for (unsigned long long i = 0; i < n; i++) {
+                unsigned short sum = internetChecksum(data, bytes);
+                keep(sum);
+            }
+        });
+        double ns = result.metrics[0].second;
+        result.set("bytes", (double)bytes).set("gb_per_sec", ns > 0.0 ? bytes / ns : 0.0);
+    }
+}
+
+static void benchPacket() {
+    if (selected("packet/build")) {
+        ICMPPacket packet;
+        micro("packet/build", [&packet](unsigned long long n) {
+            for (unsigned long long i = 0; i < n; i++) {
+                packet.build((int)i);
+                keep(packet);
+            }
+        });
+    }
+
+    // prepare() is build() plus the verbose trace block the send path prints
+    if (selected("packet/prepare")) {
+        ICMPPacket packet;
+        MuteStdout mute;
+        micro("packet/prepare", [&packet](unsigned long long n) {
+            for (unsigned long long i = 0; i < n; i++) {
+                packet.prepare((int)i);
+            }
+        });
+    }
+
+    const size_t payloads[] = {56, 1472};
+    for (size_t p = 0; p < sizeof(payloads) / sizeof(payloads[0]); p++) {
+        std::string name = "packet/construct/" + std::to_string(payloads[p]);
+        if (!selected(name)) continue;
+        size_t payload = payloads[p];
+        micro(name, [payload](unsigned long long n) {
+            for (unsigned long long i = 0; i < n; i++) {
+                ICMPPacket packet(payload);
+                keep(packet);
+            }
+        });
+    }
+}
+
+// An Echo Reply as the receive path sees it: IP header, then the probe
+// turned into type 0
+static std::vector<char> makeReply(size_t payload, unsigned short id) {
+    ICMPPacket probe(payload);
+    probe.setId(id);
+    probe.build(4242);
+    std::vector<char> packet(sizeof(struct iphdr) + probe.getSize(), 0);
+    struct iphdr* ip = (struct iphdr*)&packet[0];
+    ip->version = 4;
+    ip->ihl = 5;
+    ip->ttl = 64;
+    ip->protocol = IPPROTO_ICMP;
+    memcpy(&packet[sizeof(struct iphdr)], probe.getData(), probe.getSize());
+    struct icmphdr* icmp = (struct icmphdr*)&packet[sizeof(struct iphdr)];
+    icmp->type = ICMP_ECHOREPLY;
+    icmp->checksum = 0;
+    icmp->checksum = internetChecksum(icmp, probe.getSize());
+    return packet;
+}
+
+static void benchReplyParsing() {
+    const size_t payloads[] = {56, 1472};
+    for (size_t p = 0; p < sizeof(payloads) / sizeof(payloads[0]); p++) {
+        std::string name = "reply/parse/" + std::to_string(payloads[p]);
+        if (!selected(name)) continue;
+
+        // The checks receiveReply() makes on every packet
+        std::vector<char> packet = makeReply(payloads[p], 0x2222);
+        const char* data = &packet[0];
+        int length = (int)packet.size();
+        micro(name, [data, length](unsigned long long n) {
+            for (unsigned long long i = 0; i < n; i++) {
+                ReplyView view;
+                bool ours = parseReply(data, length, view) && isEchoReplyFor(view, 0x2222);
+                keep(ours);
+                keep(view);
+            }
+        });
+    }
+}
+
+static void benchStatistics() {
+    const int SAMPLES = 1000000;
+    std::vector<double> rtts(SAMPLES);
+    unsigned int seed = 17;
+    for (int i = 0; i < SAMPLES; i++) {
+        seed = seed * 1103515245u + 12345u;
+        rtts[i] = 0.05 + (seed >> 8) % 100000 / 1000.0;
+    }
+
+    if (selected("stats/addReceived")) {
+        std::vector<double>& samples = rtts;
+        // One op is a whole run of 10^6 replies; ns_per_sample is derived
+        Result& result = micro("stats/addReceived", [&samples](unsigned long long n) {
+            for (unsigned long long r = 0; r < n; r++) {
+                PingStatistics stats(false);
+                for (size_t i = 0; i < samples.size(); i++) {
+                    stats.addTransmitted();
+                    stats.addReceived(samples[i]);
+                }
+                keep(stats);
+            }
+        });
+        result.set("samples", SAMPLES).set("ns_per_sample", result.metrics[0].second / SAMPLES);
+    }
+
+    PingStatistics filled(false);
+    for (int i = 0; i < SAMPLES; i++) {
+        filled.addTransmitted();
+        filled.addReceived(rtts[i]);
+    }
+
+    if (selected("stats/printDetailedStatistics")) {
+        MuteStdout mute;
+        micro("stats/printDetailedStatistics", [&filled](unsigned long long n) {
+            for (unsigned long long i = 0; i < n; i++) {
+                filled.printDetailedStatistics("bench");
+            }
+        }).set("samples", SAMPLES);
+    }
+
+    if (selected("stats/percentile")) {
+        micro("stats/percentile", [&filled](unsigned long long n) {
+            for (unsigned long long i = 0; i < n; i++) {
+                double p99 = filled.getPercentile(99.0);
+                keep(p99);
+            }
+        }).set("samples", SAMPLES);
+    }
+}
+
+// Runs one PingClient to completion and records probes per second and the
+// RTT it measured; baseMs is the latency the network itself adds, so the
+// remainder is the tool's own overhead
+static void macro(const std::string& name, const PingOptions& pingOptions, const char* host,
+                  int count, double baseMs) {
+    if (!selected(name)) return;
+    results.push_back(Result(name, "macro"));
+    Result& result = results.back();
+
+    double ms = 0.0;
+    PingStatistics stats(false);
+    {
+        MuteStdout mute;
+        PingClient client(host, pingOptions);
+        if (!client.initialize()) {
+            result.skipped = pingOptions.backend == BACKEND_SIMULATED ? "initialization failed"
+                                                                      : "raw sockets need root";
+        } else {
+            struct timespec start = monotonicNow();
+            client.run(count);
+            ms = elapsedMs(start, monotonicNow());
+            stats = client.getStatistics();
+        }
+    }
+    if (!result.skipped.empty()) {
+        std::cerr << "  " << name << ": skipped (" << result.skipped << ")" << std::endl;
+        return;
+    }
+
+    double probesPerSec = ms > 0.0 ? stats.getTransmitted() * 1000.0 / ms : 0.0;
+    result.set("probes", stats.getTransmitted())
+          .set("received", stats.getReceived())
+          .set("elapsed_ms", ms)
+          .set("probes_per_sec", probesPerSec)
+          .set("rtt_avg_ms", stats.getAverageTime())
+          .set("rtt_p50_ms", stats.getPercentile(50.0))
+          .set("rtt_p99_ms", stats.getPercentile(99.0))
+          .set("network_ms", baseMs)
+          .set("overhead_avg_us", (stats.getAverageTime() - baseMs) * 1000.0)
+          .set("overhead_p99_us", (stats.getPercentile(99.0) - baseMs) * 1000.0);
+    std::cerr << "  " << name << ": " << formatDouble(probesPerSec, 0) << " probes/s, overhead "
+              << formatDouble((stats.getAverageTime() - baseMs) * 1000.0, 2) << " us" << std::endl;
+}
+
+static void benchEndToEnd() {
+    const double SIM_LATENCY_MS = 0.02;
+
+    PingOptions sim;
+    sim.backend = BACKEND_SIMULATED;
+    sim.simulation.latencyMs = SIM_LATENCY_MS;
+
+    PingOptions simFlood = sim;
+    simFlood.flood = true;
+    macro("e2e/sim/flood", simFlood, "10.0.0.1", options.floodProbes, SIM_LATENCY_MS);
+
+    // The same run with -P, so the report shows what the instrumentation costs
+    PingOptions simFloodProfiled = simFlood;
+    simFloodProfiled.profileStages = true;
+    macro("e2e/sim/flood_profiled", simFloodProfiled, "10.0.0.1", options.floodProbes, SIM_LATENCY_MS);
+
+    // And with -E, publishing live statistics to shared memory throughout
+    PingOptions simFloodPublished = simFlood;
+    simFloodPublished.statsSegmentName = "ping_bench_" + std::to_string(getpid());
+    macro("e2e/sim/flood_published", simFloodPublished, "10.0.0.1", options.floodProbes, SIM_LATENCY_MS);
+
+    PingOptions simPipelined = sim;
+    simPipelined.window = 64;
+    macro("e2e/sim/pipelined", simPipelined, "10.0.0.1", options.floodProbes, SIM_LATENCY_MS);
+
+    PingOptions simSerial = sim;
+    simSerial.intervalMs = 0.0;
+    macro("e2e/sim/stop_and_wait", simSerial, "10.0.0.1", options.stopWaitProbes, SIM_LATENCY_MS);
+
+    PingOptions loopFlood;
+    loopFlood.flood = true;
+    macro("e2e/loopback/flood", loopFlood, "127.0.0.1", options.floodProbes, 0.0);
+
+    PingOptions loopSerial;
+    loopSerial.intervalMs = 0.0;
+    macro("e2e/loopback/stop_and_wait", loopSerial, "127.0.0.1", options.stopWaitProbes, 0.0);
+
+    PingOptions loopSerialProfiled = loopSerial;
+    loopSerialProfiled.profileStages = true;
+    macro("e2e/loopback/stop_and_wait_profiled", loopSerialProfiled, "127.0.0.1",
+          options.stopWaitProbes, 0.0);
+}
+
+static std::string jsonString(const std::string& text) {
+    std::string out = "\"";
+    for (size_t i = 0; i < text.size(); i++) {
+        char c = text[i];
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if ((unsigned char)c < 0x20) {
+            char escaped[8];
+            snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+            out += escaped;
+        } else {
+            out += c;
+        }
+    }
+    return out + "\"";
+}
+
+static std::string jsonNumber(double value) {
+    char text[64];
+    snprintf(text, sizeof(text), "%.6g", value);
+    return text;
+}
+
+static void writeReport(std::ostream& out) {
+    struct utsname system;
+    uname(&system);
+    time_t now = time(nullptr);
+    char stamp[32];
+    strftime(stamp, sizeof(stamp), "%Y-%m-%dT%H:%M:%SZ", gmtime(&now));
+
+    out << "{\n";
+    out << "  \"schema\": 1,\n";
+    out << "  \"timestamp\": " << jsonString(stamp) << ",\n";
+    out << "  \"host\": {\"system\": " << jsonString(system.sysname) << ", \"release\": "
+        << jsonString(system.release) << ", \"machine\": " << jsonString(system.machine)
+        << ", \"cpus\": " << sysconf(_SC_NPROCESSORS_ONLN) << "},\n";
+    out << "  \"config\": {\"batch_ms\": " << jsonNumber(options.batchMs) << ", \"repetitions\": "
+        << options.repetitions << ", \"flood_probes\": " << options.floodProbes
+        << ", \"stop_and_wait_probes\": " << options.stopWaitProbes << "},\n";
+    out << "  \"results\": [";
+    for (size_t i = 0; i < results.size(); i++) {
+        const Result& result = results[i];
+        out << (i == 0 ? "\n" : ",\n") << "    {\"name\": " << jsonString(result.name)
+            << ", \"group\": " << jsonString(result.group);
+        if (!result.skipped.empty()) {
+            out << ", \"skipped\": " << jsonString(result.skipped);
+        }
+        for (size_t m = 0; m < result.metrics.size(); m++) {
+            out << ", " << jsonString(result.metrics[m].first) << ": "
+                << jsonNumber(result.metrics[m].second);
+        }
+        out << "}";
+    }
+    out << "\n  ]\n}\n";
+}
+
+static void printUsage(const char* program) {
+    std::cerr << "Usage: " << program << " [-q] [-f filter] [-o file]" << std::endl;
+    std::cerr << std::endl;
+    std::cerr << "Options:" << std::endl;
+    std::cerr << "  -q         Quick run: shorter batches and fewer probes (smoke test)" << std::endl;
+    std::cerr << "  -f filter  Only benchmarks whose name contains <filter>" << std::endl;
+    std::cerr << "  -o file    Write the JSON report to <file> instead of stdout" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    std::string outputPath;
+    int opt;
+    while ((opt = getopt(argc, argv, "qf:o:")) != -1) {
+        switch (opt) {
+            case 'q':
+                options.batchMs = 5.0;
+                options.repetitions = 3;
+                options.floodProbes = 20000;
+                options.stopWaitProbes = 1000;
+                break;
+            case 'f':
+                options.filter = optarg;
+                break;
+            case 'o':
+                outputPath = optarg;
+                break;
+            default:
+                printUsage(argv[0]);
+                return 1;
+        }
+    }
+
+    Output::level = OUTPUT_QUIET;
+
+    std::cerr << "Running benchmarks..." << std::endl;
+    benchChecksum();
+    benchPacket();
+    benchReplyParsing();
+    benchStatistics();
+    benchEndToEnd();
+
+    if (outputPath.empty()) {
+        writeReport(std::cout);
+        return 0;
+    }
+    std::ofstream file(outputPath.c_str());
+    if (!file) {
+        std::cerr << "[ERROR] Cannot write " << outputPath << std::endl;
+        return 2;
+    }
+    writeReport(file);
+    std::cerr << "[SUCCESS] Report written to " << outputPath << std::endl;
+    return 0;
+}
@@ -1,35 +1,496 @@
 #include "PingClient.hpp"
+#include "PingEngine.hpp"
+#include "ShardedEngine.hpp"
+#include "Output.hpp"
 #include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
 #include <cstring>
 #include <cstdlib>
+#include <unistd.h>
+#include <signal.h>
+
+static void printUsage(const char* prog) {
+    std::cout << "USAGE: " << prog
+              << " [options] <hostname or IP address> [count]" << std::endl;
+    std::cout << "       " << prog
+              << " [options] <host> <host> ...   (multi-target mode)" << std::endl;
+    std::cout << "       " << prog
+              << " [options] -F <file|->          (targets from file or stdin)" << std::endl;
+    std::cout << std::endl;
+    std::cout << "OPTIONS:" << std::endl;
+    std::cout << "  -c count    Number of probes per target (default 4)" << std::endl;
+    std::cout << "  -l window   Keep up to <window> probes in flight (pipelined mode)" << std::endl;
+    std::cout << "  -i seconds  Interval between probes, fractions allowed (e.g. 0.0001)" << std::endl;
+    std::cout << "  -r rate     Cap the send rate at <rate> probes per second (token bucket)" << std::endl;
+    std::cout << "  -b burst    Token-bucket depth for -r, in probes (default: 1 ms worth)" << std::endl;
+    std::cout << "  -J percent  Add up to <percent> of the interval as random per-probe jitter" << std::endl;
+    std::cout << "  -W seconds  Time to wait for each reply, fractions allowed (default 2)" << std::endl;
+    std::cout << "  -f          Flood mode: batched sendmmsg()/recvmmsg() at the highest rate" << std::endl;
+    std::cout << "  -T backend  I/O backend for -l and -f: poll (default) or io_uring" << std::endl;
+    std::cout << "              (falls back to poll when the kernel lacks io_uring support)" << std::endl;
+    std::cout << "              or sim: an in-process simulated network (single target, no root)" << std::endl;
+    std::cout << "  -S spec     Simulated network behavior, implies -T sim; comma-separated" << std::endl;
+    std::cout << "              key=value: dist=fixed|uniform|normal|exp latency=ms jitter=ms" << std::endl;
+    std::cout << "              loss=p dup=p reorder=p hold=ms error=p code=n ttl=n seed=n" << std::endl;
+    std::cout << "  -t max_hops Traceroute mode: probe TTL 1..<max_hops> all at once, -c rounds" << std::endl;
+    std::cout << "  -M max_mtu  Path MTU mode: search sizes up to <max_mtu> bytes with DF set," << std::endl;
+    std::cout << "              then sweep RTT against packet size for -c rounds" << std::endl;
+    std::cout << "  -F file     Read targets from <file>, one per line ('-' for stdin);" << std::endl;
+    std::cout << "              a line may add its own period and timeout in ms: host [period [timeout]]" << std::endl;
+    std::cout << "  -j workers  Shard multi-target mode across <workers> threads pinned to cores" << std::endl;
+    std::cout << "  -s size     ICMP payload size in bytes, 0-65507 (default 56)" << std::endl;
+    std::cout << "  -p period   Per-target probe interval in ms for multi-target mode (default 1000)" << std::endl;
+    std::cout << "  -q          Quiet: print only the final summary (same as -O quiet)" << std::endl;
+    std::cout << "  -O level    Human output level: quiet, classic or verbose (default verbose)" << std::endl;
+    std::cout << "  -R format   Emit per-probe records on stdout: ndjson or csv" << std::endl;
+    std::cout << "              (human output moves to stderr; level defaults to quiet)" << std::endl;
+    std::cout << "  -B file     Write every probe to a binary log (<file>.N per -j worker);" << std::endl;
+    std::cout << "              summarize it later with pinglog" << std::endl;
+    std::cout << "  -P          Profile the tool itself: per-stage latency percentiles of every" << std::endl;
+    std::cout << "              probe (build, send, wakeup, receive, parse, report) after the run" << std::endl;
+    std::cout << "  -D seconds  Daemon mode: probe until SIGINT/SIGTERM (or -c probes) and print" << std::endl;
+    std::cout << "              loss and rtt over the last 10s, 1m and 5m every <seconds>" << std::endl;
+    std::cout << "  -E name     Publish live per-target statistics in shared memory segment" << std::endl;
+    std::cout << "              /<name>; read it with pingstat while the run goes on" << std::endl;
+    std::cout << std::endl;
+    std::cout << "EXAMPLES:" << std::endl;
+    std::cout << "  " << prog << " google.com" << std::endl;
+    std::cout << "  " << prog << " 127.0.0.1 4" << std::endl;
+    std::cout << "  " << prog << " 8.8.8.8 10" << std::endl;
+    std::cout << "  " << prog << " -l 32 8.8.8.8 1000" << std::endl;
+    std::cout << "  " << prog << " -f -c 100000 127.0.0.1" << std::endl;
+    std::cout << "  " << prog << " -f -i 0.0005 -c 10000 192.168.1.1" << std::endl;
+    std::cout << "  " << prog << " -T io_uring -f -c 100000 127.0.0.1" << std::endl;
+    std::cout << "  " << prog << " -S dist=normal,latency=20,jitter=5,loss=0.01 -l 64 -c 10000 -q 10.0.0.1" << std::endl;
+    std::cout << "  " << prog << " -P -f -c 100000 -q 127.0.0.1" << std::endl;
+    std::cout << "  " << prog << " -D 10 -i 0.2 -q 8.8.8.8" << std::endl;
+    std::cout << "  " << prog << " -E ping -D 60 -q 8.8.8.8" << std::endl;
+    std::cout << "  " << prog << " -t 30 -c 3 -O classic 8.8.8.8" << std::endl;
+    std::cout << "  " << prog << " -M 9000 -O classic 192.168.1.1" << std::endl;
+    std::cout << "  " << prog << " -c 3 8.8.8.8 1.1.1.1 9.9.9.9" << std::endl;
+    std::cout << "  " << prog << " -c 1 -F hosts.txt" << std::endl;
+    std::cout << "  " << prog << " -j 4 -q -c 3 -F hosts.txt" << std::endl;
+    std::cout << "  " << prog << " -O classic 8.8.8.8 10" << std::endl;
+    std::cout << "  " << prog << " -R ndjson -c 1 -F hosts.txt > results.ndjson" << std::endl;
+    std::cout << "  " << prog << " -B run.bin -q -c 100 -F hosts.txt" << std::endl;
+}
+
+static void handleStop(int) {
+    PingClient::requestStop();
+    PingEngine::requestStop();
+}
+
+// No SA_RESTART: the pending wait returns at once, the loop drains the
+// probes in flight and the final summary is still printed (and the
+// statistics segment unlinked)
+static void installStopHandler() {
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = handleStop;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGINT, &action, nullptr);
+    sigaction(SIGTERM, &action, nullptr);
+}
+
+static bool parseLevel(const std::string& text, OutputLevel& level) {
+    if (text == "quiet") level = OUTPUT_QUIET;
+    else if (text == "classic") level = OUTPUT_CLASSIC;
+    else if (text == "verbose") level = OUTPUT_VERBOSE;
+    else return false;
+    return true;
+}
+
+static bool parseFormat(const std::string& text, RecordFormat& format) {
+    if (text == "ndjson" || text == "json") format = FORMAT_NDJSON;
+    else if (text == "csv") format = FORMAT_CSV;
+    else return false;
+    return true;
+}
+
+static bool parseBackend(const std::string& text, IoBackend& backend) {
+    if (text == "poll") backend = BACKEND_POLL;
+    else if (text == "io_uring" || text == "uring") backend = BACKEND_IO_URING;
+    else if (text == "sim" || text == "simulated") backend = BACKEND_SIMULATED;
+    else return false;
+    return true;
+}
+
+static bool isNumber(const char* text) {
+    if (*text == '\0') return false;
+    for (; *text; text++) {
+        if (*text < '0' || *text > '9') return false;
+    }
+    return true;
+}
+
+struct TargetSpec {
+    std::string host;
+    double intervalMs;  // 0 = use -p
+    double timeoutMs;   // 0 = use -W
+
+    TargetSpec(const std::string& name, double interval = 0.0, double timeout = 0.0)
+        : host(name), intervalMs(interval), timeoutMs(timeout) {}
+};
+
+// One target per line as "host [period_ms [timeout_ms]]"; blank lines and
+// '#' comments are skipped
+static bool readTargets(const std::string& path, std::vector<TargetSpec>& targets) {
+    std::ifstream file;
+    std::istream* in = &std::cin;
+
+    if (path != "-") {
+        file.open(path.c_str());
+        if (!file) {
+            std::cerr << "ERROR: Cannot open target file: " << path << std::endl;
+            return false;
+        }
+        in = &file;
+    }
+
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(*in, line)) {
+        lineNumber++;
+        size_t comment = line.find('#');
+        if (comment != std::string::npos) {
+            line.erase(comment);
+        }
+
+        std::istringstream fields(line);
+        std::string host;
+        if (!(fields >> host)) {
+            continue;
+        }
+
+        TargetSpec spec(host);
+        std::string field;
+        if (fields >> field) {
+            spec.intervalMs = atof(field.c_str());
+            if (fields >> field) {
+                spec.timeoutMs = atof(field.c_str());
+            }
+        }
+        if (spec.intervalMs < 0.0 || spec.timeoutMs < 0.0 || (fields >> field)) {
+            std::cerr << "ERROR: " << path << ":" << lineNumber
+                      << ": expected \"host [period_ms [timeout_ms]]\"" << std::endl;
+            return false;
+        }
+        targets.push_back(spec);
+    }
+    return true;
+}
 
 int main(int argc, char* argv[]) {
-    if (argc < 2) {
-        std::cout << "USAGE: " << argv[0] 
-                  << " <hostname or IP address> [count]" << std::endl;
-        std::cout << std::endl;
-        std::cout << "EXAMPLES:" << std::endl;
-        std::cout << "  " << argv[0] << " google.com" << std::endl;
-        std::cout << "  " << argv[0] << " 127.0.0.1 4" << std::endl;
-        std::cout << "  " << argv[0] << " 8.8.8.8 10" << std::endl;
-        return 1;
-    }
-    
-    std::string destination = argv[1];
+    PingOptions options;
     int count = 4;
-    
-    if (argc >= 3) {
-        count = atoi(argv[2]);
+    int period = 1000;
+    int workers = 1;
+    bool countGiven = false;
+    bool multiTarget = false;
+    OutputLevel level = OUTPUT_VERBOSE;
+    bool levelGiven = false;
+    RecordFormat format = FORMAT_NONE;
+    std::vector<TargetSpec> targets;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "c:l:i:W:r:b:J:fF:p:j:s:qO:R:T:t:M:B:S:PD:E:")) != -1) {
+        switch (opt) {
+            case 'c':
+                count = atoi(optarg);
+                countGiven = true;
+                if (count <= 0) {
+                    std::cerr << "ERROR: Count must be a positive integer" << std::endl;
+                    return 1;
+                }
+                break;
+            case 'l':
+                options.window = atoi(optarg);
+                if (options.window <= 0) {
+                    std::cerr << "ERROR: Window must be a positive integer" << std::endl;
+                    return 1;
+                }
+                break;
+            case 'i':
+                options.intervalMs = atof(optarg) * 1000.0;
+                if (options.intervalMs < 0.0) {
+                    std::cerr << "ERROR: Interval must not be negative" << std::endl;
+                    return 1;
+                }
+                break;
+            case 'W':
+                options.timeoutMs = atof(optarg) * 1000.0;
+                if (options.timeoutMs <= 0.0) {
+                    std::cerr << "ERROR: Timeout must be greater than zero" << std::endl;
+                    return 1;
+                }
+                break;
+            case 'r':
+                options.rateLimit = atof(optarg);
+                if (options.rateLimit <= 0.0) {
+                    std::cerr << "ERROR: Rate must be greater than zero" << std::endl;
+                    return 1;
+                }
+                break;
+            case 'b':
+                options.burst = atof(optarg);
+                if (options.burst < 1.0) {
+                    std::cerr << "ERROR: Burst must be at least 1" << std::endl;
+                    return 1;
+                }
+                break;
+            case 'J':
+                options.jitter = atof(optarg) / 100.0;
+                if (options.jitter < 0.0 || options.jitter > 1.0) {
+                    std::cerr << "ERROR: Jitter must be between 0 and 100 percent" << std::endl;
+                    return 1;
+                }
+                break;
+            case 'f':
+                options.flood = true;
+                break;
+            case 'F':
+                multiTarget = true;
+                if (!readTargets(optarg, targets)) {
+                    return 1;
+                }
+                break;
+            case 'p':
+                period = atoi(optarg);
+                if (period <= 0) {
+                    std::cerr << "ERROR: Period must be a positive integer" << std::endl;
+                    return 1;
+                }
+                break;
+            case 'j':
+                workers = atoi(optarg);
+                if (workers <= 0) {
+                    std::cerr << "ERROR: Worker count must be a positive integer" << std::endl;
+                    return 1;
+                }
+                break;
+            case 's':
+                options.payloadSize = atoi(optarg);
+                if (!isNumber(optarg) || options.payloadSize > (int)ICMPPacket::MAX_PAYLOAD_SIZE) {
+                    std::cerr << "ERROR: Payload size must be between 0 and "
+                              << ICMPPacket::MAX_PAYLOAD_SIZE << std::endl;
+                    return 1;
+                }
+                break;
+            case 'q':
+                level = OUTPUT_QUIET;
+                levelGiven = true;
+                break;
+            case 'O':
+                if (!parseLevel(optarg, level)) {
+                    std::cerr << "ERROR: Output level must be quiet, classic or verbose" << std::endl;
+                    return 1;
+                }
+                levelGiven = true;
+                break;
+            case 't':
+                options.maxHops = atoi(optarg);
+                if (!isNumber(optarg) || options.maxHops < 1 || options.maxHops > 255) {
+                    std::cerr << "ERROR: Maximum hops must be between 1 and 255" << std::endl;
+                    return 1;
+                }
+                break;
+            case 'M':
+                options.mtuLimit = atoi(optarg);
+                if (!isNumber(optarg) || options.mtuLimit < 68 || options.mtuLimit > 65535) {
+                    std::cerr << "ERROR: MTU limit must be between 68 and 65535" << std::endl;
+                    return 1;
+                }
+                break;
+            case 'T':
+                if (!parseBackend(optarg, options.backend)) {
+                    std::cerr << "ERROR: Backend must be poll, io_uring or sim" << std::endl;
+                    return 1;
+                }
+                break;
+            case 'S': {
+                std::string error;
+                if (!parseSimulation(optarg, options.simulation, error)) {
+                    std::cerr << "ERROR: " << error << std::endl;
+                    return 1;
+                }
+                options.backend = BACKEND_SIMULATED;
+                break;
+            }
+            case 'B':
+                options.probeLogPath = optarg;
+                break;
+            case 'P':
+                options.profileStages = true;
+                break;
+            case 'D':
+                options.summaryIntervalMs = atof(optarg) * 1000.0;
+                if (options.summaryIntervalMs <= 0.0) {
+                    std::cerr << "ERROR: Summary period must be positive" << std::endl;
+                    return 1;
+                }
+                break;
+            case 'E':
+                options.statsSegmentName = optarg;
+                if (options.statsSegmentName.empty() || options.statsSegmentName == "/") {
+                    std::cerr << "ERROR: Statistics segment name must not be empty" << std::endl;
+                    return 1;
+                }
+                break;
+            case 'R':
+                if (!parseFormat(optarg, format)) {
+                    std::cerr << "ERROR: Record format must be ndjson or csv" << std::endl;
+                    return 1;
+                }
+                break;
+            default:
+                printUsage(argv[0]);
+                return 1;
+        }
+    }
+
+    std::vector<std::string> positional(argv + optind, argv + argc);
+
+    // Keep the original "<host> [count]" form working
+    if (!countGiven && !multiTarget && positional.size() == 2 && isNumber(positional[1].c_str())) {
+        count = atoi(positional[1].c_str());
+        countGiven = true;
+        positional.pop_back();
         if (count <= 0) {
             std::cerr << "ERROR: Count must be a positive integer" << std::endl;
             return 1;
         }
     }
-    PingClient ping(destination, 2);
-    
+
+    for (size_t i = 0; i < positional.size(); i++) {
+        targets.push_back(TargetSpec(positional[i]));
+    }
+
+    if (targets.empty()) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    bool pathMode = options.maxHops > 0 || options.mtuLimit > 0;
+    if (pathMode && (multiTarget || targets.size() > 1 || options.flood || options.window > 1)) {
+        std::cerr << "ERROR: -t and -M take a single target and cannot be combined with -f or -l"
+                  << std::endl;
+        return 1;
+    }
+    if (options.maxHops > 0 && options.mtuLimit > 0) {
+        std::cerr << "ERROR: -t and -M cannot be combined" << std::endl;
+        return 1;
+    }
+    if (options.backend == BACKEND_SIMULATED && (pathMode || multiTarget || targets.size() > 1)) {
+        std::cerr << "ERROR: the simulated network serves the single-target echo modes only" << std::endl;
+        return 1;
+    }
+    if (multiTarget || targets.size() > 1) {
+        // The engine has its own per-target grid and a single epoll loop, so
+        // the single-target pacing and I/O options would be silently ignored
+        if (options.flood || options.window > 1) {
+            std::cerr << "ERROR: -f and -l run the single-target echo modes only" << std::endl;
+            return 1;
+        }
+        if (options.intervalMs >= 0.0) {
+            std::cerr << "ERROR: -i sets the single-target interval; use -p or per-target "
+                         "periods in -F" << std::endl;
+            return 1;
+        }
+        if (options.jitter > 0.0) {
+            std::cerr << "ERROR: -J applies to the single-target echo modes only" << std::endl;
+            return 1;
+        }
+        if (options.backend == BACKEND_IO_URING) {
+            std::cerr << "ERROR: -T io_uring serves the single-target echo modes only" << std::endl;
+            return 1;
+        }
+    }
+    if (options.summaryIntervalMs > 0.0 && (pathMode || multiTarget || targets.size() > 1)) {
+        std::cerr << "ERROR: -D runs the single-target echo modes only" << std::endl;
+        return 1;
+    }
+    if (options.profileStages && (pathMode || multiTarget || targets.size() > 1)) {
+        std::cerr << "ERROR: -P profiles the single-target echo modes only" << std::endl;
+        return 1;
+    }
+    if (pathMode && !options.probeLogPath.empty()) {
+        std::cerr << "ERROR: -B logs echo probes and cannot be combined with -t or -M" << std::endl;
+        return 1;
+    }
+    if (pathMode && !options.statsSegmentName.empty()) {
+        std::cerr << "ERROR: -E publishes echo statistics and cannot be combined with -t or -M"
+                  << std::endl;
+        return 1;
+    }
+
+    // Records are meant for pipelines; keep the human side out of the way unless asked
+    if (format != FORMAT_NONE && !levelGiven) {
+        level = OUTPUT_QUIET;
+    }
+    Output::setup(level, format);
+
+    if ((multiTarget || targets.size() > 1) && workers > 1) {
+        ShardedEngine engine(workers, options.timeoutMs, period, options.payloadSize);
+        engine.setRateLimit(options.rateLimit, options.burst);
+        if (!options.probeLogPath.empty()) {
+            engine.setProbeLog(options.probeLogPath);
+        }
+        if (!options.statsSegmentName.empty()) {
+            engine.setStatsSegment(options.statsSegmentName);
+        }
+        for (size_t i = 0; i < targets.size(); i++) {
+            engine.addTarget(targets[i].host, targets[i].intervalMs, targets[i].timeoutMs);
+        }
+
+        if (!engine.initialize()) {
+            return 1;
+        }
+        if (!options.statsSegmentName.empty()) {
+            installStopHandler();
+        }
+        engine.run(count);
+        engine.printSummary();
+        return 0;
+    }
+
+    if (multiTarget || targets.size() > 1) {
+        PingEngine engine(options.timeoutMs, period, options.payloadSize);
+        engine.setRateLimit(options.rateLimit, options.burst);
+        if (!options.probeLogPath.empty()) {
+            engine.setProbeLog(options.probeLogPath);
+        }
+        if (!options.statsSegmentName.empty()) {
+            engine.setStatsSegment(options.statsSegmentName);
+        }
+        for (size_t i = 0; i < targets.size(); i++) {
+            engine.addTarget(targets[i].host, targets[i].intervalMs, targets[i].timeoutMs);
+        }
+
+        if (!engine.initialize()) {
+            return 1;
+        }
+        if (!options.statsSegmentName.empty()) {
+            installStopHandler();
+        }
+        engine.run(count);
+        engine.printSummary();
+        return 0;
+    }
+
+    PingClient ping(targets[0].host, options);
+
     if (!ping.initialize()) {
         return 1;
     }
+    if (options.summaryIntervalMs > 0.0 || !options.statsSegmentName.empty()) {
+        installStopHandler();
+    }
+    if (options.summaryIntervalMs > 0.0 && !countGiven) {
+        count = 0;
+    }
     ping.run(count);
     return 0;
 }
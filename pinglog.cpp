@@ -0,0 +1,145 @@
+// pinglog: summarizes binary probe logs written by "ping -B"
+//
+// Each file is mapped read-only and scanned a column block at a time;
+// targets with the same name in several files (one per -j worker, or
+// successive runs) are merged into one set of statistics.
+
+#include "ProbeLog.hpp"
+#include "PingStatistics.hpp"
+#include "Timestamp.hpp"
+#include "utils.hpp"
+#include <unistd.h>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+static void printUsage(const char* program) {
+    std::cout << "Usage: " << program << " [-q] <log> [log ...]" << std::endl;
+    std::cout << std::endl;
+    std::cout << "Options:" << std::endl;
+    std::cout << "  -q    Totals only, no per-target lines" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    bool quiet = false;
+    int opt;
+    while ((opt = getopt(argc, argv, "q")) != -1) {
+        switch (opt) {
+            case 'q':
+                quiet = true;
+                break;
+            default:
+                printUsage(argv[0]);
+                return 1;
+        }
+    }
+    if (optind >= argc) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    std::vector<std::unique_ptr<ProbeLogReader> > logs;
+    for (int i = optind; i < argc; i++) {
+        logs.push_back(std::unique_ptr<ProbeLogReader>(new ProbeLogReader()));
+        if (!logs.back()->open(argv[i])) {
+            return 2;
+        }
+    }
+
+    std::vector<std::string> names;
+    std::vector<PingStatistics> stats;
+    std::unordered_map<std::string, size_t> byName;
+    PingStatistics total(false);
+    uint64_t records = 0;
+    int64_t firstSend = 0;
+    int64_t lastSend = 0;
+
+    struct timespec scanStart = monotonicNow();
+
+    for (size_t f = 0; f < logs.size(); f++) {
+        const ProbeLogReader& log = *logs[f];
+
+        // File-local target numbers to merged statistics
+        std::vector<size_t> index(log.getTargets().size());
+        for (size_t i = 0; i < index.size(); i++) {
+            const std::string& name = log.getTargets()[i];
+            std::unordered_map<std::string, size_t>::iterator it = byName.find(name);
+            if (it == byName.end()) {
+                it = byName.insert(std::make_pair(name, names.size())).first;
+                names.push_back(name);
+                stats.push_back(PingStatistics(false));
+            }
+            index[i] = it->second;
+        }
+
+        for (size_t b = 0; b < log.getBlockCount(); b++) {
+            ProbeBlock block = log.getBlock(b);
+            for (size_t i = 0; i < block.count; i++) {
+                if (block.target[i] >= index.size()) {
+                    continue; // Damaged record
+                }
+                PingStatistics& target = stats[index[block.target[i]]];
+                target.addTransmitted();
+                total.addTransmitted();
+
+                int status = block.status[i];
+                if (status == PROBE_REPLY) {
+                    target.addReceived(block.rttMs[i]);
+                    total.addReceived(block.rttMs[i]);
+                } else if (status >= PROBE_FAILURE && status < PROBE_FAILURE + FAILURE_KIND_COUNT) {
+                    target.addFailure((FailureKind)(status - PROBE_FAILURE));
+                    total.addFailure((FailureKind)(status - PROBE_FAILURE));
+                } else {
+                    target.addError();
+                    total.addError();
+                }
+
+                int64_t sent = block.sendNs[i];
+                if (records == 0 || sent < firstSend) {
+                    firstSend = sent;
+                }
+                if (records == 0 || sent > lastSend) {
+                    lastSend = sent;
+                }
+                records++;
+            }
+        }
+    }
+
+    double scanMs = elapsedMs(scanStart, monotonicNow());
+
+    printHeader("PROBE LOG SUMMARY");
+    printInfo("Log Files", (int)logs.size());
+    printInfo("Targets", (int)names.size());
+    printInfo("Probe Records", std::to_string(records));
+    if (records > 0) {
+        struct timespec first;
+        first.tv_sec = (time_t)(firstSend / 1000000000LL);
+        first.tv_nsec = (long)(firstSend % 1000000000LL);
+        printInfo("First Probe Sent", formatTimespec(first));
+        printInfo("Send Time Span (s)", (double)(lastSend - firstSend) / 1e9, 25, 3);
+    }
+    printInfo("Scan Time (ms)", scanMs, 25, 3);
+
+    if (!quiet && !names.empty()) {
+        printSeparator('-', 80);
+        for (size_t i = 0; i < names.size(); i++) {
+            stats[i].printSummaryLine(names[i]);
+        }
+    }
+
+    printSeparator('-', 80);
+    total.printSummaryLine("all targets");
+    if (total.getReceived() > 0) {
+        printInfo("50th Percentile (p50)", total.getPercentile(50.0), 25, 3);
+        printInfo("90th Percentile (p90)", total.getPercentile(90.0), 25, 3);
+        printInfo("99th Percentile (p99)", total.getPercentile(99.0), 25, 3);
+        printInfo("99.9th Percentile", total.getPercentile(99.9), 25, 3);
+        printInfo("Standard Deviation", total.calculateStdDev(), 25, 3);
+    }
+    printSeparator('=', 80);
+    return 0;
+}
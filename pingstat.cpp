@@ -0,0 +1,252 @@
+// pingstat: reads the live statistics segment of a running "ping -E"
+//
+// The segment is mapped read-only and every slot is copied under its
+// seqlock, so scraping never blocks or signals the pinger. Prints a table,
+// or the Prometheus text exposition format with -p (for a textfile
+// collector or a small localhost endpoint), once or every -w seconds.
+
+#include "StatsSegment.hpp"
+#include "utils.hpp"
+#include <arpa/inet.h>
+#include <time.h>
+#include <unistd.h>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+static const double QUANTILES[] = {0.5, 0.9, 0.99, 0.999};
+static const int QUANTILE_COUNT = 4;
+
+static void printUsage(const char* program) {
+    std::cout << "Usage: " << program << " [-p] [-w seconds] <segment>" << std::endl;
+    std::cout << std::endl;
+    std::cout << "Options:" << std::endl;
+    std::cout << "  -p          Prometheus text exposition format" << std::endl;
+    std::cout << "  -w seconds  Repeat every <seconds> until the pinger exits" << std::endl;
+}
+
+static std::string addressText(uint32_t address) {
+    if (address == 0) {
+        return "-";
+    }
+    char text[INET_ADDRSTRLEN];
+    inet_ntop(AF_INET, &address, text, sizeof(text));
+    return text;
+}
+
+// Histogram bucket midpoints can overshoot the extremes; the exact min/max bound them
+static double quantileMs(const StatsSnapshot& target, double q) {
+    if (target.received == 0) {
+        return 0.0;
+    }
+    double value = target.histogram.percentile(q * 100.0);
+    if (value < target.minMs) value = target.minMs;
+    if (value > target.maxMs) value = target.maxMs;
+    return value;
+}
+
+// Label values escape backslash, double quote and newline
+static std::string labelValue(const std::string& text) {
+    std::string escaped;
+    for (size_t i = 0; i < text.size(); i++) {
+        if (text[i] == '\\' || text[i] == '"') {
+            escaped += '\\';
+            escaped += text[i];
+        } else if (text[i] == '\n') {
+            escaped += "\\n";
+        } else {
+            escaped += text[i];
+        }
+    }
+    return escaped;
+}
+
+static std::string localTime(int64_t ns) {
+    time_t seconds = (time_t)(ns / 1000000000LL);
+    struct tm local;
+    char text[32];
+    if (localtime_r(&seconds, &local) == nullptr ||
+        strftime(text, sizeof(text), "%Y-%m-%d %H:%M:%S", &local) == 0) {
+        return "-";
+    }
+    return text;
+}
+
+static void printTable(const StatsSegmentReader& segment, const std::string& name) {
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    uint64_t nowNs = (uint64_t)now.tv_sec * 1000000000ULL + now.tv_nsec;
+
+    printHeader("LIVE PING STATISTICS");
+    printInfo("Segment", StatsSegment::normalizeName(name));
+    printInfo("Writer Process", std::to_string(segment.getWriterPid()) +
+                                    (segment.isWriterAlive() ? " (running)" : " (exited)"));
+    printInfo("Started", localTime(segment.getStartNs()));
+    printSeparator('-', 80);
+
+    char line[200];
+    snprintf(line, sizeof(line), "%-20s %-15s %8s %8s %6s %23s %6s\n", "target", "address",
+             "sent", "recv", "loss", "min/avg/max/p99 ms", "age s");
+    std::cout << line;
+
+    for (size_t i = 0; i < segment.getSlotCount(); i++) {
+        StatsSnapshot target;
+        if (!segment.snapshot(i, target)) {
+            std::cout << target.name << ": no consistent snapshot (writer stopped mid-update)"
+                      << std::endl;
+            continue;
+        }
+        double loss = target.transmitted > 0
+                          ? (double)(target.transmitted - target.received) * 100.0 / target.transmitted
+                          : 0.0;
+        char rtt[64];
+        if (target.received > 0) {
+            snprintf(rtt, sizeof(rtt), "%.2f/%.2f/%.2f/%.2f", target.minMs, target.meanMs,
+                     target.maxMs, quantileMs(target, 0.99));
+        } else {
+            snprintf(rtt, sizeof(rtt), "-");
+        }
+        char age[16];
+        if (target.updatedNs > 0 && nowNs >= target.updatedNs) {
+            snprintf(age, sizeof(age), "%.1f", (nowNs - target.updatedNs) / 1e9);
+        } else {
+            snprintf(age, sizeof(age), "-");
+        }
+        snprintf(line, sizeof(line), "%-20s %-15s %8llu %8llu %5.1f%% %23s %6s\n",
+                 target.name.c_str(), addressText(target.address).c_str(),
+                 (unsigned long long)target.transmitted, (unsigned long long)target.received,
+                 loss, rtt, age);
+        std::cout << line;
+    }
+    printSeparator('=', 80);
+}
+
+static void printMetric(const char* name, const char* type, const char* help) {
+    std::cout << "# HELP " << name << " " << help << "\n";
+    std::cout << "# TYPE " << name << " " << type << "\n";
+}
+
+static void printPrometheus(const StatsSegmentReader& segment) {
+    size_t count = segment.getSlotCount();
+    std::vector<StatsSnapshot> targets(count);
+    std::vector<bool> valid(count);
+    std::vector<std::string> labels(count);
+    for (size_t i = 0; i < count; i++) {
+        valid[i] = segment.snapshot(i, targets[i]);
+        labels[i] = "target=\"" + labelValue(targets[i].name) + "\",address=\"" +
+                    addressText(targets[i].address) + "\"";
+    }
+
+    printMetric("ping_writer_up", "gauge", "1 while the pinger that owns the segment is running.");
+    std::cout << "ping_writer_up " << (segment.isWriterAlive() ? 1 : 0) << "\n";
+
+    printMetric("ping_probes_sent_total", "counter", "Echo requests sent.");
+    for (size_t i = 0; i < count; i++) {
+        if (valid[i]) std::cout << "ping_probes_sent_total{" << labels[i] << "} " << targets[i].transmitted << "\n";
+    }
+    printMetric("ping_probes_received_total", "counter", "Echo replies received in time.");
+    for (size_t i = 0; i < count; i++) {
+        if (valid[i]) std::cout << "ping_probes_received_total{" << labels[i] << "} " << targets[i].received << "\n";
+    }
+    printMetric("ping_probes_lost_total", "counter", "Probes that timed out or drew an ICMP error.");
+    for (size_t i = 0; i < count; i++) {
+        if (valid[i]) std::cout << "ping_probes_lost_total{" << labels[i] << "} " << targets[i].errors << "\n";
+    }
+    printMetric("ping_probe_failures_total", "counter", "Probes ended early by an ICMP error, by kind.");
+    for (size_t i = 0; i < count; i++) {
+        for (int k = 0; valid[i] && k < FAILURE_KIND_COUNT; k++) {
+            std::cout << "ping_probe_failures_total{" << labels[i] << ",kind=\""
+                      << getFailureName((FailureKind)k) << "\"} " << targets[i].failures[k] << "\n";
+        }
+    }
+
+    printMetric("ping_rtt_min_seconds", "gauge", "Smallest round trip time so far.");
+    for (size_t i = 0; i < count; i++) {
+        if (valid[i] && targets[i].received > 0) {
+            std::cout << "ping_rtt_min_seconds{" << labels[i] << "} " << targets[i].minMs / 1000.0 << "\n";
+        }
+    }
+    printMetric("ping_rtt_max_seconds", "gauge", "Largest round trip time so far.");
+    for (size_t i = 0; i < count; i++) {
+        if (valid[i] && targets[i].received > 0) {
+            std::cout << "ping_rtt_max_seconds{" << labels[i] << "} " << targets[i].maxMs / 1000.0 << "\n";
+        }
+    }
+    printMetric("ping_rtt_stddev_seconds", "gauge", "Standard deviation of the round trip time.");
+    for (size_t i = 0; i < count; i++) {
+        if (valid[i] && targets[i].received > 0) {
+            std::cout << "ping_rtt_stddev_seconds{" << labels[i] << "} " << targets[i].stddevMs / 1000.0 << "\n";
+        }
+    }
+    printMetric("ping_rtt_seconds", "summary", "Round trip time of answered probes.");
+    for (size_t i = 0; i < count; i++) {
+        if (!valid[i]) continue;
+        if (targets[i].received > 0) {
+            for (int q = 0; q < QUANTILE_COUNT; q++) {
+                std::cout << "ping_rtt_seconds{" << labels[i] << ",quantile=\"" << QUANTILES[q] << "\"} "
+                          << quantileMs(targets[i], QUANTILES[q]) / 1000.0 << "\n";
+            }
+        }
+        std::cout << "ping_rtt_seconds_sum{" << labels[i] << "} "
+                  << targets[i].meanMs * targets[i].received / 1000.0 << "\n";
+        std::cout << "ping_rtt_seconds_count{" << labels[i] << "} " << targets[i].received << "\n";
+    }
+    printMetric("ping_last_update_timestamp_seconds", "gauge", "When the pinger last published the target.");
+    for (size_t i = 0; i < count; i++) {
+        if (valid[i] && targets[i].updatedNs > 0) {
+            std::cout << "ping_last_update_timestamp_seconds{" << labels[i] << "} "
+                      << targets[i].updatedNs / 1e9 << "\n";
+        }
+    }
+    std::cout.flush();
+}
+
+int main(int argc, char* argv[]) {
+    bool prometheus = false;
+    double watchSeconds = 0.0;
+    int opt;
+    while ((opt = getopt(argc, argv, "pw:")) != -1) {
+        switch (opt) {
+            case 'p':
+                prometheus = true;
+                break;
+            case 'w':
+                watchSeconds = atof(optarg);
+                if (watchSeconds <= 0.0) {
+                    std::cerr << "ERROR: Watch period must be positive" << std::endl;
+                    return 1;
+                }
+                break;
+            default:
+                printUsage(argv[0]);
+                return 1;
+        }
+    }
+    if (optind != argc - 1) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    StatsSegmentReader segment;
+    if (!segment.open(argv[optind])) {
+        return 2;
+    }
+    // Full precision for the floating-point samples
+    std::cout.precision(9);
+
+    for (;;) {
+        if (prometheus) {
+            printPrometheus(segment);
+        } else {
+            printTable(segment, argv[optind]);
+        }
+        // The mapping keeps the final values readable, but they no longer change
+        if (watchSeconds <= 0.0 || !segment.isWriterAlive()) {
+            return 0;
+        }
+        sleepMs(watchSeconds * 1000.0);
+        std::cout << std::endl;
+    }
+}
@@ -0,0 +1,67 @@
+#include "AllocationCounter.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+
+#if defined(__SANITIZE_ADDRESS__) || defined(__SANITIZE_THREAD__)
+#define PING_COUNT_ALLOCATIONS 0
+#elif defined(__has_feature)
+#if __has_feature(address_sanitizer) || __has_feature(thread_sanitizer) || __has_feature(memory_sanitizer)
+#define PING_COUNT_ALLOCATIONS 0
+#endif
+#endif
+
+#if !defined(PING_COUNT_ALLOCATIONS) && defined(__GLIBC__)
+#define PING_COUNT_ALLOCATIONS 1
+#endif
+
+#ifndef PING_COUNT_ALLOCATIONS
+#define PING_COUNT_ALLOCATIONS 0
+#endif
+
+static std::atomic<unsigned long long> allocationCount(0);
+
+#if PING_COUNT_ALLOCATIONS
+
+// glibc exports its allocator under these names as well, so definitions in
+// the executable can take over malloc() and still reach the real one.
+// __THROW repeats the exception specification of <stdlib.h>.
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* pointer, size_t size);
+void __libc_free(void* pointer);
+
+void* malloc(size_t size) __THROW {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size) __THROW {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    return __libc_calloc(count, size);
+}
+
+void* realloc(void* pointer, size_t size) __THROW {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    return __libc_realloc(pointer, size);
+}
+
+void free(void* pointer) __THROW {
+    __libc_free(pointer);
+}
+}
+
+#endif
+
+namespace allocations {
+
+bool available() {
+    return PING_COUNT_ALLOCATIONS != 0;
+}
+
+unsigned long long count() {
+    return allocationCount.load(std::memory_order_relaxed);
+}
+
+}  // namespace allocations
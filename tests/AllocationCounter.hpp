@@ -0,0 +1,15 @@
+#ifndef ALLOCATION_COUNTER_HPP
+#define ALLOCATION_COUNTER_HPP
+
+// Counts every malloc(), calloc() and realloc() in the process, including
+// those behind operator new and inside libc. The hooks interpose on glibc's
+// allocator, so they are compiled out under sanitizers (which bring their
+// own) and on other C libraries; available() then reports false.
+namespace allocations {
+
+bool available();
+unsigned long long count();
+
+}  // namespace allocations
+
+#endif
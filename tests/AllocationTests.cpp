@@ -0,0 +1,132 @@
+#include "TestHarness.hpp"
+#include "AllocationCounter.hpp"
+#include "PingClient.hpp"
+#include "Output.hpp"
+#include <fcntl.h>
+#include <unistd.h>
+
+// The probe loops must not allocate per probe: whatever a run allocates
+// for setup, buffers and the final report, doubling the probe count may
+// not add to it. Runs go through the simulated network, so no root and
+// no network are needed and the loops see replies, timeouts and errors.
+
+class NullBuf : public std::streambuf {
+protected:
+    int overflow(int c) { return c == EOF ? 0 : c; }
+    std::streamsize xsputn(const char*, std::streamsize length) { return length; }
+};
+
+// Runs with stdout discarded, so classic output is formatted but not shown
+static unsigned long long allocationsForRun(const PingOptions& options, int count) {
+    NullBuf discard;
+    std::streambuf* original = std::cout.rdbuf(&discard);
+    unsigned long long used = 0;
+    {
+        PingClient client("10.0.0.1", options);
+        if (client.initialize()) {
+            unsigned long long before = allocations::count();
+            client.run(count);
+            used = allocations::count() - before;
+        }
+    }
+    std::cout.rdbuf(original);
+    return used;
+}
+
+// Allocations at N and 2N probes; a warm-up run first settles the lazily
+// built process-wide state (locale facets, thread-local record buffer).
+// slack covers buffers that grow geometrically with timing, not probes.
+static void checkConstantAllocations(const PingOptions& options, int count,
+                                     unsigned long long slack = 0) {
+    allocationsForRun(options, count);
+    unsigned long long once = allocationsForRun(options, count);
+    unsigned long long twice = allocationsForRun(options, 2 * count);
+    CHECK(once > 0);
+    if (slack == 0) {
+        CHECK_EQ(once, twice);
+    } else {
+        CHECK_NEAR(once, twice, slack);
+    }
+}
+
+static PingOptions simulatedOptions() {
+    PingOptions options;
+    options.backend = BACKEND_SIMULATED;
+    options.timeoutMs = 5.0;
+    options.simulation.latencyMs = 0.01;
+    options.simulation.lossRate = 0.01;
+    options.simulation.duplicateRate = 0.01;
+    options.simulation.reorderRate = 0.01;
+    options.simulation.reorderDelayMs = 0.05;
+    options.simulation.errorRate = 0.01;
+    return options;
+}
+
+TEST(Allocation, FloodQuiet) {
+    if (!allocations::available()) return;
+    PingOptions options = simulatedOptions();
+    options.flood = true;
+    checkConstantAllocations(options, 20000);
+}
+
+TEST(Allocation, PipelinedQuiet) {
+    if (!allocations::available()) return;
+    PingOptions options = simulatedOptions();
+    options.window = 64;
+    checkConstantAllocations(options, 20000);
+}
+
+TEST(Allocation, StopAndWaitClassic) {
+    if (!allocations::available()) return;
+    PingOptions options = simulatedOptions();
+    options.intervalMs = 0.0;
+
+    Output::level = OUTPUT_CLASSIC;
+    checkConstantAllocations(options, 2000);
+    Output::level = OUTPUT_QUIET;
+}
+
+TEST(Allocation, FloodProfiled) {
+    if (!allocations::available()) return;
+    PingOptions options = simulatedOptions();
+    options.flood = true;
+    options.profileStages = true;
+    checkConstantAllocations(options, 20000);
+}
+
+TEST(Allocation, PipelinedDaemon) {
+    if (!allocations::available()) return;
+    PingOptions options = simulatedOptions();
+    options.window = 64;
+    options.summaryIntervalMs = 1.0;
+    // Each window bucket allocates its histogram on its first reply, so a
+    // run that crosses one more second boundary allocates one more
+    checkConstantAllocations(options, 20000, 2);
+}
+
+TEST(Allocation, FloodPublished) {
+    if (!allocations::available()) return;
+    PingOptions options = simulatedOptions();
+    options.flood = true;
+    options.statsSegmentName = "ping_tests_alloc_" + std::to_string(getpid());
+    checkConstantAllocations(options, 20000);
+}
+
+TEST(Allocation, FloodNdjsonRecords) {
+    if (!allocations::available()) return;
+    PingOptions options = simulatedOptions();
+    options.flood = true;
+
+    int fd = open("/dev/null", O_WRONLY);
+    CHECK(fd >= 0);
+    {
+        AsyncWriter writer(fd);
+        Output::records.open(FORMAT_NDJSON, &writer);
+        // The writer's two swapped buffers each grow to the largest burst
+        // its thread has been handed, which depends on scheduling
+        checkConstantAllocations(options, 20000, 16);
+        Output::records.flush();
+        Output::records.open(FORMAT_NONE, nullptr);
+    }
+    close(fd);
+}
@@ -0,0 +1,74 @@
+#include "TestHarness.hpp"
+#include "Checksum.hpp"
+#include <cstring>
+#include <vector>
+
+// RFC 1071 word by word, in memory byte order like internetChecksum()
+static unsigned short referenceChecksum(const unsigned char* data, size_t length) {
+    unsigned long long sum = 0;
+    size_t i = 0;
+    for (; i + 1 < length; i += 2) {
+        unsigned short word;
+        memcpy(&word, data + i, 2);
+        sum += word;
+    }
+    if (i < length) {
+        unsigned short word = 0;
+        memcpy(&word, data + i, 1);
+        sum += word;
+    }
+    while (sum >> 16) {
+        sum = (sum & 0xFFFF) + (sum >> 16);
+    }
+    return (unsigned short)~sum;
+}
+
+static std::vector<unsigned char> pattern(size_t length, unsigned int seed) {
+    std::vector<unsigned char> bytes(length);
+    for (size_t i = 0; i < length; i++) {
+        seed = seed * 1103515245u + 12345u;
+        bytes[i] = (unsigned char)(seed >> 16);
+    }
+    return bytes;
+}
+
+TEST(Checksum, MatchesReferenceAtEveryLengthAndAlignment) {
+    std::vector<unsigned char> bytes = pattern(4096 + 64, 7);
+    // Short lengths exercise the scalar tail; long ones the vector kernels
+    for (size_t length = 0; length <= 600; length++) {
+        for (size_t offset = 0; offset < 4; offset++) {
+            CHECK_EQ(referenceChecksum(&bytes[offset], length), internetChecksum(&bytes[offset], length));
+        }
+    }
+    for (size_t length = 1000; length <= 4096; length += 331) {
+        CHECK_EQ(referenceChecksum(&bytes[1], length), internetChecksum(&bytes[1], length));
+    }
+}
+
+TEST(Checksum, AllOnesDoesNotOverflow) {
+    std::vector<unsigned char> bytes(65535, 0xFF);
+    CHECK_EQ(referenceChecksum(&bytes[0], bytes.size()), internetChecksum(&bytes[0], bytes.size()));
+}
+
+TEST(Checksum, ChecksummedDataVerifiesToZero) {
+    std::vector<unsigned char> bytes = pattern(64, 3);
+    bytes[2] = 0;
+    bytes[3] = 0;
+    unsigned short checksum = internetChecksum(&bytes[0], bytes.size());
+    memcpy(&bytes[2], &checksum, 2);
+    CHECK_EQ(0, internetChecksum(&bytes[0], bytes.size()));
+}
+
+TEST(Checksum, IncrementalUpdateMatchesRecompute) {
+    std::vector<unsigned char> bytes = pattern(128, 11);
+    unsigned short checksum = internetChecksum(&bytes[0], bytes.size());
+
+    for (unsigned int value = 0; value < 70000; value += 997) {
+        unsigned short oldWord;
+        unsigned short newWord = (unsigned short)value;
+        memcpy(&oldWord, &bytes[40], 2);
+        memcpy(&bytes[40], &newWord, 2);
+        checksum = checksumUpdate(checksum, oldWord, newWord);
+        CHECK_EQ(internetChecksum(&bytes[0], bytes.size()), checksum);
+    }
+}
@@ -0,0 +1,66 @@
+#include "TestHarness.hpp"
+#include "ICMPPacket.hpp"
+#include "Checksum.hpp"
+
+static const struct icmphdr* headerOf(const ICMPPacket& packet) {
+    return (const struct icmphdr*)packet.getData();
+}
+
+static bool checksumValid(const ICMPPacket& packet) {
+    return internetChecksum(packet.getData(), packet.getSize()) == 0;
+}
+
+TEST(ICMPPacket, EchoRequestLayout) {
+    ICMPPacket packet;
+    CHECK_EQ(sizeof(struct icmphdr) + ICMPPacket::DEFAULT_PAYLOAD_SIZE, packet.getSize());
+    CHECK_EQ(ICMPPacket::DEFAULT_PAYLOAD_SIZE, packet.getPayloadSize());
+    CHECK_EQ(ICMP_ECHO, headerOf(packet)->type);
+    CHECK_EQ(0, headerOf(packet)->code);
+    CHECK_EQ((unsigned short)getpid(), headerOf(packet)->un.echo.id);
+    CHECK(checksumValid(packet));
+}
+
+TEST(ICMPPacket, PrecompiledImagesMatchRuntimeFill) {
+    const size_t sizes[] = {ICMPPacket::DEFAULT_PAYLOAD_SIZE, ICMPPacket::ETHERNET_PAYLOAD_SIZE,
+                            ICMPPacket::JUMBO_PAYLOAD_SIZE};
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        CHECK(ICMPPacket::isPrecompiled(sizes[s]));
+        ICMPPacket image(sizes[s]);
+        // One byte more takes the runtime path; the shared prefix must agree
+        ICMPPacket filled(sizes[s] + 1);
+        const unsigned char* a = (const unsigned char*)image.getData();
+        const unsigned char* b = (const unsigned char*)filled.getData();
+        CHECK(memcmp(a + sizeof(struct icmphdr), b + sizeof(struct icmphdr), sizes[s]) == 0);
+        CHECK(checksumValid(image));
+        CHECK(checksumValid(filled));
+    }
+    CHECK(!ICMPPacket::isPrecompiled(100));
+}
+
+TEST(ICMPPacket, BuildKeepsChecksumValid) {
+    const size_t sizes[] = {0, 1, 56, 57, 1472, 8972, 65507};
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        ICMPPacket packet(sizes[s]);
+        for (int seq = 0; seq < 70000; seq += 4093) {
+            packet.build(seq);
+            CHECK_EQ((unsigned short)seq, headerOf(packet)->un.echo.sequence);
+            CHECK(checksumValid(packet));
+        }
+    }
+}
+
+TEST(ICMPPacket, SetIdKeepsChecksumValid) {
+    ICMPPacket packet(200);
+    packet.build(12);
+    packet.setId(0xBEEF);
+    CHECK_EQ(0xBEEF, headerOf(packet)->un.echo.id);
+    CHECK(checksumValid(packet));
+    packet.build(13);
+    CHECK(checksumValid(packet));
+}
+
+TEST(ICMPPacket, OversizedPayloadIsClamped) {
+    ICMPPacket packet(ICMPPacket::MAX_PAYLOAD_SIZE + 100);
+    CHECK_EQ(ICMPPacket::MAX_PAYLOAD_SIZE, packet.getPayloadSize());
+    CHECK(checksumValid(packet));
+}
@@ -0,0 +1,119 @@
+#include "TestHarness.hpp"
+#include "PingStatistics.hpp"
+#include "RttHistogram.hpp"
+#include <algorithm>
+#include <vector>
+
+TEST(PingStatistics, EmptyRun) {
+    PingStatistics stats(false);
+    CHECK_EQ(0, stats.getTransmitted());
+    CHECK_EQ(0, stats.getReceived());
+    CHECK_EQ(0, stats.getPacketLoss());
+    CHECK_EQ(0.0, stats.getAverageTime());
+    CHECK_EQ(0.0, stats.calculateStdDev());
+    CHECK_EQ(0.0, stats.getPercentile(99.0));
+}
+
+TEST(PingStatistics, StreamingMomentsMatchTwoPass) {
+    PingStatistics stats(false);
+    std::vector<double> samples;
+    unsigned int seed = 5;
+    for (int i = 0; i < 100000; i++) {
+        seed = seed * 1103515245u + 12345u;
+        double rtt = 10.0 + (seed >> 8) % 10000 / 1000.0;
+        samples.push_back(rtt);
+        stats.addTransmitted();
+        stats.addReceived(rtt);
+    }
+
+    double sum = 0.0;
+    for (size_t i = 0; i < samples.size(); i++) sum += samples[i];
+    double mean = sum / samples.size();
+    double squares = 0.0;
+    for (size_t i = 0; i < samples.size(); i++) squares += (samples[i] - mean) * (samples[i] - mean);
+
+    CHECK_NEAR(mean, stats.getAverageTime(), 1e-9);
+    CHECK_NEAR(std::sqrt(squares / samples.size()), stats.calculateStdDev(), 1e-9);
+    CHECK_EQ(*std::min_element(samples.begin(), samples.end()), stats.getMinTime());
+    CHECK_EQ(*std::max_element(samples.begin(), samples.end()), stats.getMaxTime());
+}
+
+TEST(PingStatistics, PercentilesWithinHistogramError) {
+    PingStatistics stats(false);
+    std::vector<double> samples;
+    for (int i = 1; i <= 100000; i++) {
+        // 0.01 ms to 1 s, log spaced
+        double rtt = 0.01 * std::pow(10.0, 5.0 * i / 100000.0);
+        samples.push_back(rtt);
+        stats.addReceived(rtt);
+    }
+    const double points[] = {1.0, 50.0, 90.0, 99.0, 99.9};
+    for (size_t p = 0; p < sizeof(points) / sizeof(points[0]); p++) {
+        double exact = samples[(size_t)(points[p] / 100.0 * samples.size()) - 1];
+        CHECK_NEAR(exact, stats.getPercentile(points[p]), exact * 0.02);
+    }
+    CHECK(stats.getPercentile(100.0) <= stats.getMaxTime());
+    CHECK_NEAR(stats.getMaxTime(), stats.getPercentile(100.0), stats.getMaxTime() * 0.02);
+}
+
+TEST(PingStatistics, LossAndFailures) {
+    PingStatistics stats(false);
+    for (int i = 0; i < 10; i++) stats.addTransmitted();
+    for (int i = 0; i < 7; i++) stats.addReceived(1.0);
+    stats.addFailure(classifyIcmpError(3, 1));
+    stats.addFailure(classifyIcmpError(11, 0));
+    stats.addError();
+
+    CHECK_EQ(30, stats.getPacketLoss());
+    CHECK_EQ(3, stats.getErrors());
+    CHECK_EQ(2, stats.getTotalFailures());
+    CHECK_EQ(1, stats.getFailures(FAILURE_HOST_UNREACHABLE));
+    CHECK_EQ(1, stats.getFailures(FAILURE_TTL_EXCEEDED));
+    CHECK_EQ(FAILURE_ADMIN_PROHIBITED, classifyIcmpError(3, 13));
+    CHECK_EQ(FAILURE_FRAGMENTATION_NEEDED, classifyIcmpError(3, 4));
+    CHECK_EQ(FAILURE_PARAMETER_PROBLEM, classifyIcmpError(12, 0));
+}
+
+TEST(PingStatistics, MergeEqualsSingleRun) {
+    PingStatistics whole(false);
+    PingStatistics first(false);
+    PingStatistics second(false);
+    for (int i = 0; i < 5000; i++) {
+        double rtt = 1.0 + (i % 97) * 0.25;
+        whole.addTransmitted();
+        whole.addReceived(rtt);
+        PingStatistics& part = i % 3 == 0 ? first : second;
+        part.addTransmitted();
+        part.addReceived(rtt);
+    }
+    first.addFailure(FAILURE_NET_UNREACHABLE);
+    first.merge(second);
+
+    CHECK_EQ(whole.getTransmitted(), first.getTransmitted());
+    CHECK_EQ(whole.getReceived(), first.getReceived());
+    CHECK_EQ(1, first.getFailures(FAILURE_NET_UNREACHABLE));
+    CHECK_NEAR(whole.getAverageTime(), first.getAverageTime(), 1e-9);
+    CHECK_NEAR(whole.calculateStdDev(), first.calculateStdDev(), 1e-9);
+    CHECK_EQ(whole.getMinTime(), first.getMinTime());
+    CHECK_EQ(whole.getMaxTime(), first.getMaxTime());
+    CHECK_EQ(whole.getPercentile(90.0), first.getPercentile(90.0));
+}
+
+TEST(PingStatistics, HistogramMergeAndClear) {
+    RttHistogram a;
+    RttHistogram b;
+    CHECK_EQ(0u, a.getCount());
+    for (int i = 0; i < 1000; i++) {
+        a.record(0.5);
+        b.record(5.0);
+    }
+    a.merge(b);
+    CHECK_EQ(2000u, a.getCount());
+    CHECK_NEAR(0.5, a.percentile(25.0), 0.5 * 0.02);
+    CHECK_NEAR(5.0, a.percentile(75.0), 5.0 * 0.02);
+    a.subtract(b);
+    CHECK_EQ(1000u, a.getCount());
+    CHECK_NEAR(0.5, a.percentile(99.0), 0.5 * 0.02);
+    a.clear();
+    CHECK_EQ(0u, a.getCount());
+}
@@ -0,0 +1,115 @@
+#include "TestHarness.hpp"
+#include "ProbeLog.hpp"
+#include <unistd.h>
+#include <cstdio>
+
+static std::string tempPath(const char* name) {
+    return "/tmp/ping_tests_" + std::to_string(getpid()) + "_" + name;
+}
+
+static SendStamp stampAt(long long ns) {
+    SendStamp stamp;
+    stamp.wall.tv_sec = (time_t)(ns / 1000000000LL);
+    stamp.wall.tv_nsec = (long)(ns % 1000000000LL);
+    stamp.mono = stamp.wall;
+    return stamp;
+}
+
+// Record i of the test pattern: replies, timeouts and failures interleaved
+static void writeRecord(ProbeLog& log, size_t i) {
+    SendStamp sent = stampAt(1700000000000000000LL + (long long)i * 1000);
+    uint32_t target = (uint32_t)(i % 3);
+    if (i % 10 == 7) {
+        log.timeout(target, (int)i, sent);
+    } else if (i % 10 == 9) {
+        log.failure(target, (int)i, sent, FAILURE_HOST_UNREACHABLE);
+    } else {
+        log.reply(target, (int)i, sent, 0.5 + (i % 100) * 0.01, 64);
+    }
+}
+
+static bool recordMatches(const ProbeBlock& block, size_t at, size_t i) {
+    bool ok = block.target[at] == i % 3 && block.seq[at] == i &&
+              block.sendNs[at] == 1700000000000000000LL + (long long)i * 1000;
+    if (i % 10 == 7) {
+        return ok && block.status[at] == PROBE_TIMEOUT;
+    }
+    if (i % 10 == 9) {
+        return ok && block.status[at] == PROBE_FAILURE + FAILURE_HOST_UNREACHABLE;
+    }
+    return ok && block.status[at] == PROBE_REPLY && block.ttl[at] == 64 &&
+           block.rttMs[at] == (float)(0.5 + (i % 100) * 0.01);
+}
+
+TEST(ProbeLog, RoundTripAcrossSegments) {
+    std::string path = tempPath("roundtrip.bin");
+    std::vector<std::string> names;
+    names.push_back("alpha");
+    names.push_back("beta.example");
+    names.push_back("192.0.2.1");
+
+    // More than one segment of blocks, ending in a partial block
+    size_t total = ProbeLog::BLOCK_RECORDS * (ProbeLog::SEGMENT_BLOCKS + 2) + 123;
+    {
+        ProbeLog log;
+        CHECK(log.open(path, names));
+        for (size_t i = 0; i < total; i++) {
+            writeRecord(log, i);
+        }
+        CHECK_EQ(total, log.getRecordCount());
+        log.close();
+    }
+
+    ProbeLogReader reader;
+    CHECK(reader.open(path));
+    CHECK(reader.getTargets() == names);
+    CHECK_EQ(total, reader.getRecordCount());
+    CHECK_EQ(ProbeLog::SEGMENT_BLOCKS + 3, reader.getBlockCount());
+
+    size_t i = 0;
+    size_t mismatches = 0;
+    for (size_t b = 0; b < reader.getBlockCount(); b++) {
+        ProbeBlock block = reader.getBlock(b);
+        for (size_t at = 0; at < block.count; at++, i++) {
+            if (!recordMatches(block, at, i)) mismatches++;
+        }
+    }
+    CHECK_EQ(total, i);
+    CHECK_EQ(0u, mismatches);
+    unlink(path.c_str());
+}
+
+TEST(ProbeLog, ReadableWhileStillOpen) {
+    std::string path = tempPath("open.bin");
+    std::vector<std::string> names(1, "target");
+    ProbeLog log;
+    CHECK(log.open(path, names));
+    for (size_t i = 0; i < 5000; i++) {
+        writeRecord(log, i * 3);    // target 0 only
+    }
+
+    // What a crashed run leaves behind: the header counts every record
+    ProbeLogReader reader;
+    CHECK(reader.open(path));
+    CHECK_EQ(5000u, reader.getRecordCount());
+    CHECK_EQ(2u, reader.getBlockCount());
+    CHECK_EQ(5000u - ProbeLog::BLOCK_RECORDS, reader.getBlock(1).count);
+    log.close();
+    unlink(path.c_str());
+}
+
+TEST(ProbeLog, RejectsOtherFiles) {
+    std::string path = tempPath("notalog.bin");
+    FILE* file = fopen(path.c_str(), "w");
+    CHECK(file != nullptr);
+    if (file != nullptr) {
+        fputs("this is not a probe log\n", file);
+        fclose(file);
+    }
+    std::streambuf* original = std::cerr.rdbuf(nullptr);     // Keep the reason quiet
+    ProbeLogReader reader;
+    bool opened = reader.open(path);
+    std::cerr.rdbuf(original);
+    CHECK(!opened);
+    unlink(path.c_str());
+}
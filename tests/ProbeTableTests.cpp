@@ -0,0 +1,63 @@
+#include "TestHarness.hpp"
+#include "ProbeTable.hpp"
+
+static SendStamp stampAt(long seconds) {
+    SendStamp stamp;
+    stamp.mono.tv_sec = seconds;
+    stamp.mono.tv_nsec = 0;
+    stamp.wall = stamp.mono;
+    return stamp;
+}
+
+TEST(ProbeTable, InsertTakeAndOldest) {
+    ProbeTable table;
+    CHECK(table.empty());
+    for (int seq = 1; seq <= 5; seq++) {
+        table.insert((unsigned short)seq, stampAt(seq));
+    }
+    CHECK_EQ(5, table.size());
+    CHECK(!table.isFree(3));
+
+    SendStamp sent;
+    CHECK(table.take(3, sent));
+    CHECK_EQ(3, sent.mono.tv_sec);
+    CHECK(!table.take(3, sent));    // Duplicate reply
+    CHECK(table.isFree(3));
+
+    unsigned short seq = 0;
+    CHECK(table.oldest(seq, sent));
+    CHECK_EQ(1, seq);
+    table.erase(1);
+    table.erase(2);
+    CHECK(table.oldest(seq, sent));
+    CHECK_EQ(4, seq);                // Skips the answered slot
+    CHECK_EQ(2, table.size());
+}
+
+TEST(ProbeTable, OldestFollowsSequenceWrap) {
+    ProbeTable table;
+    for (int seq = 65530; seq < 65540; seq++) {
+        table.insert((unsigned short)seq, stampAt(seq));
+    }
+    unsigned short seq = 0;
+    SendStamp sent;
+    for (int expected = 65530; expected < 65540; expected++) {
+        CHECK(table.oldest(seq, sent));
+        CHECK_EQ((unsigned short)expected, seq);
+        CHECK_EQ(expected, sent.mono.tv_sec);
+        table.erase(seq);
+    }
+    CHECK(!table.oldest(seq, sent));
+    CHECK(table.empty());
+}
+
+TEST(ProbeTable, ClearForgetsEverything) {
+    ProbeTable table;
+    table.insert(10, stampAt(1));
+    table.insert(11, stampAt(2));
+    table.clear();
+    CHECK(table.empty());
+    CHECK(table.isFree(10));
+    SendStamp sent;
+    CHECK(!table.take(11, sent));
+}
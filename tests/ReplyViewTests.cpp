@@ -0,0 +1,126 @@
+#include "TestHarness.hpp"
+#include "ReplyView.hpp"
+#include "ICMPPacket.hpp"
+#include "Checksum.hpp"
+#include <arpa/inet.h>
+#include <cstring>
+#include <vector>
+
+// An IPv4 header of ipHeaderLength bytes followed by an ICMP message
+static std::vector<char> wrap(const void* icmp, size_t length, int ipHeaderLength,
+                              const char* source, int ttl) {
+    std::vector<char> packet(ipHeaderLength + length, 0);
+    struct iphdr* ip = (struct iphdr*)&packet[0];
+    ip->version = 4;
+    ip->ihl = ipHeaderLength / 4;
+    ip->ttl = (unsigned char)ttl;
+    ip->protocol = IPPROTO_ICMP;
+    ip->tot_len = htons((unsigned short)packet.size());
+    inet_pton(AF_INET, source, &ip->saddr);
+    inet_pton(AF_INET, "192.0.2.10", &ip->daddr);
+    memcpy(&packet[ipHeaderLength], icmp, length);
+    return packet;
+}
+
+// What the target sends back for a probe: the same message as type 0
+static std::vector<char> echoReplyFor(const ICMPPacket& probe, int ipHeaderLength = 20) {
+    std::vector<char> icmp((const char*)probe.getData(), (const char*)probe.getData() + probe.getSize());
+    struct icmphdr* header = (struct icmphdr*)&icmp[0];
+    header->type = ICMP_ECHOREPLY;
+    header->checksum = 0;
+    header->checksum = internetChecksum(&icmp[0], icmp.size());
+    return wrap(&icmp[0], icmp.size(), ipHeaderLength, "192.0.2.10", 57);
+}
+
+TEST(ReplyView, ParsesEchoReply) {
+    ICMPPacket probe;
+    probe.setId(0x1234);
+    probe.build(4321);
+    std::vector<char> packet = echoReplyFor(probe);
+
+    ReplyView view;
+    CHECK(parseReply(&packet[0], (int)packet.size(), view));
+    CHECK_EQ(ICMP_ECHOREPLY, view.type);
+    CHECK_EQ(0x1234, view.id);
+    CHECK_EQ(4321, view.sequence);
+    CHECK_EQ(57, view.ttl);
+    CHECK_EQ(20, view.ipHeaderLength);
+    CHECK_EQ((int)probe.getSize(), view.icmpLength);
+    CHECK_EQ((int)ICMPPacket::DEFAULT_PAYLOAD_SIZE, view.payloadLength);
+    CHECK_EQ(inet_addr("192.0.2.10"), view.source);
+    CHECK(view.checksumValid);
+    CHECK(!view.isError);
+    CHECK(isEchoReplyFor(view, 0x1234));
+    CHECK(!isEchoReplyFor(view, 0x1235));
+}
+
+TEST(ReplyView, SkipsIpOptions) {
+    ICMPPacket probe(100);
+    probe.setId(7);
+    probe.build(9);
+    std::vector<char> packet = echoReplyFor(probe, 60);
+
+    ReplyView view;
+    CHECK(parseReply(&packet[0], (int)packet.size(), view));
+    CHECK_EQ(60, view.ipHeaderLength);
+    CHECK_EQ(9, view.sequence);
+    CHECK(isEchoReplyFor(view, 7));
+}
+
+TEST(ReplyView, RejectsCorruptedReply) {
+    ICMPPacket probe;
+    probe.setId(99);
+    probe.build(1);
+    std::vector<char> packet = echoReplyFor(probe);
+    packet[packet.size() - 1] ^= 0x40;
+
+    ReplyView view;
+    CHECK(parseReply(&packet[0], (int)packet.size(), view));
+    CHECK(!view.checksumValid);
+    CHECK(!isEchoReplyFor(view, 99));
+}
+
+TEST(ReplyView, RejectsTruncatedPackets) {
+    ICMPPacket probe;
+    std::vector<char> packet = echoReplyFor(probe);
+    ReplyView view;
+    CHECK(!parseReply(&packet[0], 10, view));
+    CHECK(!parseReply(&packet[0], 20 + 7, view));
+
+    // An IHL below 5 is malformed whatever the length
+    ((struct iphdr*)&packet[0])->ihl = 4;
+    CHECK(!parseReply(&packet[0], (int)packet.size(), view));
+}
+
+TEST(ReplyView, DecodesQuotedProbeInErrors) {
+    ICMPPacket probe;
+    probe.setId(0x4242);
+    probe.build(77);
+    std::vector<char> sent = wrap(probe.getData(), probe.getSize(), 20, "192.0.2.10", 64);
+    ((struct iphdr*)&sent[0])->daddr = inet_addr("198.51.100.5");
+
+    // Time Exceeded quoting the IP header and first 8 bytes of the probe
+    std::vector<char> icmp(sizeof(struct icmphdr) + 20 + 8, 0);
+    struct icmphdr* header = (struct icmphdr*)&icmp[0];
+    header->type = ICMP_TIME_EXCEEDED;
+    header->code = ICMP_EXC_TTL;
+    memcpy(&icmp[sizeof(struct icmphdr)], &sent[0], 28);
+    header->checksum = internetChecksum(&icmp[0], icmp.size());
+    std::vector<char> packet = wrap(&icmp[0], icmp.size(), 20, "203.0.113.1", 250);
+
+    ReplyView view;
+    CHECK(parseReply(&packet[0], (int)packet.size(), view));
+    CHECK(view.isError);
+    CHECK_EQ(ICMP_TIME_EXCEEDED, view.type);
+    CHECK_EQ(ICMP_ECHO, view.quotedType);
+    CHECK_EQ(0x4242, view.quotedId);
+    CHECK_EQ(77, view.quotedSequence);
+    CHECK_EQ(inet_addr("198.51.100.5"), view.quotedDestination);
+    CHECK_EQ(inet_addr("203.0.113.1"), view.source);
+    CHECK(isErrorFor(view, 0x4242));
+    CHECK(!isErrorFor(view, 0x4243));
+
+    // Too short to hold the quoted ICMP header: still a packet, not an error of ours
+    CHECK(parseReply(&packet[0], (int)packet.size() - 4, view));
+    CHECK(!view.isError);
+}
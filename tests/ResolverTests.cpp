@@ -0,0 +1,145 @@
+#include "TestHarness.hpp"
+#include "Resolver.hpp"
+#include "utils.hpp"
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
+// Offline stand-in for getaddrinfo(): names under the reserved .invalid TLD
+// fail with EAI_NONAME, anything else is 192.0.2.1. Lookups block while
+// the gate is closed, so a test can hold one in flight.
+static std::mutex gateMutex;
+static std::condition_variable gateChanged;
+static bool gateOpen = true;
+
+static void setGate(bool open) {
+    std::lock_guard<std::mutex> lock(gateMutex);
+    gateOpen = open;
+    gateChanged.notify_all();
+}
+
+static bool fakeLookup(const std::string& host, struct in_addr& addr, int& error) {
+    {
+        std::unique_lock<std::mutex> lock(gateMutex);
+        while (!gateOpen) {
+            gateChanged.wait(lock);
+        }
+    }
+    const std::string invalid = ".invalid";
+    if (host.size() >= invalid.size() &&
+        host.compare(host.size() - invalid.size(), invalid.size(), invalid) == 0) {
+        error = EAI_NONAME;
+        return false;
+    }
+    addr.s_addr = inet_addr("192.0.2.1");
+    error = 0;
+    return true;
+}
+
+// Collects completions until count have arrived or the timeout runs out
+static std::vector<Resolution> await(Resolver& resolver, size_t count, double timeoutMs = 5000.0) {
+    std::vector<Resolution> results;
+    Resolution result;
+    for (double waited = 0.0; results.size() < count && waited < timeoutMs; waited += 1.0) {
+        while (results.size() < count && resolver.next(result)) {
+            results.push_back(result);
+        }
+        if (results.size() < count) {
+            sleepMs(1.0);
+        }
+    }
+    return results;
+}
+
+TEST(Resolver, NumericLiteralCompletesAtSubmit) {
+    Resolver resolver;
+    resolver.submit("192.0.2.7", 42);
+
+    Resolution result;
+    CHECK(resolver.next(result));
+    CHECK_EQ((size_t)42, result.tag);
+    CHECK(result.ok);
+    CHECK_EQ(inet_addr("192.0.2.7"), result.addr.s_addr);
+    CHECK_EQ(0.0, result.elapsedMs);
+    CHECK_EQ((size_t)0, resolver.pending());
+    CHECK_EQ((size_t)0, resolver.getLookupCount());
+    CHECK(!resolver.next(result));
+}
+
+TEST(Resolver, LocalhostFromHostsFile) {
+    Resolver resolver;
+    resolver.submit("localhost", 1);
+    CHECK_EQ((size_t)1, resolver.pending());
+
+    std::vector<Resolution> results = await(resolver, 1);
+    CHECK_EQ((size_t)1, results.size());
+    if (results.size() == 1) {
+        CHECK_EQ((size_t)1, results[0].tag);
+        CHECK(results[0].ok);
+        CHECK_EQ(inet_addr("127.0.0.1"), results[0].addr.s_addr);
+    }
+    CHECK_EQ((size_t)0, resolver.pending());
+}
+
+TEST(Resolver, CacheHitCompletesAtSubmit) {
+    Resolver resolver;
+    resolver.submit("localhost", 1);
+    CHECK_EQ((size_t)1, await(resolver, 1).size());
+
+    resolver.submit("localhost", 2);
+    Resolution result;
+    CHECK(resolver.next(result));
+    CHECK_EQ((size_t)2, result.tag);
+    CHECK(result.ok);
+    CHECK_EQ(inet_addr("127.0.0.1"), result.addr.s_addr);
+    CHECK_EQ(0.0, result.elapsedMs);
+    CHECK_EQ((size_t)1, resolver.getLookupCount());
+}
+
+TEST(Resolver, SameNameSharesOneQuery) {
+    Resolver resolver;
+    resolver.setLookupFunction(fakeLookup);
+    setGate(false);
+    resolver.submit("shared.test", 1);
+    // The first lookup is held in flight, so this tag has to ride along
+    resolver.submit("shared.test", 2);
+    CHECK_EQ((size_t)2, resolver.pending());
+    CHECK_EQ((size_t)1, resolver.getLookupCount());
+    setGate(true);
+
+    std::vector<Resolution> results = await(resolver, 2);
+    CHECK_EQ((size_t)2, results.size());
+    if (results.size() == 2) {
+        CHECK(results[0].ok && results[1].ok);
+        CHECK_EQ(inet_addr("192.0.2.1"), results[0].addr.s_addr);
+        CHECK_EQ(results[0].addr.s_addr, results[1].addr.s_addr);
+        CHECK(results[0].tag != results[1].tag);
+        CHECK_EQ(results[0].elapsedMs, results[1].elapsedMs);
+    }
+    CHECK_EQ((size_t)1, resolver.getLookupCount());
+}
+
+TEST(Resolver, FailureCarriesError) {
+    Resolver resolver;
+    resolver.setLookupFunction(fakeLookup);
+    resolver.submit("unreachable.invalid", 7);
+
+    std::vector<Resolution> results = await(resolver, 1);
+    CHECK_EQ((size_t)1, results.size());
+    if (results.size() == 1) {
+        CHECK_EQ((size_t)7, results[0].tag);
+        CHECK(!results[0].ok);
+        CHECK_EQ(EAI_NONAME, results[0].error);
+        CHECK(Resolver::describeError(results[0].error) != nullptr);
+    }
+
+    // The failure is cached as well, without a second query
+    resolver.submit("unreachable.invalid", 8);
+    Resolution result;
+    CHECK(resolver.next(result));
+    CHECK(!result.ok);
+    CHECK_EQ(EAI_NONAME, result.error);
+    CHECK_EQ((size_t)1, resolver.getLookupCount());
+}
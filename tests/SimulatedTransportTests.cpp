@@ -0,0 +1,176 @@
+#include "TestHarness.hpp"
+#include "SimulatedTransport.hpp"
+#include "ICMPPacket.hpp"
+#include "ReplyView.hpp"
+#include <arpa/inet.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <vector>
+
+static const unsigned short TEST_ID = 0x5151;
+
+static struct sockaddr_in destination() {
+    struct sockaddr_in dest;
+    memset(&dest, 0, sizeof(dest));
+    dest.sin_family = AF_INET;
+    dest.sin_addr.s_addr = inet_addr("10.0.0.1");
+    return dest;
+}
+
+// Sends count probes and collects every packet that arrives within waitMs
+// of the last one
+static std::vector<ReplyView> exchange(SimulatedTransport& transport, int count, double waitMs,
+                                       std::vector<char>& storage) {
+    ICMPPacket probe;
+    probe.setId(TEST_ID);
+    struct sockaddr_in dest = destination();
+    for (int seq = 0; seq < count; seq++) {
+        probe.build(seq);
+        transport.send((const char*)probe.getData(), probe.getSize(), dest);
+    }
+
+    const size_t slot = 256;
+    storage.assign(slot * count * 2 + slot, 0);
+    std::vector<ReplyView> views;
+    struct timespec deadline = addMs(monotonicNow(), waitMs);
+    while (views.size() * slot + slot <= storage.size()) {
+        double remaining = elapsedMs(monotonicNow(), deadline);
+        if (remaining <= 0.0 || transport.wait(remaining) <= 0) {
+            break;
+        }
+        RecvStamp stamp;
+        char* buffer = &storage[views.size() * slot];
+        int length;
+        while ((length = transport.receive(buffer, slot, nullptr, stamp)) > 0) {
+            ReplyView view;
+            if (parseReply(buffer, length, view)) {
+                views.push_back(view);
+            }
+            buffer = &storage[views.size() * slot];
+        }
+    }
+    return views;
+}
+
+TEST(SimulatedTransport, ParsesSpecifications) {
+    SimulationConfig config;
+    std::string error;
+    CHECK(parseSimulation("dist=normal,latency=20,jitter=5,loss=0.01,seed=9", config, error));
+    CHECK_EQ(LATENCY_NORMAL, config.model);
+    CHECK_EQ(20.0, config.latencyMs);
+    CHECK_EQ(5.0, config.jitterMs);
+    CHECK_EQ(0.01, config.lossRate);
+    CHECK_EQ(9u, config.seed);
+
+    CHECK(!parseSimulation("loss=1.5", config, error));
+    CHECK(error.find("loss") != std::string::npos);
+    CHECK(!parseSimulation("colour=blue", config, error));
+    CHECK(error.find("colour") != std::string::npos);
+    CHECK(!parseSimulation("dist=gamma", config, error));
+}
+
+TEST(SimulatedTransport, EchoesWithValidReplies) {
+    SimulationConfig config;
+    config.replyTtl = 42;
+    SimulatedTransport transport(config);
+    CHECK(transport.open(TEST_ID, 2048, 0));
+    CHECK_EQ(-1, transport.getFd());
+
+    std::vector<char> storage;
+    std::vector<ReplyView> replies = exchange(transport, 100, 50.0, storage);
+    CHECK_EQ(100u, replies.size());
+    for (size_t i = 0; i < replies.size(); i++) {
+        CHECK(isEchoReplyFor(replies[i], TEST_ID));
+        CHECK_EQ(i, replies[i].sequence);       // Fixed latency keeps send order
+        CHECK_EQ(42, replies[i].ttl);
+        CHECK_EQ(inet_addr("10.0.0.1"), replies[i].source);
+    }
+    CHECK_EQ(100u, transport.getDelivered());
+
+    // Nothing left: receive reports EAGAIN like a non-blocking socket
+    RecvStamp stamp;
+    char buffer[256];
+    CHECK_EQ(-1, transport.receive(buffer, sizeof(buffer), nullptr, stamp));
+    CHECK_EQ(EAGAIN, errno);
+}
+
+TEST(SimulatedTransport, ReplyArrivesAfterLatency) {
+    SimulationConfig config;
+    config.latencyMs = 3.0;
+    SimulatedTransport transport(config);
+    transport.open(TEST_ID, 2048, 0);
+
+    ICMPPacket probe;
+    probe.setId(TEST_ID);
+    probe.build(1);
+    struct sockaddr_in dest = destination();
+    struct timespec sent = monotonicNow();
+    transport.send((const char*)probe.getData(), probe.getSize(), dest);
+
+    char buffer[256];
+    RecvStamp stamp;
+    CHECK_EQ(-1, transport.receive(buffer, sizeof(buffer), nullptr, stamp));
+    CHECK_EQ(1, transport.wait(100.0));
+    CHECK(transport.receive(buffer, sizeof(buffer), nullptr, stamp) > 0);
+    double rtt = elapsedMs(sent, stamp.mono);
+    CHECK(rtt >= 3.0);
+    CHECK(rtt < 3.5);
+    // Stamped with its scheduled arrival, not when receive() ran
+    CHECK(elapsedMs(stamp.mono, monotonicNow()) >= 0.0);
+}
+
+TEST(SimulatedTransport, InjectsErrorsQuotingTheProbe) {
+    SimulationConfig config;
+    config.errorRate = 1.0;
+    config.errorCode = 3;
+    SimulatedTransport transport(config);
+    transport.open(TEST_ID, 2048, 0);
+
+    std::vector<char> storage;
+    std::vector<ReplyView> replies = exchange(transport, 10, 50.0, storage);
+    CHECK_EQ(10u, replies.size());
+    for (size_t i = 0; i < replies.size(); i++) {
+        CHECK(isErrorFor(replies[i], TEST_ID));
+        CHECK_EQ(ICMP_DEST_UNREACH, replies[i].type);
+        CHECK_EQ(3, replies[i].code);
+        CHECK_EQ(i, replies[i].quotedSequence);
+        CHECK_EQ(inet_addr("10.0.0.1"), replies[i].quotedDestination);
+        CHECK_EQ(htonl(SimulatedTransport::ROUTER_ADDRESS), replies[i].source);
+    }
+    CHECK_EQ(10u, transport.getErrors());
+}
+
+TEST(SimulatedTransport, FaultRatesAndDeterminism) {
+    SimulationConfig config;
+    config.lossRate = 0.1;
+    config.duplicateRate = 0.05;
+    config.reorderRate = 0.05;
+    config.reorderDelayMs = 0.2;
+    config.seed = 1234;
+
+    std::vector<unsigned short> order[2];
+    for (int run = 0; run < 2; run++) {
+        SimulatedTransport transport(config);
+        transport.open(TEST_ID, 2048, 0);
+        std::vector<char> storage;
+        std::vector<ReplyView> replies = exchange(transport, 4000, 20.0, storage);
+        for (size_t i = 0; i < replies.size(); i++) {
+            order[run].push_back(replies[i].sequence);
+        }
+
+        CHECK_EQ(4000u, transport.getRequests());
+        CHECK_NEAR(400, transport.getDropped(), 80);
+        CHECK(transport.getDuplicated() > 100);
+        CHECK(transport.getReordered() > 100);
+        CHECK_EQ(transport.getRequests() - transport.getDropped() + transport.getDuplicated(),
+                 transport.getDelivered());
+    }
+    // Loss and duplication depend only on the seed; arrival order also on timing
+    std::vector<unsigned short> sorted[2];
+    for (int run = 0; run < 2; run++) {
+        sorted[run] = order[run];
+        std::sort(sorted[run].begin(), sorted[run].end());
+    }
+    CHECK(sorted[0] == sorted[1]);
+}
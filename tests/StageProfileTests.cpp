@@ -0,0 +1,99 @@
+#include "TestHarness.hpp"
+#include "StageProfile.hpp"
+#include "PingClient.hpp"
+
+TEST(StageProfile, DisabledRecordsNothing) {
+    StageProfile profile;
+    CHECK(!profile.isEnabled());
+    CHECK_EQ(0, profile.mark());
+    profile.record(STAGE_SEND, 1000);
+    CHECK_EQ(0u, profile.getCount(STAGE_SEND));
+    CHECK_EQ(0.0, profile.getPercentileUs(STAGE_SEND, 50.0));
+}
+
+TEST(StageProfile, PercentilesInMicroseconds) {
+    StageProfile profile;
+    profile.enable();
+    for (long long ns = 1; ns <= 10000; ns++) {
+        profile.record(STAGE_PARSE, ns);
+    }
+    CHECK_EQ(10000u, profile.getCount(STAGE_PARSE));
+    CHECK_EQ(0u, profile.getCount(STAGE_REPORT));
+    CHECK_NEAR(5.0, profile.getPercentileUs(STAGE_PARSE, 50.0), 5.0 * 0.02);
+    CHECK_NEAR(9.9, profile.getPercentileUs(STAGE_PARSE, 99.0), 9.9 * 0.02);
+    CHECK_EQ(10.0, profile.getMaxUs(STAGE_PARSE));
+    CHECK(profile.getPercentileUs(STAGE_PARSE, 100.0) <= profile.getMaxUs(STAGE_PARSE));
+}
+
+TEST(StageProfile, ClampsClockSteps) {
+    StageProfile profile;
+    profile.enable();
+    profile.record(STAGE_WAKEUP, -250);
+    CHECK_EQ(1u, profile.getCount(STAGE_WAKEUP));
+    CHECK_EQ(0.0, profile.getMaxUs(STAGE_WAKEUP));
+}
+
+static PingOptions profiledOptions() {
+    PingOptions options;
+    options.backend = BACKEND_SIMULATED;
+    options.timeoutMs = 50.0;
+    options.intervalMs = 0.0;
+    options.simulation.latencyMs = 0.02;
+    options.profileStages = true;
+    return options;
+}
+
+// The report goes to stdout at every output level; keep it out of the test log
+static void runQuietly(PingClient& client, int count) {
+    std::streambuf* original = std::cout.rdbuf(nullptr);
+    client.run(count);
+    std::cout.rdbuf(original);
+}
+
+TEST(StageProfile, StopAndWaitProfilesEveryReply) {
+    PingClient client("10.0.0.1", profiledOptions());
+    CHECK(client.initialize());
+    runQuietly(client, 200);
+
+    const StageProfile& profile = client.getStageProfile();
+    CHECK_EQ(200, client.getStatistics().getReceived());
+    for (int i = 0; i < STAGE_COUNT; i++) {
+        CHECK_EQ(200u, profile.getCount((ProbeStage)i));
+    }
+    // The simulated network delivers on time; the wakeup is the loop's own delay
+    CHECK(profile.getPercentileUs(STAGE_WAKEUP, 50.0) < 20000.0);
+}
+
+TEST(StageProfile, FloodProfilesBatchesAndReplies) {
+    PingOptions options = profiledOptions();
+    options.flood = true;
+    PingClient client("10.0.0.1", options);
+    CHECK(client.initialize());
+    runQuietly(client, 5000);
+
+    const StageProfile& profile = client.getStageProfile();
+    unsigned long long received = (unsigned long long)client.getStatistics().getReceived();
+    CHECK_EQ(5000u, received);
+    CHECK_EQ(received, profile.getCount(STAGE_WAKEUP));
+    CHECK_EQ(received, profile.getCount(STAGE_PARSE));
+    CHECK_EQ(received, profile.getCount(STAGE_REPORT));
+
+    // One sample per sendmmsg()/recvmmsg() call
+    CHECK(profile.getCount(STAGE_SEND) > 0);
+    CHECK(profile.getCount(STAGE_SEND) < received);
+    CHECK_EQ(profile.getCount(STAGE_SEND), profile.getCount(STAGE_BUILD));
+    CHECK(profile.getCount(STAGE_RECEIVE) < received);
+}
+
+TEST(StageProfile, OffByDefault) {
+    PingOptions options = profiledOptions();
+    options.profileStages = false;
+    PingClient client("10.0.0.1", options);
+    CHECK(client.initialize());
+    runQuietly(client, 50);
+
+    CHECK_EQ(50, client.getStatistics().getReceived());
+    for (int i = 0; i < STAGE_COUNT; i++) {
+        CHECK_EQ(0u, client.getStageProfile().getCount((ProbeStage)i));
+    }
+}
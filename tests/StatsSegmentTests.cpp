@@ -0,0 +1,178 @@
+#include "TestHarness.hpp"
+#include "StatsSegment.hpp"
+#include "PingClient.hpp"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <cstring>
+
+static std::string segmentName(const char* name) {
+    return "ping_tests_" + std::to_string(getpid()) + "_" + name;
+}
+
+// A segment as another process would have left it: the given version,
+// written by pid
+static void plantSegment(const std::string& name, uint32_t version, int64_t pid) {
+    std::string path = StatsSegment::normalizeName(name);
+    int fd = shm_open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    CHECK(fd >= 0);
+    CHECK_EQ(0, ftruncate(fd, sizeof(StatsSegmentHeader)));
+    void* mapped = mmap(nullptr, sizeof(StatsSegmentHeader), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    CHECK(mapped != MAP_FAILED);
+    StatsSegmentHeader* header = (StatsSegmentHeader*)mapped;
+    memcpy(header->magic, "PINGSTAT", 8);
+    header->pid = pid;
+    header->version.store(version);
+    munmap(mapped, sizeof(StatsSegmentHeader));
+    close(fd);
+}
+
+TEST(StatsSegment, RoundTrip) {
+    std::string name = segmentName("roundtrip");
+    std::vector<std::string> targets;
+    targets.push_back("alpha");
+    targets.push_back("beta.example");
+
+    PingStatistics stats(false);
+    for (int i = 1; i <= 1000; i++) {
+        stats.addTransmitted();
+        if (i % 10 == 0) {
+            stats.addError();
+        } else if (i % 25 == 1) {
+            stats.addFailure(FAILURE_HOST_UNREACHABLE);
+        } else {
+            stats.addReceived(i * 0.01);
+        }
+    }
+
+    StatsSegment segment;
+    CHECK(segment.open(name, targets));
+    CHECK_EQ(2u, segment.getSlotCount());
+    segment.publish(1, stats, htonl(0xC0000201));
+
+    StatsSegmentReader reader;
+    CHECK(reader.open(name));
+    CHECK_EQ(2u, reader.getSlotCount());
+    CHECK_EQ((int64_t)getpid(), reader.getWriterPid());
+    CHECK(reader.isWriterAlive());
+
+    StatsSnapshot idle;
+    CHECK(reader.snapshot(0, idle));
+    CHECK(idle.name == "alpha");
+    CHECK_EQ(0u, idle.address);
+    CHECK_EQ(0u, idle.updatedNs);
+    CHECK_EQ(0u, idle.transmitted);
+    CHECK_EQ(0u, idle.histogram.getCount());
+
+    StatsSnapshot live;
+    CHECK(reader.snapshot(1, live));
+    CHECK(live.name == "beta.example");
+    CHECK_EQ(htonl(0xC0000201), live.address);
+    CHECK(live.updatedNs > 0);
+    CHECK_EQ((uint64_t)stats.getTransmitted(), live.transmitted);
+    CHECK_EQ((uint64_t)stats.getReceived(), live.received);
+    CHECK_EQ((uint64_t)stats.getErrors(), live.errors);
+    CHECK_EQ((uint64_t)stats.getFailures(FAILURE_HOST_UNREACHABLE),
+             live.failures[FAILURE_HOST_UNREACHABLE]);
+    CHECK_EQ(stats.getMinTime(), live.minMs);
+    CHECK_EQ(stats.getMaxTime(), live.maxMs);
+    CHECK_EQ(stats.getAverageTime(), live.meanMs);
+    CHECK_EQ(stats.calculateStdDev(), live.stddevMs);
+    CHECK_EQ(stats.getHistogram().getCount(), live.histogram.getCount());
+    CHECK_EQ(stats.getHistogram().percentile(50.0), live.histogram.percentile(50.0));
+    CHECK_EQ(stats.getHistogram().percentile(99.9), live.histogram.percentile(99.9));
+
+    // A later publish only rewrites the buckets between min and max
+    stats.addTransmitted();
+    stats.addReceived(5.0);
+    segment.publish(1, stats, htonl(0xC0000201));
+    CHECK(reader.snapshot(1, live));
+    CHECK_EQ(stats.getHistogram().getCount(), live.histogram.getCount());
+    CHECK_EQ(stats.getHistogram().percentile(99.0), live.histogram.percentile(99.0));
+}
+
+TEST(StatsSegment, CloseUnlinks) {
+    std::string name = segmentName("unlink");
+    StatsSegment segment;
+    CHECK(segment.open(name, std::vector<std::string>(1, "alpha")));
+    StatsSegmentReader early;
+    CHECK(early.open(name));
+    segment.close();
+
+    // Mapped readers keep the last values; new readers find nothing
+    StatsSnapshot snapshot;
+    CHECK(early.snapshot(0, snapshot));
+    std::streambuf* original = std::cerr.rdbuf(nullptr);
+    StatsSegmentReader late;
+    CHECK(!late.open(name));
+    std::cerr.rdbuf(original);
+}
+
+TEST(StatsSegment, RejectsOtherVersions) {
+    std::string name = segmentName("version");
+    std::streambuf* original = std::cerr.rdbuf(nullptr);
+
+    plantSegment(name, StatsSegment::VERSION + 1, getpid());
+    StatsSegmentReader newer;
+    CHECK(!newer.open(name));
+
+    plantSegment(name, 0, getpid());
+    StatsSegmentReader unfinished;
+    CHECK(!unfinished.open(name));
+
+    std::cerr.rdbuf(original);
+    shm_unlink(StatsSegment::normalizeName(name).c_str());
+}
+
+TEST(StatsSegment, ReplacesOnlyStaleSegments) {
+    std::string name = segmentName("stale");
+    std::vector<std::string> targets(1, "alpha");
+    std::streambuf* original = std::cout.rdbuf(nullptr);
+
+    // Our own pid is alive, so the segment is in use
+    plantSegment(name, StatsSegment::VERSION, getpid());
+    StatsSegment busy;
+    CHECK(!busy.open(name, targets));
+
+    // No process has pid 0
+    plantSegment(name, StatsSegment::VERSION, 0);
+    StatsSegment replacing;
+    CHECK(replacing.open(name, targets));
+
+    std::cout.rdbuf(original);
+    StatsSegmentReader reader;
+    CHECK(reader.open(name));
+    CHECK_EQ((int64_t)getpid(), reader.getWriterPid());
+}
+
+TEST(StatsSegment, ClientPublishesItsRun) {
+    PingOptions options;
+    options.backend = BACKEND_SIMULATED;
+    options.timeoutMs = 50.0;
+    options.intervalMs = 0.0;
+    options.window = 16;
+    options.simulation.latencyMs = 0.02;
+    options.simulation.lossRate = 0.05;
+    options.statsSegmentName = segmentName("client");
+
+    PingClient client("10.0.0.1", options);
+    CHECK(client.initialize());
+    std::streambuf* original = std::cout.rdbuf(nullptr);
+    client.run(2000);
+    std::cout.rdbuf(original);
+
+    // The final publish matches the run's own statistics
+    StatsSegmentReader reader;
+    CHECK(reader.open(options.statsSegmentName));
+    StatsSnapshot snapshot;
+    CHECK(reader.snapshot(0, snapshot));
+    const PingStatistics& stats = client.getStatistics();
+    CHECK(snapshot.name == "10.0.0.1");
+    CHECK_EQ(inet_addr("10.0.0.1"), snapshot.address);
+    CHECK_EQ(2000u, snapshot.transmitted);
+    CHECK_EQ((uint64_t)stats.getReceived(), snapshot.received);
+    CHECK_EQ((uint64_t)stats.getErrors(), snapshot.errors);
+    CHECK(snapshot.received > 0 && snapshot.errors > 0);
+    CHECK_EQ(snapshot.received, snapshot.histogram.getCount());
+    CHECK_EQ(stats.getMaxTime(), snapshot.maxMs);
+}
@@ -0,0 +1,67 @@
+#ifndef TEST_HARNESS_HPP
+#define TEST_HARNESS_HPP
+
+#include <cmath>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Just enough of a unit test framework to keep the build free of external
+// dependencies. TEST(Suite, Name) registers a function at static
+// initialization; the CHECK macros report the failing expression and line
+// and mark the running test failed without stopping it.
+namespace test {
+
+typedef void (*TestFunction)();
+
+struct TestCase {
+    std::string name;       // "Suite.Name"
+    TestFunction function;
+};
+
+std::vector<TestCase>& registry();
+void fail(const char* file, int line, const std::string& message);
+
+struct Registrar {
+    Registrar(const char* name, TestFunction function) {
+        TestCase test;
+        test.name = name;
+        test.function = function;
+        registry().push_back(test);
+    }
+};
+
+}  // namespace test
+
+#define TEST(suite, name)                                                           \
+    static void suite##_##name();                                                   \
+    static test::Registrar suite##_##name##_registrar(#suite "." #name, suite##_##name); \
+    static void suite##_##name()
+
+#define CHECK(condition)                                                            \
+    do {                                                                            \
+        if (!(condition)) test::fail(__FILE__, __LINE__, "CHECK(" #condition ")");  \
+    } while (0)
+
+#define CHECK_EQ(expected, actual)                                                  \
+    do {                                                                            \
+        if (!((expected) == (actual))) {                                            \
+            std::ostringstream message_;                                            \
+            message_ << "CHECK_EQ(" #expected ", " #actual "): " << (expected)      \
+                     << " != " << (actual);                                         \
+            test::fail(__FILE__, __LINE__, message_.str());                         \
+        }                                                                           \
+    } while (0)
+
+#define CHECK_NEAR(expected, actual, tolerance)                                     \
+    do {                                                                            \
+        if (!(std::fabs((double)(expected) - (double)(actual)) <= (tolerance))) {   \
+            std::ostringstream message_;                                            \
+            message_ << "CHECK_NEAR(" #expected ", " #actual "): " << (expected)    \
+                     << " vs " << (actual) << " (tolerance " << (tolerance) << ")"; \
+            test::fail(__FILE__, __LINE__, message_.str());                         \
+        }                                                                           \
+    } while (0)
+
+#endif
@@ -0,0 +1,53 @@
+// ping_tests: runs every registered test, or those whose name starts with
+// the first argument (ctest runs one suite per entry)
+
+#include "TestHarness.hpp"
+#include "Output.hpp"
+#include <cstring>
+
+namespace test {
+
+static bool currentFailed = false;
+
+std::vector<TestCase>& registry() {
+    static std::vector<TestCase> tests;
+    return tests;
+}
+
+void fail(const char* file, int line, const std::string& message) {
+    std::cout << "    " << file << ":" << line << ": " << message << std::endl;
+    currentFailed = true;
+}
+
+}  // namespace test
+
+int main(int argc, char* argv[]) {
+    const char* prefix = argc > 1 ? argv[1] : "";
+    // The code under test reports through the same output levels as ping
+    Output::level = OUTPUT_QUIET;
+
+    int run = 0;
+    int failed = 0;
+    std::vector<test::TestCase>& tests = test::registry();
+    for (size_t i = 0; i < tests.size(); i++) {
+        if (strncmp(tests[i].name.c_str(), prefix, strlen(prefix)) != 0) {
+            continue;
+        }
+        test::currentFailed = false;
+        tests[i].function();
+        run++;
+        if (test::currentFailed) {
+            failed++;
+            std::cout << "[FAILED] " << tests[i].name << std::endl;
+        } else {
+            std::cout << "[SUCCESS] " << tests[i].name << std::endl;
+        }
+    }
+
+    if (run == 0) {
+        std::cout << "[ERROR] No tests match \"" << prefix << "\"" << std::endl;
+        return 1;
+    }
+    std::cout << run - failed << " of " << run << " tests passed" << std::endl;
+    return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,75 @@
+#include "TestHarness.hpp"
+#include "TimingWheel.hpp"
+#include "Timestamp.hpp"
+#include <algorithm>
+#include <vector>
+
+TEST(TimingWheel, FiresInOrderNeverEarly) {
+    struct timespec origin = {1000, 0};
+    TimingWheel wheel(1.0);
+    wheel.start(origin);
+
+    // Spread over every level: 1 ms to ~4.6 hours
+    std::vector<double> delays;
+    for (double ms = 1.0; ms < 2e7; ms *= 1.7) {
+        delays.push_back(ms);
+    }
+    for (size_t i = 0; i < delays.size(); i++) {
+        wheel.schedule(addMs(origin, delays[i]), i);
+    }
+    CHECK_EQ(delays.size(), wheel.size());
+
+    std::vector<unsigned long long> expired;
+    size_t fired = 0;
+    while (wheel.size() > 0) {
+        struct timespec next;
+        CHECK(wheel.nextExpiry(next));
+        wheel.advance(next, expired);
+        for (; fired < expired.size(); fired++) {
+            double firedAt = elapsedMs(origin, next);
+            double due = delays[expired[fired]];
+            CHECK(firedAt >= due);
+            CHECK(firedAt <= due + wheel.getTickMs());
+        }
+    }
+    CHECK_EQ(delays.size(), expired.size());
+    CHECK(std::is_sorted(expired.begin(), expired.end()));
+}
+
+TEST(TimingWheel, CancelledTimersDoNotFire) {
+    struct timespec origin = {50, 0};
+    TimingWheel wheel(0.1);
+    wheel.start(origin);
+
+    std::vector<TimingWheel::TimerId> ids;
+    for (int i = 0; i < 1000; i++) {
+        ids.push_back(wheel.schedule(addMs(origin, 1.0 + i * 0.37), i));
+    }
+    for (int i = 0; i < 1000; i += 2) {
+        wheel.cancel(ids[i]);
+    }
+    CHECK_EQ(500u, wheel.size());
+
+    std::vector<unsigned long long> expired;
+    wheel.advance(addMs(origin, 1000.0), expired);
+    CHECK_EQ(500u, expired.size());
+    for (size_t i = 0; i < expired.size(); i++) {
+        CHECK(expired[i] % 2 == 1);
+    }
+    struct timespec next;
+    CHECK(!wheel.nextExpiry(next));
+}
+
+TEST(TimingWheel, PastDeadlinesFireOnNextAdvance) {
+    struct timespec origin = {10, 0};
+    TimingWheel wheel(1.0);
+    wheel.start(origin);
+    std::vector<unsigned long long> expired;
+    wheel.advance(addMs(origin, 100.0), expired);
+    CHECK(expired.empty());
+
+    wheel.schedule(origin, 42);
+    wheel.advance(addMs(origin, 101.0), expired);
+    CHECK_EQ(1u, expired.size());
+    CHECK_EQ(42u, expired[0]);
+}
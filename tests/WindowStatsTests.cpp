@@ -0,0 +1,119 @@
+#include "TestHarness.hpp"
+#include "WindowStats.hpp"
+#include "PingClient.hpp"
+
+static struct timespec atSecond(long long second) {
+    struct timespec ts;
+    ts.tv_sec = (time_t)second;
+    ts.tv_nsec = 500000000L;
+    return ts;
+}
+
+TEST(WindowStats, SummarizesEachWindow) {
+    WindowStats windows;
+    windows.advance(atSecond(1000));
+    for (int i = 1; i <= 100; i++) {
+        windows.addReply(i * 0.1);
+    }
+    windows.addLoss();
+
+    for (int w = 0; w < windows.getWindowCount(); w++) {
+        WindowSummary summary = windows.summarize(w);
+        CHECK_EQ(100u, summary.answered);
+        CHECK_EQ(1u, summary.lost);
+        CHECK_NEAR(100.0 / 101.0, summary.lossPercent, 1e-9);
+        CHECK_NEAR(0.1, summary.minTime, 1e-9);
+        CHECK_NEAR(5.05, summary.avgTime, 1e-9);
+        CHECK_NEAR(10.0, summary.maxTime, 1e-9);
+        CHECK_NEAR(9.9, summary.p99Time, 9.9 * 0.02);
+    }
+    CHECK_EQ(10, windows.summarize(0).seconds);
+    CHECK_EQ(60, windows.summarize(1).seconds);
+    CHECK_EQ(300, windows.summarize(2).seconds);
+}
+
+TEST(WindowStats, OldSecondsSlideOut) {
+    WindowStats windows;
+    windows.advance(atSecond(1000));
+    windows.addReply(50.0);                 // Only ever inside the 1 min and 5 min windows
+    windows.advance(atSecond(1005));
+    windows.addReply(1.0);
+    windows.addLoss();
+
+    // Second 1009 is the tenth second of the short window, 1010 drops 1000
+    windows.advance(atSecond(1009));
+    CHECK_EQ(2u, windows.summarize(0).answered);
+    windows.advance(atSecond(1010));
+    WindowSummary shortWindow = windows.summarize(0);
+    CHECK_EQ(1u, shortWindow.answered);
+    CHECK_EQ(1u, shortWindow.lost);
+    CHECK_EQ(1.0, shortWindow.maxTime);
+    CHECK_NEAR(1.0, shortWindow.p99Time, 0.02);
+    CHECK_EQ(50.0, windows.summarize(1).maxTime);
+
+    windows.advance(atSecond(1065));
+    CHECK_EQ(0u, windows.summarize(0).answered + windows.summarize(0).lost);
+    CHECK_EQ(0u, windows.summarize(1).answered + windows.summarize(1).lost);
+    WindowSummary longWindow = windows.summarize(2);
+    CHECK_EQ(2u, longWindow.answered);
+    CHECK_NEAR(25.5, longWindow.avgTime, 1e-9);
+
+    windows.advance(atSecond(1299));
+    CHECK_EQ(2u, windows.summarize(2).answered);
+    windows.advance(atSecond(1300));
+    CHECK_EQ(1u, windows.summarize(2).answered);
+    CHECK_EQ(1.0, windows.summarize(2).minTime);
+}
+
+TEST(WindowStats, RingReuseKeepsTotalsExact) {
+    // Ten minutes of traffic, one reply and every third second a loss,
+    // wraps the ring twice; every window must hold exactly its own seconds
+    WindowStats windows;
+    for (long long second = 5; second < 605; second++) {
+        windows.advance(atSecond(second));
+        windows.addReply((double)(second % 7 + 1));
+        if (second % 3 == 0) windows.addLoss();
+    }
+    CHECK_EQ(10u, windows.summarize(0).answered);
+    CHECK_EQ(60u, windows.summarize(1).answered);
+    CHECK_EQ(300u, windows.summarize(2).answered);
+    CHECK_EQ(100u, windows.summarize(2).lost);
+    CHECK_EQ(1.0, windows.summarize(2).minTime);
+    CHECK_EQ(7.0, windows.summarize(2).maxTime);
+}
+
+TEST(WindowStats, LongStallClearsEverything) {
+    WindowStats windows;
+    windows.advance(atSecond(3));
+    windows.addReply(2.0);
+    windows.advance(atSecond(3 + WindowStats::RING_SECONDS + 50));
+    for (int w = 0; w < windows.getWindowCount(); w++) {
+        CHECK_EQ(0u, windows.summarize(w).answered);
+    }
+    windows.addReply(4.0);
+    CHECK_EQ(4.0, windows.summarize(0).minTime);
+}
+
+TEST(WindowStats, BoundedDaemonRunFeedsWindows) {
+    PingOptions options;
+    options.backend = BACKEND_SIMULATED;
+    options.simulation.latencyMs = 0.02;
+    options.simulation.lossRate = 0.1;
+    options.simulation.seed = 3;
+    options.timeoutMs = 5.0;
+    options.window = 16;
+    options.summaryIntervalMs = 20.0;
+    PingClient client("10.0.0.1", options);
+    CHECK(client.initialize());
+
+    std::streambuf* original = std::cout.rdbuf(nullptr);
+    client.run(2000);
+    std::cout.rdbuf(original);
+
+    const PingStatistics& stats = client.getStatistics();
+    WindowSummary summary = client.getWindowStats().summarize(2);
+    CHECK_EQ(2000, stats.getTransmitted());
+    CHECK_EQ((unsigned long long)stats.getReceived(), summary.answered);
+    CHECK_EQ(2000u, summary.answered + summary.lost);
+    CHECK(summary.lost > 100 && summary.lost < 300);
+}
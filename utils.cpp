@@ -1,9 +1,11 @@
 #include "utils.hpp"
 #include <iostream>
 #include <iomanip>
-#include <sstream>
+#include <cstdio>
 #include <sys/time.h>
 #include <unistd.h>
+#include <cerrno>
+#include <time.h>
 
 void printSeparator(char c, int width) {
     std::cout << std::string(width, c) << std::endl;
@@ -34,12 +36,34 @@ void printInfo(const std::string& label, double value, int labelWidth, int preci
               << std::fixed << std::setprecision(precision) << value << std::endl;
 }
 
+void sleepMs(double ms) {
+    if (ms <= 0.0) return;
+    struct timespec ts;
+    ts.tv_sec = (time_t)(ms / 1000.0);
+    ts.tv_nsec = (long)((ms - ts.tv_sec * 1000.0) * 1000000.0);
+    while (nanosleep(&ts, &ts) < 0 && errno == EINTR) {
+    }
+}
+
+// snprintf rather than stringstream: these sit on per-packet paths
 std::string getTimestamp() {
     struct timeval tv;
     gettimeofday(&tv, nullptr);
-    std::stringstream ss;
-    ss << tv.tv_sec << "." << std::setfill('0') << std::setw(6) << tv.tv_usec << std::setfill(' '); // Reset fill
-    return ss.str();
+    char text[32];
+    snprintf(text, sizeof(text), "%ld.%06ld", (long)tv.tv_sec, (long)tv.tv_usec);
+    return text;
+}
+
+std::string formatTimespec(const struct timespec& ts) {
+    char text[32];
+    snprintf(text, sizeof(text), "%ld.%09ld", (long)ts.tv_sec, (long)ts.tv_nsec);
+    return text;
+}
+
+std::string formatDouble(double value, int precision) {
+    char text[64];
+    snprintf(text, sizeof(text), "%.*f", precision, value);
+    return text;
 }
 
 std::string getIcmpTypeName(int type) {
@@ -49,6 +73,7 @@ std::string getIcmpTypeName(int type) {
         case 5: return "Redirect";
         case 8: return "Echo Request";
         case 11: return "Time Exceeded";
+        case 12: return "Parameter Problem";
         default: return "Unknown";
     }
 }
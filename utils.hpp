@@ -2,6 +2,7 @@
 #define UTILS_HPP
 
 #include <string>
+#include <time.h>
 
 void printSeparator(char c = '=', int width = 80);
 void printHeader(const std::string& title);
@@ -9,7 +10,10 @@ void printSection(const std::string& title);
 void printInfo(const std::string& label, const std::string& value, int labelWidth = 25);
 void printInfo(const std::string& label, int value, int labelWidth = 25);
 void printInfo(const std::string& label, double value, int labelWidth = 25, int precision = 3);
+void sleepMs(double ms);
 std::string getTimestamp();
+std::string formatTimespec(const struct timespec& ts);
+std::string formatDouble(double value, int precision = 3);
 std::string getIcmpTypeName(int type);
 
 #endif